@@ -0,0 +1,72 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include "../headers/benchmark.h"
+using namespace std;
+
+//Counting replacement of the global operator new, for the benchmark build only (the "build benchmarks"
+//task links this file into bin/bench; the window and the other modes are built without it).
+//Relaxed: only the total is read, between runs.
+atomic<long long> allocations(0);
+
+long long countedAllocations(){
+    return allocations.load(memory_order_relaxed);
+}
+
+//Registers the counter with allocationCount() before main runs
+struct AllocationCounterHook{
+    AllocationCounterHook(){
+        allocationCounter = countedAllocations;
+    }
+};
+AllocationCounterHook allocationCounterHook;
+
+void* operator new(size_t size){
+    allocations.fetch_add(1, memory_order_relaxed);
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == nullptr){
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+//Over-aligned types (alignas above 16, like the ring buffer indices) come here instead
+void* operator new(size_t size, align_val_t alignment){
+    allocations.fetch_add(1, memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    if (align < sizeof(void*)){
+        align = sizeof(void*);
+    }
+#ifdef _WIN32
+    void* memory = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+    void* memory = nullptr;
+    if (posix_memalign(&memory, align, size == 0 ? 1 : size) != 0){
+        memory = nullptr;
+    }
+#endif
+    if (memory == nullptr){
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+void operator delete(void* memory) noexcept{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept{
+    free(memory);
+}
+
+void operator delete(void* memory, align_val_t) noexcept{
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    free(memory);
+#endif
+}
+
+void operator delete(void* memory, size_t, align_val_t alignment) noexcept{
+    operator delete(memory, alignment);
+}
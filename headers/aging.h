@@ -0,0 +1,66 @@
+#ifndef AGING_H
+#define AGING_H
+#include <string>
+#include <vector>
+using namespace std;
+
+class Simulation;
+class DriveCycle;
+
+//Settings of a multi-year aging run. A day is: the battery is charged overnight, the vehicle drives
+//the cycle for driveHours starting at 8:00, and is parked for the rest of the day. The ambient
+//temperature follows a seasonal and a daily cosine.
+struct AgingOptions{
+    string cycle; //Drive cycle (built-in name or CSV trace)
+    float driveHours; //Hours of driving per day
+    float dt; //Time step while driving (s)
+    float parkDt; //Time step while parked (s)
+    float ambientMean; //Yearly mean ambient temperature (C)
+    float seasonalSwing; //Amplitude of the seasonal change (C), warmest in mid July
+    float dailySwing; //Amplitude of the day/night change (C), warmest at 15:00
+    float cycleFade; //SOH lost per full cycle (Battery::degradeWithCycle)
+    float thermalFade; //SOH lost per second and degree above 40 C (Battery::degradeSOH)
+    int years; //Length of the projection
+    int sampleDays; //One representative day is simulated for every sampleDays days of similar temperature
+    int validateDays; //Days to brute-force step for validation (0 to skip)
+    float tolerance; //Largest difference (SOH points) between the projection and brute force that passes validation
+
+    AgingOptions();
+};
+
+//What one day did to the battery
+struct DayAggregate{
+    double throughputAh; //Charge drawn from the battery
+    double hotDegreeSeconds; //Integral of (temperature - 40) over the time above 40 C
+    long long steps; //Full simulation steps
+    long long thermalSteps; //Drive steps replayed from another day with only the temperature stepped
+};
+
+//@brief ambient temperature at a time of the year
+float agingAmbient(const AgingOptions &options, double dayOfYear, double secondOfDay);
+
+//@brief simulate one day at full fidelity. With applyAging the battery's degradeSOH and degradeWithCycle are
+//called every step (brute force); without it the day is only measured.
+DayAggregate simulateAgingDay(Simulation &sim, DriveCycle &cycle, const AgingOptions &options, int day, bool applyAging);
+
+//SOH at the end of each year of the projection
+struct AgingProjection{
+    vector<float> yearlySOH;
+    double throughputAhPerYear;
+    double hotDegreeSecondsPerYear;
+    long long stepsSimulated;
+    long long thermalSteps;
+};
+
+//@brief project SOH over options.years by simulating representative days and adding up their aggregates.
+//The drive is simulated once; the other days replay it and step only the battery temperature.
+bool projectAging(const AgingOptions &options, AgingProjection &projection);
+
+//@brief SOH from the total charge drawn and time spent hot (the same arithmetic as degradeWithCycle
+//and degradeSOH, applied once to the totals)
+float extrapolateSOH(double throughputAh, double hotDegreeSeconds, float capacity, float cycleFade, float thermalFade);
+
+//Command line aging run: projection plus brute-force validation
+int runAging(const AgingOptions &options);
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef ASYNC_TELEMETRY_H
+#define ASYNC_TELEMETRY_H
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <string>
+#include "../headers/telemetry.h"
+#include "../headers/telemetry_sampling.h"
+using namespace std;
+
+//A record waiting in the ring buffer, stamped with the time it was produced (to measure writer lag)
+struct TelemetrySlot{
+    TelemetryRecord record;
+    long long producedNs; //steady_clock time in nanoseconds
+};
+
+//Single-producer/single-consumer lock-free ring buffer of telemetry records. The frame thread is the
+//only producer and the writer thread the only consumer, so two atomic indices are all the
+//synchronisation needed. The capacity is rounded up to a power of two.
+class TelemetryRing{
+
+    private:
+        vector<TelemetrySlot> slots;
+        size_t mask;
+        alignas(64) atomic<size_t> head; //Next slot to write (only changed by the producer)
+        alignas(64) atomic<size_t> tail; //Next slot to read (only changed by the consumer)
+
+    public:
+        TelemetryRing(size_t capacity);
+
+        bool push(const TelemetrySlot &slot); //false if the buffer is full
+        bool pop(TelemetrySlot &slot); //false if the buffer is empty
+        size_t size() const;
+        size_t capacity() const;
+};
+
+//Counters reported by the async writer
+struct AsyncTelemetryStats{
+    long long written; //Records taken from the buffer
+    long long rowsKept; //Rows the sampler wrote to the file
+    long long dropped; //Records lost because the ring buffer was full
+    size_t highWaterMark; //Most records ever waiting in the buffer
+    double maxLagSeconds; //Longest wall time between a record being produced and written
+};
+
+//Telemetry writer that keeps file I/O off the frame thread. log() only copies the record into the ring
+//buffer; a background thread drains it into a TelemetryWriter (binary) or a CSV file. If the disk
+//stalls long enough for the buffer to fill, new records are dropped and counted instead of blocking.
+//Records pass through a TelemetrySampler on the writer thread, so sampling costs the frame thread nothing.
+class AsyncTelemetryWriter{
+
+    private:
+        TelemetryRing ring;
+        TelemetryWriter binary;
+        ofstream csv;
+        TelemetrySampler sampler;
+        vector<float> sampled; //Rows the sampler picked, waiting to be written
+        thread writerThread;
+        atomic<bool> running;
+        atomic<long long> written;
+        atomic<long long> rowsKept;
+        atomic<long long> dropped;
+        atomic<size_t> highWaterMark;
+        atomic<long long> maxLagNs;
+
+        void drain();
+        void writeRecord(const TelemetryRecord &record);
+        void writeSampled();
+
+    public:
+        AsyncTelemetryWriter(size_t capacity = 65536);
+        ~AsyncTelemetryWriter();
+
+        //@param policies - one per standard channel, or empty to write every record
+        bool open(const string &path, const vector<SamplingPolicy> &policies = {});
+        bool is_open();
+        void log(const TelemetryRecord &record);
+        void close();
+        AsyncTelemetryStats get_stats();
+};
+
+#endif
@@ -0,0 +1,48 @@
+#ifndef BATTERY_KERNELS_H
+#define BATTERY_KERNELS_H
+
+//Batched versions of Battery::discharge, Battery::updateTemperature and Battery::degradeSOH.
+//They work on arrays of battery state (one entry per battery, like the Fleet arrays) and turn the
+//branches of the scalar functions into masked selects, so they can be run 8 lanes at a time with AVX2
+//or 4 lanes at a time with NEON. The instruction set is picked at run time: x86 builds always contain
+//the AVX2 versions and use them when the processor supports AVX2 (no -mavx2 needed), 64-bit ARM builds
+//use NEON, and everything else uses the portable scalar loops. Fleet::step runs its Standard level on them.
+//
+//Accuracy compared to the Battery member functions, per call:
+//  - dischargeBatch matches Battery::discharge exactly (same float operations in the same order)
+//  - updateTemperatureBatch matches Battery::updateTemperature exactly (the heat term is computed in
+//    double, as the double constant makes the member function do)
+//  - degradeSOHBatch matches Battery::degradeSOH exactly
+//  - dischargeFlatBatch matches Battery::discharge at a temperature between 0 and 40 C exactly
+
+//@brief Battery::discharge for count batteries
+void dischargeBatch(float* Q_now, float* current, const float* speed, const float* temperature,
+                    int count, float delta_t);
+
+//@brief Battery::discharge for count batteries without the temperature tiers (the Fleet's Reduced level)
+void dischargeFlatBatch(float* Q_now, float* current, const float* speed, int count, float delta_t);
+
+//@brief Battery::updateTemperature for count batteries
+void updateTemperatureBatch(float* temperature, const float* current, const float* R_internal,
+                            const float* heatCapacity, float heatTransferCoeff,
+                            int count, float delta_t, float ambientTemp);
+
+//@brief Battery::degradeSOH for count batteries with the same thermal fade (SOH lost per second per degree above 40 C)
+void degradeSOHBatch(float* stateOfHealth, const float* temperature, int count, float delta_t, float thermalFade);
+
+//Portable scalar versions (used for the tail of the arrays and when no SIMD instruction set is available)
+void dischargeBatchScalar(float* Q_now, float* current, const float* speed, const float* temperature,
+                          int count, float delta_t);
+void dischargeFlatBatchScalar(float* Q_now, float* current, const float* speed, int count, float delta_t);
+void updateTemperatureBatchScalar(float* temperature, const float* current, const float* R_internal,
+                                  const float* heatCapacity, float heatTransferCoeff,
+                                  int count, float delta_t, float ambientTemp);
+void degradeSOHBatchScalar(float* stateOfHealth, const float* temperature, int count, float delta_t, float thermalFade);
+
+//@return name of the instruction set the batch functions run on ("AVX2", "NEON" or "scalar")
+const char* batteryKernelName();
+
+//Command line benchmark: compares Battery objects, the scalar batch loops and the SIMD kernels
+int runBatteryKernelBenchmark();
+
+#endif
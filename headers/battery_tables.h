@@ -0,0 +1,55 @@
+#ifndef BATTERY_TABLES_H
+#define BATTERY_TABLES_H
+#include <string>
+using namespace std;
+
+//Curves of the table-driven battery model: open-circuit voltage against SOC, and internal resistance,
+//discharge rate and charging efficiency against temperature or SOC. They are loaded once from a data file
+//(assets/battery_tables.txt) and then only read, so one BatteryTables can be shared by every Battery of
+//every thread. A Battery uses them after Battery::set_tables; without tables it keeps the fixed model
+//(fixed nominal voltage, constant resistance, 0.7 / 1.0 / 1.2 discharge tiers).
+
+//A curve sampled at uniformly spaced points. Looking a value up is a multiply, two loads and a linear
+//interpolation with no branches (outside the range the curve is held at its end values).
+class LookupTable{
+
+    public:
+        static const int MAX_POINTS = 63;
+
+    private:
+        //64 floats: one 256-byte block on cache-line boundaries. The last point is repeated after the end so
+        //the interpolation can always read point i + 1.
+        alignas(64) float values[MAX_POINTS + 1];
+        float first; //x of the first point
+        float scale; //Points per unit of x
+        float lastIndex; //Index of the last point
+
+    public:
+        LookupTable();
+
+        //@brief sample points uniformly spaced from firstX to lastX
+        //@return false if there are fewer than 2 or more than MAX_POINTS points, or the range is empty
+        bool set(float firstX, float lastX, const float* points, int count);
+
+        float at(float x) const{
+            float t = (x - first) * scale;
+            t = t > 0 ? t : 0; //Written so that they compile to maxss/minss, not jumps
+            t = t < lastIndex ? t : lastIndex;
+            int i = static_cast<int>(t);
+            return values[i] + (values[i + 1] - values[i]) * (t - i);
+        }
+};
+
+struct BatteryTables{
+    LookupTable ocv; //Open-circuit voltage as a fraction of V_max, against SOC (%)
+    LookupTable resistance; //Factor on R_internal, against battery temperature (C)
+    LookupTable discharge; //Factor on the discharge rate, against battery temperature (C)
+    LookupTable chargeEfficiency; //Fraction of the charging current stored, against SOC (%)
+
+    //@brief read the tables from a data file. Lines starting with # are comments; each table is
+    //"table <name> <first x> <last x> <count>" followed by count values.
+    //@return false (with a message) if the file cannot be read or a table is missing or invalid
+    bool load(const string &path);
+};
+
+#endif
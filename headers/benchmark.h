@@ -0,0 +1,52 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+#include <string>
+#include <vector>
+#include <functional>
+using namespace std;
+
+//Microbenchmarks of the component hot paths. Every benchmark runs a fixed workload from a fixed starting
+//state, so numbers are comparable between runs and builds. Allocations are counted by a replacement of the
+//global operator new in bench/alloc_counter.cpp, which is only linked into the benchmark build (bin/bench),
+//so the window and the other modes do not pay for it. Other builds report allocations as n/a.
+
+//One measured benchmark
+struct BenchmarkResult{
+    string name;
+    long long ops; //Operations in each timed repetition
+    double nsPerOp; //Median over the repetitions
+    double opsPerSecond;
+    double allocationsPerOp; //-1 if the build does not count allocations
+};
+
+struct BenchmarkOptions{
+    string filter; //Only run benchmarks whose name contains this (empty for all)
+    double minTime; //Seconds each repetition should take at least
+    int repetitions; //Timed repetitions (the median is reported)
+    string jsonPath; //Also write the results as JSON (empty for none)
+    string baselinePath; //JSON results of an earlier build to compare with (empty for none)
+    double threshold; //Slowdown against the baseline that counts as a regression (0.1 == 10%)
+
+    BenchmarkOptions();
+};
+
+//@brief time body(ops) for enough ops to take options.minTime, repeated options.repetitions times
+//@param body - runs the operation ops times
+BenchmarkResult runBenchmark(const string &name, const function<void(long long)> &body, const BenchmarkOptions &options);
+
+//@return number of allocations made by the program so far, or -1 if the build does not count them
+long long allocationCount();
+//The counter behind allocationCount(), registered by bench/alloc_counter.cpp
+extern long long (*allocationCounter)();
+
+//@brief write results as JSON ({"build": {...}, "benchmarks": [...]})
+bool writeBenchmarkJson(const string &path, const vector<BenchmarkResult> &results);
+
+//@brief print the change of every benchmark against a baseline JSON file
+//@return 0 if nothing is slower than the baseline by more than threshold, 1 otherwise
+int compareWithBaseline(const string &path, const vector<BenchmarkResult> &results, double threshold);
+
+//Command line benchmark suite
+int runBenchmarks(const BenchmarkOptions &options);
+
+#endif
@@ -0,0 +1,8 @@
+#ifndef CLI_H
+#define CLI_H
+
+//Entry point for the command line modes (everything that runs without the SFML window).
+//main() calls this when the program is started with arguments.
+int runCommandLine(int argc, char* argv[]);
+
+#endif
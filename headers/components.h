@@ -5,7 +5,14 @@
 #include "../headers/vehicle.h"
 using namespace std;
 
+//Battery temperatures where the discharge rate of the fixed model steps (C)
+const float COLD_DISCHARGE_LIMIT = 0; //0.7 times the rate below
+const float HOT_DISCHARGE_LIMIT = 40; //1.2 times the rate above
+
 class EV;
+class StateWriter;
+class StateReader;
+struct BatteryTables;
 
 class Battery{
 
@@ -22,6 +29,13 @@ class Battery{
         float heatTransferCoeff; //To environment W/°C
         float totalTimeSeconds; //Total session time in seconds - this could be implemented in the future as well, but we haven't used it yet
         float totalDistanceKm; //Total distance traveled in kilometers
+        float cycleCharge; //Charge accumulated towards the next full charge-discharge cycle (Ah)
+        float cycleFade; //State of health lost per full cycle (0.1 == 10%)
+        float thermalFade; //State of health lost per second per degree above 40°C
+        const BatteryTables* tables; //Curves of the table-driven model (shared, read only), nullptr for the fixed model
+
+        float resistance(); //Internal resistance at the current temperature
+        float tempFactor(float temperature); //Discharge rate factor at a temperature
 
     public:
         
@@ -29,47 +43,64 @@ class Battery{
         Battery(float Q_max, float V_max, float R_internal, float heatCapacity);
         ~Battery(){}
         //Copy constructor
-        Battery(const Battery& other) : Q_max(other.Q_max) {
-            Q_now = other.Q_max;
-        }
-
-    //Assignment operator to set a class equal to another
-    Battery& operator=(const Battery& other) {
-        if (this != &other) {
-            Q_max = other.Q_max;
-            Q_now = other.Q_max;
-        }
-        return *this;
-    }
+        Battery(const Battery& other);
+
+        //Assignment operator to set a class equal to another
+        Battery& operator=(const Battery& other);
 
         void set_Q_max(float Q);
         void set_Q_current(float Q);
         void set_V_max(float V);
         void set_R_internal(float R);
         void set_SOH(float SOH);
+        void set_cycleFade(float fade);
+        void set_thermalFade(float fade);
         void set_temp(float T);
+        //@brief use OCV, resistance, discharge and charging efficiency curves (nullptr for the fixed model).
+        //The tables are not copied and must outlive the battery.
+        void set_tables(const BatteryTables* tables);
 
         float get_SOC();
         float get_Q_max();
         float get_Q_current();
         float get_V_max();
         float get_R_internal();
+        float get_heatCapacity();
+        float get_heatTransferCoeff();
+        float get_cycleFade();
+        float get_thermalFade();
         float get_SOH();
         float get_temp();
+        float get_current();
+        float get_voltage(); //Terminal voltage: OCV at the SOC with the sag of the current with tables, the fixed nominal voltage without
+        const BatteryTables* get_tables();
 
         void setCurrent(float I);
         void rechargeFromRegen(float deltaQ);
 
         void discharge(float speed, float delta_t);
 
+        //Rates of change used by the adaptive integrator (same equations as discharge, charge and updateTemperature)
+        float dischargeRate(float speed, float temperature); //Charge drawn per second (Ah/s)
+        float chargeRate(float V_applied); //Charge gained per second while charging
+        float heatBalance(float temperature, float current, float ambientTemp); //Temperature change per second (C/s)
+
         bool charge(float V_applied, float time, bool &fullCharge);
 
         float updateTemperature(float delta_t, float ambientTemp);
+        float relaxTemperature(long long steps, float delta_t, float ambientTemp);
 
         void degradeSOH(float delta_t);
 
         void degradeWithCycle(float deltaQ);
 
+        //Wear after a step: degradeSOH for the step, then degradeWithCycle for the charge drawn over it
+        void wear(float drawn, float delta_t);
+
+        //Snapshot section "BATT" (see snapshot.h)
+        void saveState(StateWriter &out);
+        bool loadState(StateReader in);
+
 
 };
 
@@ -77,7 +108,7 @@ class Battery{
 class Motor {
 private:
     float speed; //Speed of the vehicle in km/h
-    float R_internal; //Internal resistance of the motor - we haven't actually used this attribute anywhere yet as we only modelled the electrical activity of the battery, but we plan to in the future
+    float R_internal; //Winding resistance of the motor (only the Detailed fleet level models motor losses)
     float efficiency; //Efficiency of the motor (between 0 and 1)
     float maxSpeed; //Maximum motor speed
     float maxTorque; //Maximum torque the motor can deliver in Newton-meters
@@ -88,6 +119,7 @@ private:
     float heatTransferCoeff; // Heat transfer coefficient for motor cooling (W/C)
     float temperature;       // Current temperature of the motor (C)
     float heatCapacity; // Thermal capacity of motor, heat needed to raise temp by 1°C (J/C)
+    float angularSpeed; // Angular speed of the wheels (rad/s)
 
 
 public:
@@ -104,12 +136,27 @@ public:
 
     float getMaxRegenPower() const;
 
+    float get_maxSpeed();
+    float get_maxTorque();
+    float get_maxBrakeTorque();
+    float get_inertia();
+    float get_R_internal();
+    float get_efficiency();
+    float get_regenEfficiency();
+    void set_R_internal(float R);
+    void set_efficiency(float efficiency);
+    float get_angularSpeed();
+    void set_angularSpeed(float w);
+
+    float angularAcceleration(DriverInput& driverInput);
     float updateSpeed(DriverInput& driverInput, EV &vehicle, Battery &battery, float deltaTime);
     void applyRegenerativeBraking(DriverInput &input, EV &vehicle, Battery& battery, float deltaTime);
     float calculateRegenPower(DriverInput &input);
     float updateTemperature(float delta_t, float ambientTemp);
 
-
+    //Snapshot section "MOTR" (see snapshot.h)
+    void saveState(StateWriter &out);
+    bool loadState(StateReader in);
 
 };
 
@@ -125,9 +172,15 @@ class Charger{
 
     Charger();
 
+    float chargingVoltage(Battery &battery);
     void startCharging(Battery &battery, float delta_t);
     void stopCharging();
     bool get_charging_state();
+    float get_maxPowerOutput();
+
+    //Snapshot section "CHRG" (see snapshot.h)
+    void saveState(StateWriter &out);
+    bool loadState(StateReader in);
 };
 
 #endif
\ No newline at end of file
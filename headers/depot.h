@@ -0,0 +1,94 @@
+#ifndef DEPOT_H
+#define DEPOT_H
+#include <vector>
+#include "../headers/driver_input.h"
+#include "../headers/vehicle.h"
+#include "../headers/components.h"
+using namespace std;
+
+//Discrete-event simulation of a charging depot: vehicles come back from their shift, queue for one of a
+//limited number of chargers, charge and leave for the next shift. Nothing is stepped frame by frame; the
+//state only changes at events, and a charging session is applied to the battery in one call to
+//Charger::startCharging with the length of the session (the charge is linear in time, like the
+//fast-forward in Simulation::skipIdleSteps).
+
+//Settings of a depot run
+struct DepotOptions{
+    int vehicles;
+    int chargers; //Charging points
+    float gridPowerCap; //Power the depot may draw from the grid (W); each session draws its charger's power
+    int days;
+    float handlingSeconds; //Time a charger is occupied before charging starts (parking, plugging in)
+    float shiftStart; //Mean departure time (hours after midnight)
+    float shiftStartSpread; //Departures are spread uniformly over +- this many hours
+    float shiftHours; //Mean driving time per shift (h)
+    float shiftHoursSpread; //+- hours
+    float averageSpeed; //Mean speed over a shift, stops included (m/s). A shift draws Battery::dischargeRate at this
+                        //speed for its length: 25 Ah per hour at 2.5 m/s, so a 150 Ah battery lasts 6 hours
+    unsigned int seed; //Seed of the vehicle schedules
+
+    DepotOptions();
+};
+
+enum DepotEventType{
+    DEPOT_ARRIVAL, //Back from a shift, joins the charger queue
+    DEPOT_PLUG_IN, //Handling done, charging starts
+    DEPOT_CHARGE_COMPLETE, //Battery full, the charger is freed
+    DEPOT_DEPARTURE //Leaves for the next shift (unplugged first if still charging)
+};
+
+//Indexed binary min-heap of pending events. Every vehicle has two slots: its next depot event (arrival,
+//plug-in or charge completion, never more than one at a time) and its departure. An event is addressed
+//by its slot, so it can be rescheduled or cancelled in O(log n) without searching, and the heap never
+//holds more than two entries per vehicle. Ties are broken by slot number so runs are reproducible.
+class EventQueue{
+
+    private:
+        vector<int> heap; //Slots, ordered by (time, slot)
+        vector<int> position; //Index of each slot in heap, -1 if the slot has no pending event
+        vector<double> times;
+        vector<DepotEventType> types;
+
+        bool earlier(int a, int b) const;
+        void siftUp(int index);
+        void siftDown(int index);
+        void swapEntries(int a, int b);
+
+    public:
+        EventQueue(int slots);
+
+        //@brief schedule the event of a slot, replacing the one already pending there
+        void schedule(int slot, double time, DepotEventType type);
+        void cancel(int slot);
+        bool empty() const;
+        bool pending(int slot) const;
+        //@brief remove the earliest event
+        //@return its slot (time and type are returned in the arguments)
+        int pop(double &time, DepotEventType &type);
+};
+
+//Totals of a depot run
+struct DepotResults{
+    long long events;
+    long long sessions; //Charging sessions
+    long long queued; //Arrivals that had to wait for a charger or for grid power
+    long long departedShort; //Departures with the battery not full
+    long long stranded; //Shifts that needed more charge than the battery had (the vehicle ran empty on the road)
+    double strandedAh; //Charge those shifts were short of
+    double totalWaitSeconds; //Time spent waiting in the queue
+    double maxWaitSeconds;
+    int maxQueueLength;
+    double chargedAh; //Charge delivered to the batteries
+    double chargerBusySeconds; //Sum over chargers of handling and charging time
+    double averageDepartureSOC; //Percent
+    double minDepartureSOC; //Percent
+    double simulatedSeconds;
+};
+
+//@brief run the depot for options.days
+bool simulateDepot(const DepotOptions &options, DepotResults &results);
+
+//Command line depot run: prints the results and the event throughput
+int runDepot(const DepotOptions &options);
+
+#endif
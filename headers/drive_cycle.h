@@ -0,0 +1,47 @@
+#ifndef DRIVE_CYCLE_H
+#define DRIVE_CYCLE_H
+#include <string>
+#include <vector>
+#include "../headers/driver_input.h"
+using namespace std;
+
+//A recorded drive cycle that replaces the keyboard as the source of DriverInput. Two kinds of trace are supported:
+//  - pedal traces: Time,Throttle,Brake columns (e.g. the output.csv of an interactive session)
+//  - speed traces: Time,Speed columns in m/s (standard cycles such as WLTP or UDDS exported as a time series).
+//    A simple proportional driver turns the target speed into throttle/brake.
+//Values are linearly interpolated at whatever time is asked for, and the cycle repeats after its last sample.
+//Everything is computed from the time passed in, so replaying at a fixed dt is bit-reproducible.
+class DriveCycle{
+
+    private:
+        string name;
+        vector<double> times;
+        vector<float> throttle; //Pedal traces
+        vector<float> brake;
+        vector<float> speed; //Speed traces (m/s)
+        bool speedTrace;
+        size_t cursor; //Index of the last segment used, so playing forward in time is O(1) per lookup
+
+        float interpolate(const vector<float> &values, double time);
+
+    public:
+        DriveCycle();
+
+        bool loadCsv(const string &path);
+        bool loadBuiltin(const string &cycleName);
+        bool load(const string &pathOrName); //Built-in cycle name or CSV file
+
+        string get_name();
+        bool isSpeedTrace();
+        double duration();
+        size_t samples();
+
+        //@brief target speed (speed traces) at a time in the cycle
+        float targetSpeed(double time);
+
+        //@brief set the throttle and brake for a time in the cycle
+        //@param time - seconds since the start of the replay, vehicleSpeed - current speed (used by speed traces)
+        void apply(double time, float vehicleSpeed, DriverInput &input);
+};
+
+#endif
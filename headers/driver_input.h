@@ -1,6 +1,9 @@
 #ifndef DRIVER_INPUT_H
 #define DRIVER_INPUT_H
 
+class StateWriter;
+class StateReader;
+
 class DriverInput {
 private:
     float throttlePosition;
@@ -14,6 +17,10 @@ public:
     
     void set_throttle(float intensity);
     void set_brake(float intensity); 
+
+    //Snapshot section "DRVR" (see snapshot.h)
+    void saveState(StateWriter &out);
+    bool loadState(StateReader in);
 };
 
 #endif
@@ -0,0 +1,124 @@
+#ifndef FLEET_H
+#define FLEET_H
+#include <vector>
+#include <cstdint>
+#include <string>
+#include "../headers/vehicle.h"
+#include "../headers/components.h"
+using namespace std;
+
+class ThreadPool;
+
+//How much physics a fleet step computes. The level is set per fleet and chosen once per batch of vehicles
+//(each level is its own compiled loop), so there is no per-vehicle or per-call dispatch.
+enum class Fidelity{
+    Reduced, //No regenerative braking, no thermal model, temperature-independent discharge: for big fleet studies
+    Standard, //The equations of the Battery/Motor classes (what the window and Simulation run)
+    Detailed //Adds the body's road load (EV::roadLoadForce), motor losses and an RC equivalent-circuit battery
+};
+
+const char* fidelityName(Fidelity level);
+//@return false if the name is not reduced, standard or detailed
+bool parseFidelity(const string &name, Fidelity &level);
+
+//A fleet of vehicles stored as a struct of arrays: every field of the vehicle state lives in its own
+//contiguous array, indexed by vehicle number. At Standard fidelity step() runs the same equations as
+//Motor::updateSpeed, Battery::discharge, Battery::updateTemperature and Charger::startCharging for all vehicles
+//in one loop, so a fleet vehicle given the same inputs follows the same trajectory as a single Simulation.
+//Every level also wears the batteries the way the aging projection and the regression scenarios do
+//(Battery::degradeSOH every step, Battery::degradeWithCycle for the charge drawn); --check-fleet checks
+//the Standard level against Simulation bit for bit.
+class Fleet{
+
+    public:
+        //Battery state
+        vector<float> Q_max; //Max charge (Ah)
+        vector<float> Q_now; //Current charge (Ah)
+        vector<float> V_max; //Max voltage (V)
+        vector<float> R_internal; //Internal resistance (Ohm)
+        vector<float> heatCapacity; //Thermal mass (J/C)
+        vector<float> temperature; //Battery temperature (C)
+        vector<float> stateOfHealth; //SOH (1 == 100%)
+        vector<float> cycleCharge; //Charge drawn towards the next full cycle (Ah)
+        vector<float> startCharge; //Q_now at the start of the step being taken (for the cycle wear)
+        vector<float> current; //Battery current (A)
+        vector<float> rcVoltage; //Voltage over the RC pair of the equivalent circuit (V, Detailed only)
+
+        //Motor and vehicle state
+        vector<float> maxTorque; //Max motor torque (Nm)
+        vector<float> maxSpeed; //Max speed
+        vector<float> wheelRadius; //Wheel radius (m)
+        vector<float> angularSpeed; //Angular speed of the wheels (rad/s)
+        vector<float> speed; //Vehicle speed
+
+        //Driver input
+        vector<float> throttle; //0 to 1
+        vector<float> brake; //0 to 1
+        vector<uint8_t> charging; //1 while the charger is plugged in
+
+        //Constants shared by every vehicle, copied from the components passed to configure()
+        float maxBrakeTorque;
+        float inertia;
+        float regenEfficiency;
+        float maxRegenPower;
+        float heatTransferCoeff; //Battery to environment (W/C)
+        float cycleFade; //SOH lost per full cycle
+        float thermalFade; //SOH lost per second per degree above 40 C
+
+        //Constants of the Detailed level
+        float motorResistance; //Motor winding resistance (Ohm), from Motor
+        float motorEfficiency; //Mechanical power out per electrical power in, from Motor
+        EV body; //Mass, drag coefficient and frontal area for the road load
+        float rcResistance; //R1 of the battery's RC pair (Ohm), the Battery class has no RC pair
+        float rcCapacitance; //C1 of the battery's RC pair (F)
+
+        Fidelity fidelity;
+
+        //An empty fleet configured with the default Motor, Battery and EV
+        Fleet();
+
+        //Take the shared constants from a motor, battery and body. The default EV has no mass, drag or frontal
+        //area, so the Detailed level only has a road load with a body that sets them.
+        void configure(Motor &motor, Battery &battery, EV &body);
+
+        //Add a vehicle. Like the component constructors, -1 selects the default value of a parameter.
+        //@return index of the new vehicle
+        int addVehicle(float Q_max, float V_max, float R_internal, float heatCapacity,
+                       float maxTorque, float maxSpeed, float wheelRadius);
+        //Add a vehicle in the state of a battery, motor and body (charge, temperature, SOH, current and wheel speed)
+        int addVehicle(Battery &battery, Motor &motor, EV &body);
+
+        int size() const;
+        void reserve(int count);
+
+        void setInput(int i, float throttle, float brake);
+
+        void step(float delta_t, float ambientTemp);
+        void stepRange(int begin, int end, float delta_t, float ambientTemp);
+        void stepParallel(ThreadPool &pool, float delta_t, float ambientTemp, int chunkSize);
+        void applyScriptedInputs(float time);
+
+        float get_SOC(int i) const;
+
+    private:
+        template <Fidelity level>
+        void stepLevel(int begin, int end, float delta_t, float ambientTemp);
+        void wear(int begin, int end, float delta_t);
+};
+
+//Command line benchmark: steps a fleet of the given size and reports vehicles*steps per second
+int runFleetBenchmark(int vehicles, int steps, float delta_t, Fidelity level = Fidelity::Standard);
+
+//Command line benchmark: steps the same fleet at every fidelity level and reports the cost per vehicle-step
+//and how far each level's results are from the Detailed and the Standard ones. The batteries start spread
+//over -10..50 C so the discharge tiers and the thermal model make a difference.
+int runFidelityComparison(int vehicles, int steps, float delta_t);
+
+//Command line benchmark: steps the same fleet with 1 to maxThreads threads and reports the scaling
+int runFleetScaling(int vehicles, int steps, float delta_t, int maxThreads);
+
+//Command line check: a Standard fleet against one Simulation per vehicle with the same inputs and wear
+//@return 0 if every vehicle matches bit for bit, 1 otherwise
+int runFleetCheck();
+
+#endif
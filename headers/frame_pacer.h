@@ -0,0 +1,41 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+#include <chrono>
+#include "../headers/frame_times.h"
+using namespace std;
+
+//Paces the window loop at a fixed frame rate. Each frame waits until an absolute deadline (sleeping most of
+//the way and spinning the last fraction of a millisecond, since sleeps overshoot), so the frame rate does not
+//drift with how long the frame's work took. With vsync on, display() already waits for the screen and the
+//pacer only measures. Frame intervals are kept for p50/p99, and frames that start after their deadline are
+//counted as missed.
+class FramePacer{
+
+    private:
+        chrono::steady_clock::duration period;
+        chrono::steady_clock::time_point deadline; //When the next frame should start
+        chrono::steady_clock::time_point lastFrame; //When the current frame started
+        bool vsync;
+        FrameTimes frameTimes; //Last frame intervals
+        long long frames; //Frames since the start
+        long long missed; //Frames that started after their deadline
+
+    public:
+        FramePacer(float rateHz);
+
+        //@brief wait until the next frame is due
+        //@return when the new frame starts, the time its physics state should be drawn at
+        chrono::steady_clock::time_point wait();
+
+        void set_rate(float rateHz);
+        float get_rate();
+        void set_vsync(bool on);
+        bool get_vsync();
+
+        //@brief frame interval (ms) at a percentile (0 to 100) of the recent frames
+        float framePercentile(float percentile);
+        long long get_frames();
+        long long get_missed();
+};
+
+#endif
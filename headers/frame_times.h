@@ -0,0 +1,29 @@
+#ifndef FRAME_TIMES_H
+#define FRAME_TIMES_H
+#include <vector>
+using namespace std;
+
+//Ring buffer of the most recent frame times (ms), with the statistics the window shows. Used by the frame
+//pacer (intervals between frame starts) and the profiler (time spent in each frame).
+class FrameTimes{
+
+    private:
+        vector<float> times;
+        size_t next; //Slot the next time goes into
+        size_t count; //Times kept (at most times.size())
+
+    public:
+        FrameTimes(size_t capacity = 600);
+
+        //@brief forget every time and keep up to capacity from now on
+        void reset(size_t capacity);
+        void add(float ms);
+        size_t size() const;
+
+        //@brief time (ms) at a percentile (0 to 100) of the recent frames
+        float percentile(float percentile) const;
+        //@brief count the recent frames into bins of binMs milliseconds (the last bin also gets everything slower)
+        void histogram(vector<int> &bins, float binMs) const;
+};
+
+#endif
@@ -0,0 +1,51 @@
+#ifndef INTEGRATOR_H
+#define INTEGRATOR_H
+#include "../headers/driver_input.h"
+#include "../headers/vehicle.h"
+#include "../headers/components.h"
+using namespace std;
+
+//Adaptive-step integration of the vehicle dynamics. Instead of one explicit Euler step per frame, the
+//wheel speed, battery charge and battery temperature are integrated as one ODE with an embedded
+//Runge-Kutta 5(4) pair (Dormand-Prince) whose step size follows the local error estimate. The places
+//where the equations change form are located as events and stepped to exactly:
+//  - the wheels stopping (angular speed reaching 0) and the speed reaching the motor's max speed
+//  - the battery running empty (SOC 0%) or full (SOC 100%)
+//  - the battery temperature crossing 0 C and 40 C (the discharge rate tiers)
+//Between events the equations are smooth, so steady phases are covered in a few large steps.
+//
+//The driver input, charger and ambient temperature are held constant over the interval. The battery
+//current is the instantaneous one (regen current minus discharge current); Battery::discharge adds the
+//discharge current of every step to the previous value instead, so temperatures from the two
+//methods are not directly comparable when the battery heats up from its own current.
+
+struct IntegratorOptions{
+    double relTol; //Relative error allowed per step
+    double absTol; //Absolute error allowed per step (rad/s, Ah and C)
+    double minStep; //Smallest step in seconds (below this a step is accepted whatever its error)
+    double maxStep; //Largest step in seconds
+
+    IntegratorOptions();
+};
+
+struct IntegratorStats{
+    long long accepted; //Steps taken
+    long long rejected; //Steps retried with a smaller step size
+    long long events; //Events stepped to
+};
+
+//@brief advance the motor and battery by duration seconds with adaptive steps.
+//The components are updated through their setters, as updateSpeed/updateTemperature would.
+//@param charging - true if the charger is plugged in, ambientTemp - temperature of the environment
+//@param stats - steps, rejected steps and events are added to it
+//@return speed at the end
+float integrateVehicle(Motor &motor, Battery &battery, EV &vehicle, Charger &charger, DriverInput &input,
+                       bool charging, float ambientTemp, double duration, const IntegratorOptions &options,
+                       IntegratorStats &stats);
+
+//Command line check: runs a drive/park/charge scenario with fixed Euler steps and with the adaptive
+//integrator at several tolerances and compares them to a tight-tolerance reference
+//@return 0 if every adaptive run stays within the error bound of its tolerance, 1 otherwise
+int runIntegratorCheck();
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef LOG_ANALYTICS_H
+#define LOG_ANALYTICS_H
+#include <string>
+#include <vector>
+#include <cstddef>
+using namespace std;
+
+class ThreadPool;
+
+//Read-only view of a whole file. On POSIX systems the file is memory-mapped; elsewhere it is read into memory.
+class MappedFile{
+
+    private:
+        const char* bytes;
+        size_t length;
+        void* mapping; //Address returned by mmap (nullptr when the file was read into buffer)
+        vector<char> buffer;
+
+    public:
+        MappedFile();
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const string &path);
+        void close();
+        const char* data() const;
+        size_t size() const;
+};
+
+//The columns of a telemetry log that the analytics use
+struct LogColumns{
+    vector<float> time;
+    vector<float> speed;
+    vector<float> soc;
+    vector<float> batteryTemp;
+    long long badRows; //Rows that could not be parsed and were skipped
+
+    size_t rows() const;
+};
+
+//@brief load a log (output.csv style CSV, or a binary .evtl log). Large CSV files are split at line
+//boundaries and parsed with from_chars on the pool's threads; pool may be nullptr for a single thread.
+bool loadLog(const string &path, LogColumns &columns, ThreadPool* pool);
+
+struct ChannelStats{
+    size_t count;
+    float mean;
+    float min;
+    float max;
+    float p50;
+    float p95;
+    float p99;
+};
+
+//Statistics of one time window of a log
+struct WindowStats{
+    float start; //Time at the start of the window (s)
+    ChannelStats speed;
+    ChannelStats soc;
+    ChannelStats batteryTemp;
+};
+
+//@brief mean/min/max and nearest-rank percentiles of count values (scratch is reused between calls)
+ChannelStats computeStats(const float* values, size_t count, vector<float> &scratch);
+
+//@brief split a log into windows of windowSeconds and compute the statistics of each window
+void computeWindows(const LogColumns &columns, float windowSeconds, vector<WindowStats> &windows, ThreadPool* pool);
+
+//Command line analytics: whole-log and optional windowed statistics for one or many logs
+int runLogAnalytics(const vector<string> &paths, float windowSeconds, int threads, const string &windowsPath);
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef PHYSICS_THREAD_H
+#define PHYSICS_THREAD_H
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include "../headers/simulation.h"
+using namespace std;
+
+class AsyncTelemetryWriter;
+
+//What the window shows of the simulation at one physics step. Snapshots are copied whole, so the render
+//thread never sees a half-updated vehicle. The values of the step before are kept too, so the window can
+//draw in between two steps.
+struct VehicleSnapshot{
+    double time; //Simulated seconds
+    float speed; //m/s
+    float SOC; //%
+    float batteryTemp; //C
+    float SOH; //Battery state of health (0 to 1)
+    float throttle;
+    float brake;
+    bool charging; //Charger state after the step
+    long long step; //Physics steps taken so far (0 before the first one)
+    double distance; //m driven since the start
+    float prevSpeed; //Speed, SOC, battery temperature and distance one step earlier
+    float prevSOC;
+    float prevBatteryTemp;
+    double prevDistance;
+    chrono::steady_clock::time_point stepTime; //Wall time the step stands for
+};
+
+//Lock-free triple buffer for one writer thread and one reader thread. The writer fills its own slot and
+//swaps it with the shared middle slot; the reader swaps its slot with the middle one when a newer
+//snapshot is there. Neither side ever waits, and the reader always gets the latest complete snapshot.
+class SnapshotBuffer{
+
+    private:
+        struct alignas(64) Slot{
+            VehicleSnapshot snapshot;
+        };
+        Slot slots[3];
+        alignas(64) atomic<int> middle; //Index of the shared slot, plus FRESH if the writer put a new snapshot there
+        alignas(64) int back; //Only used by the writer
+        alignas(64) int front; //Only used by the reader
+
+    public:
+        SnapshotBuffer();
+
+        void publish(const VehicleSnapshot &snapshot); //Writer thread only
+        const VehicleSnapshot& latest(); //Reader thread only
+};
+
+//Runs a Simulation on its own thread at a fixed rate, independent of how fast the window draws.
+//The window thread sets the driver input with setInput() and reads snapshots with latest() or interpolated().
+//Wall time is collected in an accumulator and spent in whole steps of delta_t, so the physics always sees
+//the same time step however late the thread wakes up.
+class PhysicsThread{
+
+    private:
+        Simulation sim;
+        float ambientTemp; //Ambient temperature of the simulation (set once, read from any thread)
+        float delta_t; //Fixed physics step (s)
+        long long steps; //Steps taken (only used by the physics thread)
+        double distance; //m driven (only used by the physics thread)
+        atomic<long long> droppedSteps; //Steps skipped because the thread fell too far behind
+        AsyncTelemetryWriter* log; //Gets a record every step (nullptr for none)
+        SnapshotBuffer snapshots;
+        thread worker;
+        atomic<bool> running;
+
+        //Driver input, written by the window thread
+        atomic<float> throttle;
+        atomic<float> brake;
+        atomic<bool> charging;
+
+        //New components waiting to be swapped in (set from the window thread when the EV is switched off)
+        mutex configLock;
+        atomic<bool> configPending;
+        Motor pendingMotor;
+        Battery pendingBattery;
+        EV pendingVehicle;
+
+        void run();
+        void publish(float prevSpeed, float prevSOC, float prevBatteryTemp, double prevDistance, chrono::steady_clock::time_point stepTime);
+
+    public:
+        PhysicsThread(float ambientTemp);
+        ~PhysicsThread();
+
+        //@brief start stepping at rateHz steps per second
+        //@param log - telemetry writer that gets a record every step (nullptr for none)
+        void start(float rateHz, AsyncTelemetryWriter* log);
+        void stop();
+
+        void setInput(float throttle, float brake, bool charging);
+        void configure(const Motor &motor, const Battery &battery, const EV &vehicle);
+        const VehicleSnapshot& latest();
+        //@brief the latest snapshot with speed, SOC, temperature and distance blended between its last two steps, drawn
+        //one step behind the physics so that now always falls between them
+        VehicleSnapshot interpolated(chrono::steady_clock::time_point now);
+        float get_dt();
+        float get_ambientTemp();
+        long long get_droppedSteps();
+};
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstdint>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include "../headers/frame_times.h"
+using namespace std;
+
+//Scoped profiling of the frame loop and the component hot paths. PROFILE_SCOPE("name") at the top of a
+//block records how long the block took. Events go into a buffer that is allocated once when profiling
+//starts (the oldest events are overwritten when it is full), and can be exported as a Chrome trace
+//(open it in chrome://tracing or https://ui.perfetto.dev).
+//
+//Recording is switched on and off for the whole process, and each thread that should appear in the trace
+//registers itself once (Profiler::start registers the calling thread; the physics thread and the telemetry
+//writer register when they start). Each registered thread records into its own buffer and becomes one
+//track (tid) of the trace. Unregistered threads, like the workers of fleet runs and sweeps, never record.
+//While not recording, a scope is one flag check. Build with -DEV_NO_PROFILING to compile the scopes out.
+
+//One timed scope
+struct ProfileEvent{
+    const char* name; //Must be a string literal (only the pointer is stored)
+    int64_t startNs; //Since Profiler::start
+    int64_t durationNs;
+    int depth; //Nesting level (0 for the frame itself)
+};
+
+//Events of one registered thread. The lock is only contended when the trace is written or reset.
+struct ProfileThread{
+    string name;
+    int id; //tid in the trace
+    mutex lock;
+    vector<ProfileEvent> events; //Ring buffer
+    size_t next; //Slot the next event goes into
+    size_t count; //Events recorded (at most events.size())
+};
+
+class Profiler{
+
+    private:
+        mutex threadsLock;
+        vector<unique_ptr<ProfileThread>> threads;
+        size_t capacity; //Events kept per thread
+        FrameTimes frameTimes; //Durations of the last frames
+        atomic<int64_t> originNs; //steady_clock time of start() (read by every recording thread)
+        chrono::steady_clock::time_point frameStart;
+
+    public:
+        Profiler();
+
+        //@brief let the calling thread record into a buffer of its own while the profiler runs
+        //@param name - track name in the trace (a thread registering again with the same name reuses its track)
+        void registerThread(const string &name);
+
+        //@brief start recording on the registered threads (and register the calling thread as "main"). The
+        //buffers are allocated here, not per event.
+        //@param capacity - events kept per thread (older ones are overwritten), frames - frame times kept for the histogram
+        void start(size_t capacity = 262144, size_t frames = 600);
+        void stop();
+        bool is_recording();
+
+        //Frame markers for the window loop: each frame becomes a "frame" event and one entry of the histogram
+        void beginFrame();
+        void endFrame();
+
+        void record(ProfileThread &thread, const char* name, int64_t startNs, int64_t durationNs, int depth);
+        int64_t now(); //ns since start
+
+        //@brief count the recent frames into bins of binMs milliseconds (the last bin also gets everything slower)
+        void frameHistogram(vector<int> &bins, float binMs);
+        //@brief frame time (ms) at a percentile (0 to 100) of the recent frames
+        float framePercentile(float percentile);
+        size_t recentFrames();
+
+        //@brief write the recorded events as Chrome trace-event JSON, one track per registered thread
+        bool writeChromeTrace(const string &path);
+};
+
+//The profiler used by PROFILE_SCOPE
+extern Profiler profiler;
+
+//True while the profiler is recording (checked first, so idle scopes do not touch thread-local storage)
+extern atomic<bool> profilingEnabled;
+//Buffer of the calling thread, nullptr if it did not register
+extern thread_local ProfileThread* profilingThread;
+extern thread_local int profilingDepth;
+
+//Times the enclosing block. Use PROFILE_SCOPE (a phase that is not a block of its own gets a {} block
+//around it), so -DEV_NO_PROFILING removes every scope.
+class ProfileScope{
+
+    private:
+        const char* name; //nullptr when not recording
+        ProfileThread* thread;
+        int64_t startNs;
+
+        void begin(const char* name);
+        void finish();
+
+    public:
+        ProfileScope(const char* name){
+            this->name = nullptr;
+            if (profilingEnabled.load(memory_order_relaxed) && profilingThread != nullptr){
+                begin(name);
+            }
+        }
+        ~ProfileScope(){
+            if (name != nullptr){
+                finish();
+            }
+        }
+};
+
+#ifdef EV_NO_PROFILING
+#define PROFILE_SCOPE(name)
+#else
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#endif
+
+#endif
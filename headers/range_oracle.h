@@ -0,0 +1,80 @@
+#ifndef RANGE_ORACLE_H
+#define RANGE_ORACLE_H
+#include <vector>
+#include "../headers/driver_input.h"
+#include "../headers/vehicle.h"
+#include "../headers/components.h"
+using namespace std;
+
+//Remaining range of a vehicle configuration, precomputed. build() simulates cruising until the battery is
+//empty from every point of a grid over (cruise speed, SOC, battery temperature) and keeps the distances in
+//one flat table. range() finds the grid cell of a query by arithmetic and interpolates between its 8
+//corners, so a query costs a few instructions instead of a forward simulation.
+//
+//The battery draws charge in proportion to the speed, so the speed changes the range through the time the
+//battery temperature has to move towards the ambient (and across the discharge steps) on the way. The SOH
+//is not an axis because the battery does not lose capacity with it. Range is in meters.
+const float RANGE_MIN_SPEED = 1; //m/s, slower queries (a parked vehicle) get the range at this speed
+const float RANGE_MAX_SPEED = 100; //m/s, the default motor's max speed
+
+class RangeOracle{
+
+    private:
+        //A uniformly spaced axis: point i is at first + i * step
+        struct Axis{
+            float first;
+            float step;
+            float inverseStep;
+            int count;
+        };
+
+        //Cruise speed (m/s) in two segments: the temperature has the longest to move at slow speeds, so the
+        //range changes fastest with the speed there and the slow segment is finer
+        Axis speedAxes[2];
+        Axis socAxis; //SOC (%)
+        //Battery temperature (C) in segments that end at the steps of the discharge rate (0 and 40 C), so that
+        //no cell spans a step: below -2, -2 to 0, 0 to 40, 40 to 42 and above 42 C. The end points at a step are
+        //simulated just inside their tier. The range changes fastest within a few degrees of a step (a short
+        //drive crosses it or not), so the segments next to the steps are finer.
+        Axis tempAxes[5];
+        int firstColumn[5]; //Column of each segment's first point in a row of the table
+        vector<float> table; //Rows of TEMP_POINTS temperatures (segment by segment), one row per SOC, SOC_POINTS rows per speed point
+
+        void setAxis(Axis &axis, float first, float last, int count);
+
+    public:
+        static const int SLOW_POINTS = 4; //1 to 10 m/s every 3 m/s
+        static const int FAST_POINTS = 10; //10 to 100 m/s every 10 m/s
+        static const int SPEED_POINTS = SLOW_POINTS + FAST_POINTS;
+        static const int SOC_POINTS = 21; //Every 5%
+        static const int COARSE_POINTS = 7; //-20 to -2 and 42 to 60 C every 3 C
+        static const int FINE_POINTS = 5; //2 C next to a step every 0.5 C
+        static const int MILD_POINTS = 9; //0 to 40 C every 5 C
+        static const int TEMP_POINTS = 2 * COARSE_POINTS + 2 * FINE_POINTS + MILD_POINTS;
+
+        RangeOracle();
+
+        //@brief simulate the grid for a battery at an ambient temperature
+        void build(const Battery &battery, float ambientTemp);
+        //@return distance (m) until the battery is empty cruising at a speed; queries outside the grid are clamped to it
+        float range(float speed, float SOC, float batteryTemp) const;
+
+        bool is_built() const;
+        size_t bytes() const;
+};
+
+//@brief the reference the table is built from: cruise at a constant speed until the battery is empty
+//(Battery::dischargeRate drains the charge, Battery::heatBalance moves the temperature) with steps of at most dt
+//@return distance (m)
+float simulateRange(Battery &battery, float SOC, float batteryTemp, float speed, float ambientTemp, float dt);
+
+//Largest error of range() against simulateRange the check accepts, on average and at any point. The largest
+//errors are a few degrees from a discharge step, where a cruise crosses the step or not.
+const double RANGE_MEAN_TOLERANCE = 0.01;
+const double RANGE_MAX_TOLERANCE = 0.05;
+
+//Command line check: build time, query latency and interpolation error against simulateRange
+//@return 0 if the error is within the tolerances above, 1 otherwise
+int runRangeOracleCheck();
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef REGRESSION_H
+#define REGRESSION_H
+#include <string>
+#include <vector>
+using namespace std;
+
+//Behavior regression checks. A scenario is a short scripted run of one Simulation that exercises one
+//part of the physics (driving, braking with regen, charging, a thermal soak while parked, or charge
+//cycles wearing the battery) under one set of conditions. Its trace is the vehicle state sampled at a
+//fixed interval; battery wear (Battery::wear) is applied every step as in the aging
+//projection, so SOH is part of it. --regress runs the whole library in parallel and compares every trace
+//with the golden trace stored for the scenario, so a change to a constant in components.cpp shows up as
+//the scenarios and channels it moved, and the first time each one left its tolerance.
+//
+//The fleet and the compile-time vehicle model copy the Simulation equations instead of calling them, so
+//every scenario also runs on them and their traces are compared with the Simulation trace: a constant
+//changed in one copy only shows up as a model that left Simulation, not as a golden trace. The parked
+//soaks also run with Simulation::park, which skips each trace interval in one jump.
+enum ScenarioKind{
+    SCENARIO_DRIVE, //Constant throttle from standstill
+    SCENARIO_BRAKE, //Full throttle, then braking (regen) to a stop
+    SCENARIO_CHARGE, //Parked with the charger plugged in
+    SCENARIO_SOAK, //Parked (optionally charging) while the battery temperature settles to the ambient
+    SCENARIO_CYCLE //The scripted driver for an hour, long enough to complete charge cycles
+};
+
+struct Scenario{
+    string name;
+    ScenarioKind kind;
+    float ambientTemp; //C
+    float startSOC; //%
+    float startTemp; //Battery temperature at the start (C)
+    float intensity; //Throttle (drive), brake (brake), charging on/off (soak) or battery capacity in Ah (cycle)
+    float duration; //s
+    float traceInterval; //s between trace rows
+};
+
+//What runs a scenario
+enum ScenarioModel{
+    MODEL_SIMULATION, //One Simulation
+    MODEL_FLEET_SIMD, //A Standard fidelity Fleet, traced vehicle in the first lane of the batch battery kernels
+    MODEL_FLEET_SCALAR, //The same Fleet, traced vehicle in the scalar tail after the kernels' last full batch
+    MODEL_STATIC, //StaticSimulation<DefaultVehicleSpec>: no battery wear (SOH stays 1), default capacity only
+    MODEL_FAST_FORWARD //Simulation::park between trace rows: parked soaks without the charger only, no battery wear
+};
+const int SCENARIO_MODELS = 5;
+extern const char* const scenarioModelNames[SCENARIO_MODELS];
+
+//Channels of a trace after the time, and how far a value may be from the golden one:
+//|actual - golden| <= absolute + relative * |golden|
+const int TRACE_CHANNELS = 5;
+struct ChannelTolerance{
+    const char* name;
+    float absolute;
+    float relative;
+};
+extern const ChannelTolerance traceTolerances[TRACE_CHANNELS]; //Speed, SOC, BatteryTemp, SOH, Current
+
+//Rows of TRACE_CHANNELS + 1 floats (time first)
+struct ScenarioTrace{
+    vector<float> rows;
+
+    size_t size() const;
+};
+
+//@brief the scenario library: every kind over a grid of ambient temperatures, starting states and inputs
+vector<Scenario> regressionScenarios();
+
+//@brief run a scenario from a fresh vehicle with a fixed time step
+//@return the trace, empty if the model cannot run the scenario (a cycle scenario with another capacity on
+//MODEL_STATIC, anything but a parked soak on MODEL_FAST_FORWARD)
+ScenarioTrace runScenario(const Scenario &scenario, float dt, ScenarioModel model = MODEL_SIMULATION);
+
+//@brief check that the rates the adaptive integrator and the range oracle use (Battery::dischargeRate,
+//chargeRate, heatBalance) are the ones discharge, charge and updateTemperature apply over a step
+//@return true if every rate matches
+bool checkBatteryRates();
+
+struct RegressionOptions{
+    string goldenPath; //Golden traces (CSV: Scenario,Time, then the channels)
+    string filter; //Only run scenarios whose name contains this text
+    int threads;
+    float dt;
+    bool update; //Write the traces as the new golden traces instead of comparing
+
+    RegressionOptions();
+};
+
+//Command line regression run
+//@return 0 if every scenario matched its golden trace and every model matched Simulation, 1 otherwise
+int runRegression(const RegressionOptions &options);
+
+#endif
@@ -0,0 +1,126 @@
+#ifndef ROUTE_H
+#define ROUTE_H
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_map>
+#include "../headers/driver_input.h"
+#include "../headers/vehicle.h"
+#include "../headers/components.h"
+using namespace std;
+
+//One stretch of road with constant properties
+struct RouteSegment{
+    float length; //m
+    float grade; //Rise over run, positive uphill
+    float speedLimit; //m/s, the driver holds this speed
+    float ambientTemp; //C
+};
+
+//What driving a route (or one segment of it) does to the vehicle
+struct RouteEstimate{
+    float SOC; //At arrival (%)
+    float chargeUsed; //Ah drawn from the battery (negative if regen recovered more than was drawn)
+    float energyUsed; //kWh at the battery's nominal voltage
+    float time; //s
+    float speed; //At arrival (m/s)
+    float batteryTemp; //At arrival (C)
+    int cachedSegments; //Segments answered from the cache
+};
+
+//Estimates the energy and the SOC at arrival of routes by driving each segment behind a speed-holding driver.
+//The speed follows the Motor's torque balance slowed by the EV's road load (grade, rolling resistance and
+//drag), and the battery supplies the tractive power (road load + m*a) * v at its voltage, so a climb or a
+//higher speed costs more charge. Braking recovers part of the braking power through regen.
+//
+//Segment results are cached by (vehicle, entry state bucket, segment). The entry state (speed, SOC and
+//battery temperature) is rounded to a bucket and the segment is driven from the bucket's state, so a
+//cached result does not depend on which query computed it; the changes it caused (charge drawn, exit
+//speed, temperature change) are then applied to the query's actual state. Routes that share segments and
+//arrive at them in similar states are answered mostly from the cache.
+class RouteEstimator{
+
+    private:
+        struct Vehicle{
+            Motor motor;
+            Battery battery;
+            EV body;
+        };
+
+        struct SegmentKey{
+            int vehicle;
+            int speedBucket;
+            int SOCBucket;
+            int tempBucket;
+            uint32_t segment[4]; //Bits of length, grade, speedLimit, ambientTemp
+
+            bool operator==(const SegmentKey &other) const;
+        };
+        struct SegmentKeyHash{
+            size_t operator()(const SegmentKey &key) const;
+        };
+
+        //Changes caused by driving a segment from a bucket's state
+        struct SegmentResult{
+            float chargeUsed; //Ah
+            float time;
+            float exitSpeed;
+            float tempChange;
+        };
+
+        vector<Vehicle> vehicles;
+        unordered_map<SegmentKey, SegmentResult, SegmentKeyHash> cache;
+        float dt;
+        long long hits;
+        long long misses;
+
+        SegmentResult driveSegment(int vehicle, const RouteSegment &segment, float speed, float SOC, float batteryTemp);
+
+    public:
+        //Bucket widths of the entry state
+        static constexpr float SPEED_BUCKET = 1; //m/s
+        static constexpr float SOC_BUCKET = 5; //%
+        static constexpr float TEMP_BUCKET = 2; //C
+
+        RouteEstimator(float dt = 0.1);
+
+        //@brief register a vehicle (the components are copied)
+        //@return its index, used in estimate()
+        int addVehicle(const Motor &motor, const Battery &battery, const EV &body);
+
+        //@brief drive a route starting from rest
+        //@param useCache - false drives every segment from the exact state (no buckets, nothing cached)
+        RouteEstimate estimate(int vehicle, const vector<RouteSegment> &route, float SOC, float batteryTemp, bool useCache = true);
+
+        void clearCache();
+        size_t cacheSize();
+        long long get_hits();
+        long long get_misses();
+};
+
+//@brief read routes from a CSV file with Route,Length,Grade,SpeedLimit,Ambient columns (rows of a route are
+//consecutive and in driving order)
+bool loadRoutes(const string &path, vector<vector<RouteSegment>> &routes);
+
+//Settings of the route estimator benchmark
+struct RouteQueryOptions{
+    string routesPath; //CSV routes, empty for generated routes over a shared road network
+    int queries;
+    int routes; //Generated routes
+    int roadSegments; //Distinct segments of the generated road network
+    int checkQueries; //Queries also answered without the cache to measure the error of the buckets
+    float dt;
+    unsigned int seed;
+
+    RouteQueryOptions();
+};
+
+//@brief checks of the route energy model that need no golden values: a climb costs more charge than the same
+//road on the flat (and a descent less), and the charge per km on the flat grows with the speed (drag)
+//@return true if every check passed
+bool checkRouteEnergy();
+
+//Command line route benchmark: p50/p99 query latency, cache hit rate and error against uncached estimates
+int runRouteQueries(const RouteQueryOptions &options);
+
+#endif
@@ -0,0 +1,110 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "../headers/driver_input.h"
+#include "../headers/vehicle.h"
+#include "../headers/components.h"
+#include "../headers/integrator.h"
+#include "../headers/telemetry_sampling.h"
+#include "../headers/fleet.h"
+using namespace std;
+
+//The simulation core. It owns one vehicle (driver input, motor, battery, EV body and charger) and
+//advances it by a given time step. Nothing in here depends on SFML, so the same code is used by the
+//interactive window loop in main.cpp and by the headless command line mode.
+class Simulation{
+
+    private:
+        DriverInput input;
+        Motor motor;
+        Battery battery;
+        EV vehicle;
+        Charger charger;
+        float ambientTemp; //Temperature of the environment in Celsius
+        double totalTime; //Simulated time in seconds since the session started (double so long runs do not drift)
+        float vehicleSpeed; //Speed returned by the last motor update
+
+        bool isIdle();
+        long long stepUntilIdle(long long maxSteps, float delta_t, bool charging);
+        void skipIdleSteps(long long steps, float delta_t, bool charging);
+
+    public:
+        Simulation();
+        Simulation(float ambientTemp);
+
+        //Replace the vehicle components (used when the user enters new parameters)
+        void configure(const Motor &newMotor, const Battery &newBattery, const EV &newVehicle);
+
+        void step(float delta_t, bool charging);
+        //@brief step, then wear the battery for the step (Battery::wear)
+        //@return charge drawn over the step (Ah, negative if the battery gained charge)
+        float stepWithWear(float delta_t, bool charging);
+
+        //Fast-forward: the same result as calling step(delta_t, ...) over and over, but the time the
+        //vehicle stands still is skipped in one jump instead of stepped frame by frame
+        double chargeUntilFull(double maxSeconds, float delta_t);
+        void park(double seconds, float delta_t);
+
+        //Advance by duration with the adaptive integrator instead of one Euler step (inputs held constant)
+        void advance(float duration, bool charging, const IntegratorOptions &options, IntegratorStats &stats);
+
+        //Complete state as a versioned binary snapshot (see snapshot.h). Restoring is all or nothing: a damaged
+        //or unreadable snapshot leaves the simulation unchanged and returns false.
+        void saveSnapshot(vector<uint8_t> &bytes);
+        bool restoreSnapshot(const vector<uint8_t> &bytes);
+        //An independent copy that continues exactly like this one (for branching what-if runs from one state)
+        Simulation fork() const;
+
+        DriverInput& get_input();
+        Motor& get_motor();
+        Battery& get_battery();
+        EV& get_vehicle();
+        Charger& get_charger();
+
+        double get_time();
+        float get_speed();
+        float get_ambientTemp();
+        void set_ambientTemp(float T);
+};
+
+//Settings for a headless (no window) run
+struct HeadlessConfig{
+    float dt; //Fixed time step in seconds
+    float duration; //Simulated time to run in seconds
+    float ambientTemp; //Ambient temperature in Celsius
+    string logPath; //Log file to write (.csv for text, binary columnar otherwise), empty for no logging
+    SamplingPolicy logSampling; //Which rows of the log to keep, applied to every channel but the time
+    string cycle; //Drive cycle to replay (built-in name or CSV trace), empty for the scripted driver
+    bool adaptive; //Integrate each dt with the adaptive integrator instead of one Euler step
+    string loadStatePath; //Snapshot to continue from, empty to start fresh
+    string saveStatePath; //Where to save a snapshot at the end, empty for none
+    string tablesPath; //Battery curves for the table-driven model, empty for the fixed model
+    IntegratorOptions integrator;
+    //Model level. Standard steps the Simulation; reduced and detailed step a one-vehicle Fleet configured from
+    //the Simulation's components, with the same driver (not with --adaptive, --battery-tables or snapshots).
+    Fidelity fidelity;
+
+    HeadlessConfig();
+};
+
+//Scripted driver used by headless runs when no other input source is given
+void scriptedDriver(double time, Battery &battery, DriverInput &input, bool &charging);
+void scriptedDriver(double time, float SOC, DriverInput &input, bool &charging);
+
+int runHeadless(const HeadlessConfig &config);
+
+//Largest differences of fast-forward from stepping frame by frame. Every frame rounds the temperature to a
+//float, which moves the stepped relaxation by up to half a float spacing per frame; the closed forms do not
+//round per frame. The error decays with the relaxation, so it stays within a few hundredths of a degree.
+const double FAST_FORWARD_TIME_TOLERANCE = 1e-3; //s
+const float FAST_FORWARD_SOC_TOLERANCE = 1e-3; //%
+const float FAST_FORWARD_TEMP_TOLERANCE = 0.05; //C
+const float FAST_FORWARD_CURRENT_TOLERANCE = 1e-3; //A
+
+//Command line check: compares chargeUntilFull and park with stepping frame by frame
+//@return 0 if fast-forward is within the tolerances above, 1 otherwise
+int runFastForwardCheck();
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+//Binary snapshots of the full simulation state (.evss). Layout, all numbers little-endian:
+//
+//  header:   "EVSS", uint32 version
+//  sections: 4-character tag, uint32 byte length, then the fields of one component
+//
+//Sections: "DRVR" DriverInput, "MOTR" Motor, "BATT" Battery, "EVBD" EV, "CHRG" Charger and "SIMU" the
+//Simulation's own clock, speed and ambient temperature. Floats are stored as their bit patterns, so a
+//restored run continues bit for bit like the original. Readers skip sections they do not know, and a
+//section may be longer than what a reader takes from it, so later versions can append fields.
+
+const uint32_t SNAPSHOT_VERSION = 1;
+
+//Writes the fields of one section after the other
+class StateWriter{
+
+    private:
+        vector<uint8_t> &bytes;
+        size_t sectionStart; //Where the length of the open section goes
+
+    public:
+        StateWriter(vector<uint8_t> &bytes);
+
+        void beginSection(const char* tag);
+        void endSection();
+
+        void putFloat(float value);
+        void putDouble(double value);
+        void putBool(bool value);
+};
+
+//Reads the fields of one section back. Reading past the end of the section fails the reader instead of
+//reading into the next one.
+class StateReader{
+
+    private:
+        const uint8_t* data;
+        size_t size;
+        size_t position;
+        bool ok;
+        uint32_t version;
+
+    public:
+        StateReader(const uint8_t* data, size_t size, uint32_t version);
+
+        float getFloat();
+        double getDouble();
+        bool getBool();
+
+        bool is_ok();
+        uint32_t get_version();
+};
+
+//@brief find a section of a snapshot
+//@return a reader over the section, which is not ok if the snapshot has no such section
+StateReader findSection(const vector<uint8_t> &bytes, const char* tag);
+
+//@brief check the header of a snapshot
+//@return the version, or 0 if the bytes are not a snapshot this build can read
+uint32_t snapshotVersion(const vector<uint8_t> &bytes);
+
+bool writeSnapshotFile(const string &path, const vector<uint8_t> &bytes);
+bool readSnapshotFile(const string &path, vector<uint8_t> &bytes);
+
+//Command line check: saves a warmed-up run, restores it and forks many what-if continuations from it
+int runSnapshotCheck();
+
+#endif
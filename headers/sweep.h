@@ -0,0 +1,71 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+#include <string>
+#include <vector>
+using namespace std;
+
+class DriveCycle;
+struct BatteryTables;
+
+//One vehicle configuration: the parameters of Battery(float,float,float,float), Motor(float,float) and EV(float)
+struct SweepConfig{
+    float capacity; //Battery Q_max (Ah)
+    float V_max; //Battery max voltage (V)
+    float R_internal; //Battery internal resistance (Ohm)
+    float heatCapacity; //Battery heat capacity (J/C)
+    float maxTorque; //Motor max torque (Nm)
+    float maxSpeed; //Motor max speed
+    float wheelRadius; //EV wheel radius (m)
+};
+
+//What one configuration did over the drive cycle
+struct SweepResult{
+    float finalSOC; //%
+    float peakTemp; //Highest battery temperature (C)
+    float SOH; //Battery state of health at the end (1 == 100%), with thermal and cycle wear applied every step
+    float distanceKm;
+};
+
+//A grid of configurations. Every parameter has a list of values (a single default value unless set),
+//and the grid is every combination of them. Configurations are numbered so a sweep can be resumed.
+class ParameterSweep{
+
+    private:
+        vector<string> names; //Command line names of the parameters, in SweepConfig order
+        vector<vector<float>> values;
+
+    public:
+        ParameterSweep();
+
+        //@brief set the values of a parameter from "a:b:n" (n evenly spaced values from a to b),
+        //"v1,v2,..." (a list) or "v" (one value)
+        //@return false if the name or the values are invalid
+        bool setValues(const string &name, const string &spec);
+
+        const vector<string>& get_names();
+        long long size();
+        SweepConfig config(long long index);
+};
+
+//@brief drive one configuration through the cycle from a full battery
+//@param tables - battery curves shared by every configuration (nullptr for the fixed model)
+SweepResult runConfiguration(const SweepConfig &config, DriveCycle &cycle, float delta_t, float duration, float ambientTemp,
+                             const BatteryTables* tables = nullptr);
+
+struct SweepOptions{
+    string cycle; //Drive cycle (built-in name or CSV trace)
+    float dt;
+    float duration; //Simulated seconds per configuration
+    float ambientTemp;
+    int threads;
+    string outputPath; //Results table (CSV)
+    bool resume; //Keep the rows already in outputPath and only run the missing configurations
+    string tablesPath; //Battery curves (loaded once and shared by all threads), empty for the fixed model
+
+    SweepOptions();
+};
+
+//Command line sweep: runs every configuration of the grid in parallel and writes the results table
+int runSweep(ParameterSweep &sweep, const SweepOptions &options);
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+using namespace std;
+
+//Binary columnar telemetry log (.evtl). Layout, all numbers little-endian:
+//
+//  header:  "EVTL", uint32 version, uint32 block size (rows), uint32 channel count,
+//           then per channel: uint8 type, uint8 encoding, uint8 name length, name characters
+//  blocks:  uint32 row count, then per channel: uint32 byte length + the column data
+//
+//Every channel is a float32 column (type 1). A column is stored either raw (encoding 0: rowCount
+//fixed-width floats) or delta encoded (encoding 1: the difference between the bit patterns of each value
+//and the previous one, zigzag + varint coded). Delta encoding is lossless and turns slowly changing
+//channels like SOC and BatteryTemp into about one byte per row.
+
+const uint8_t TELEMETRY_TYPE_FLOAT32 = 1;
+const uint8_t TELEMETRY_RAW = 0;
+const uint8_t TELEMETRY_DELTA = 1;
+const uint32_t TELEMETRY_MAX_BLOCK_ROWS = 1 << 20; //Readers reject logs with larger blocks (damaged headers)
+
+//One row of the standard log (same columns as output.csv)
+struct TelemetryRecord{
+    float time;
+    float speed;
+    float soc;
+    float batteryTemp;
+    float throttle;
+    float brake;
+};
+
+const int TELEMETRY_STANDARD_CHANNELS = 6;
+
+struct TelemetryChannel{
+    string name;
+    uint8_t encoding;
+};
+
+//Channels of the standard log, optionally delta encoding the slowly changing ones
+vector<TelemetryChannel> standardTelemetryChannels(bool deltaEncoding);
+
+class TelemetryWriter{
+
+    private:
+        ofstream file;
+        vector<TelemetryChannel> channels;
+        vector<float> block; //Rows of the current block, stored column by column
+        int blockSize; //Rows per block
+        int rows; //Rows in the current block
+        vector<uint8_t> encoded; //Scratch buffer for one encoded column
+
+        void flushBlock();
+
+    public:
+        TelemetryWriter();
+        ~TelemetryWriter();
+
+        bool open(const string &path, const vector<TelemetryChannel> &channels, int blockSize = 4096);
+        bool is_open();
+        void write(const float* row);
+        void write(const TelemetryRecord &record);
+        void close();
+};
+
+class TelemetryReader{
+
+    private:
+        ifstream file;
+        vector<TelemetryChannel> channels;
+        uint32_t blockSize;
+        uint64_t fileSize; //Bytes, to check the lengths read from the file before allocating for them
+        vector<uint8_t> encoded;
+        bool damaged; //Reading stopped at a damaged or cut off block instead of the end of the file
+
+        //@return false, after marking the log damaged
+        bool fail();
+
+    public:
+        TelemetryReader();
+
+        bool open(const string &path);
+        const vector<TelemetryChannel>& get_channels();
+
+        //Read the next block into one vector per channel. Row counts and column lengths are checked against
+        //the block size and the bytes left in the file first, so a damaged block fails instead of allocating.
+        //@return false at the end of the file, or at a damaged block (then is_damaged() is true)
+        bool readBlock(vector<vector<float>> &columns);
+        bool is_damaged() const;
+};
+
+//@brief convert a binary log back to the Time,Speed,SOC,BatteryTemp,Throttle,Brake CSV that graph.py reads
+//@return false if a file cannot be opened or the log is damaged (the blocks before the damage are written)
+bool convertTelemetryToCsv(const string &binaryPath, const string &csvPath);
+
+//@return true if the path ends in .csv (text log) rather than the binary format
+bool isCsvPath(const string &path);
+
+//Fixed-width little-endian helpers, whatever the machine's byte order is (also used by the state snapshots)
+void putU32(vector<uint8_t> &out, uint32_t value);
+uint32_t getU32(const uint8_t* in);
+uint32_t floatBits(float value);
+float bitsFloat(uint32_t bits);
+
+#endif
@@ -0,0 +1,93 @@
+#ifndef TELEMETRY_SAMPLING_H
+#define TELEMETRY_SAMPLING_H
+#include <string>
+#include <vector>
+#include "../headers/telemetry.h"
+using namespace std;
+
+//Write-time downsampling of telemetry. A TelemetrySampler sits between whoever produces rows (one per
+//physics step) and the log file, and decides per channel which rows are worth keeping:
+//  - every row: the channel never drops a row (what the log did before)
+//  - fixed rate: a row every interval seconds
+//  - on change: a row when the value moved more than the deadband since the last row written, and at
+//    least every interval seconds if an interval is set (a heartbeat through idle stretches)
+//  - bucket: a row every interval seconds with the mean of the rows it replaces in the channel's column and
+//    their min and max in two extra columns (<name>_min, <name>_max)
+//A row is written when any channel asks for one, with every channel's value at that time. When a change
+//ends a stretch of dropped rows, the last dropped row is written first so the flat stretch stays flat
+//when the points are joined by lines. Column 0 is the time and has no policy. The first and last rows
+//are always written.
+enum SamplingMode{
+    SAMPLE_EVERY_ROW,
+    SAMPLE_FIXED_RATE,
+    SAMPLE_ON_CHANGE,
+    SAMPLE_BUCKET
+};
+
+struct SamplingPolicy{
+    SamplingMode mode;
+    float interval; //s
+    float deadband;
+
+    SamplingPolicy();
+    SamplingPolicy(SamplingMode mode, float interval, float deadband);
+};
+
+//@brief parse "all", "change[:deadband[:heartbeat]]", "rate:<seconds>" or "bucket:<seconds>"
+//@return false (with a message) if the text is not a policy
+bool parseSamplingPolicy(const string &text, SamplingPolicy &policy);
+
+//Policies of the window's log: the standard channels on change with deadbands below what the HUD and
+//graph.py show, with a one second heartbeat
+vector<SamplingPolicy> windowSamplingPolicies();
+
+class TelemetrySampler{
+
+    private:
+        vector<TelemetryChannel> inputChannels;
+        vector<TelemetryChannel> outputChannels;
+        vector<SamplingPolicy> policies; //One per input channel (the time's is not used)
+        vector<float> previous; //Last input row
+        bool previousWritten;
+        bool started;
+        vector<float> lastWritten; //Value of each channel in the last row written
+        double lastWrittenTime;
+        vector<double> nextDue; //Fixed rate and bucket: time of the next row
+        vector<float> minimum, maximum; //Bucket channels: over the rows since the last row written
+        vector<double> sum;
+        int accumulated;
+        long long rowsIn;
+        long long rowsOut;
+
+        void accumulate(const float* row);
+        void emit(const float* row, vector<float> &out);
+
+    public:
+        TelemetrySampler();
+
+        //@param channels - input columns, the first one is the time; policies - one per channel (or empty for every row)
+        //@return false if the number of policies does not match
+        bool configure(const vector<TelemetryChannel> &channels, const vector<SamplingPolicy> &policies);
+        const vector<TelemetryChannel>& get_outputChannels() const;
+
+        //@brief offer one input row; rows to write are appended to out (output channel count floats each)
+        //@return number of rows appended (0 to 2)
+        int push(const float* row, vector<float> &out);
+        //@brief the last input row if it was not written yet (call at the end of the log)
+        int flush(vector<float> &out);
+
+        long long get_rowsIn() const;
+        long long get_rowsOut() const;
+};
+
+//@brief Largest-Triangle-Three-Buckets decimation: picks points of (x, y) that keep the visual shape of
+//the line. The first and last points are kept and one point is picked per bucket in between, the one
+//spanning the largest triangle with the point picked before and the mean of the next bucket.
+//@return indices of the picked points, in order (all of them if there are no more than points)
+vector<size_t> largestTriangleThreeBuckets(const vector<float> &x, const vector<float> &y, size_t points);
+
+//@brief decimate a log for plotting: LTTB on every channel against the time, and the rows picked for any
+//channel are written to a CSV file
+bool decimateLog(const string &path, const string &csvPath, size_t points);
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <memory>
+using namespace std;
+
+//A work-stealing thread pool. run() splits a job into numbered tasks, deals them out to one queue per
+//thread and returns when every task is finished, so each call acts as a barrier (one call per time step).
+//Threads take tasks from the front of their own queue and, when it is empty, steal from the back of
+//the other queues. The thread that calls run() works as thread 0, so a pool of size 1 starts no threads.
+class ThreadPool{
+
+    private:
+        struct TaskQueue{
+            mutex lock;
+            deque<int> tasks;
+        };
+
+        vector<thread> workers;
+        vector<unique_ptr<TaskQueue>> queues;
+        function<void(int)> job; //The job of the current run, called with a task number
+
+        mutex stateLock;
+        condition_variable wake; //Signals the workers that a new run started (or the pool is stopping)
+        condition_variable done; //Signals run() that the last task finished
+        int generation; //Number of runs started so far
+        bool stopping;
+        atomic<int> remaining; //Tasks of the current run that have not finished yet
+        atomic<long long> steals; //Tasks taken from another thread's queue (for statistics)
+
+        bool popTask(int thread, int &task);
+        void workLoop(int thread);
+        void workerMain(int thread);
+
+    public:
+        ThreadPool(int threads);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        int size() const;
+        long long get_steals() const;
+
+        void run(int taskCount, const function<void(int)> &task);
+};
+
+#endif
@@ -5,6 +5,9 @@
 #include <iostream>
 using namespace std;
 
+class StateWriter;
+class StateReader;
+
 class EV{
     private:
         bool on;
@@ -33,6 +36,15 @@ class EV{
         void setWheelRadius(float r);
         void setDragCoefficient(float c);
         void setFrontalArea(float a);
+        float get_mass();
+
+        //Force resisting the vehicle at a speed on a grade: climbing, rolling resistance and aerodynamic drag (N).
+        //Zero with the default mass, drag coefficient and frontal area of 0.
+        float roadLoadForce(float speed, float grade);
+
+        //Snapshot section "EVBD" (see snapshot.h). The battery and motor pointers are not part of it.
+        void saveState(StateWriter &out);
+        bool loadState(StateReader in);
     };
 
 
@@ -0,0 +1,224 @@
+#ifndef VEHICLE_MODEL_H
+#define VEHICLE_MODEL_H
+#include "../headers/driver_input.h"
+using namespace std;
+
+//Compile-time vehicle models. Battery, Motor and EV keep every parameter in a runtime member, so the
+//stepping code has to load them and cannot fold them (for example 0.8 * maxTorque for the passive drag or
+//the 1000 * R_internal of charging). Here a vehicle is a spec type whose parameters are constexpr, and
+//StaticBattery, StaticMotor and StaticSimulation are specialized per spec: the compiler folds the
+//parameters into the stepping code and inlines the whole step.
+//
+//The equations are the same as in components.cpp, written with the same types and in the same order, so a
+//StaticSimulation<Spec> gives bit for bit the same results as a Simulation built with the same parameters
+//(--check-static-model checks this). Only the state that a step changes is kept in the objects. The runtime
+//classes stay for everything configured at run time (the window, sweeps, fleets).
+
+//The default vehicle (the parameters of Battery(), Motor(), EV() and Charger())
+struct DefaultVehicleSpec{
+    //Battery
+    static constexpr float Q_max = 150; //Ah
+    static constexpr float V_max = 420;
+    static constexpr float R_internal = 0.02;
+    static constexpr float batteryHeatCapacity = 1000; //J/C
+    static constexpr float batteryHeatTransfer = 0.6; //W/C
+    static constexpr float baseDischargeRate = 10;
+    static constexpr float coldDischargeFactor = 0.7; //Below 0 C
+    static constexpr float hotDischargeFactor = 1.2; //Above 40 C
+
+    //Motor
+    static constexpr float maxTorque = 200; //Nm
+    static constexpr float maxSpeed = 100; //m/s
+    static constexpr float maxBrakeTorque = 300; //Nm
+    static constexpr float inertia = 10; //kg * m^2
+    static constexpr float regenEfficiency = 0.5;
+    static constexpr float maxRegenPower = 100; //W
+    static constexpr double dragFactor = 0.8; //Passive drag torque as a fraction of maxTorque
+
+    //EV
+    static constexpr float wheelRadius = 0.5; //m
+
+    //Charger
+    static constexpr double chargerVoltageFactor = 0.2; //Charging voltage as a fraction of V_max
+};
+
+//A small city car: smaller battery, weaker motor, smaller wheels
+struct CityVehicleSpec : DefaultVehicleSpec{
+    static constexpr float Q_max = 60;
+    static constexpr float V_max = 360;
+    static constexpr float batteryHeatCapacity = 600;
+    static constexpr float maxTorque = 150;
+    static constexpr float maxSpeed = 40;
+    static constexpr float wheelRadius = 0.3;
+};
+
+template <class Spec>
+class StaticBattery{
+
+    private:
+        float Q_now;
+        float current;
+        float temperature;
+
+    public:
+        StaticBattery(){
+            Q_now = Spec::Q_max;
+            current = 0;
+            temperature = 25;
+        }
+
+        float get_SOC(){
+            return (Q_now / Spec::Q_max) * 100.0;
+        }
+        float get_Q_current(){ return Q_now; }
+        float get_temp(){ return temperature; }
+        float get_current(){ return current; }
+        void set_Q_current(float Q){ Q_now = Q; }
+        void set_temp(float T){ temperature = T; }
+        void setCurrent(float I){ current = I; }
+
+        //@brief same as Battery::discharge
+        void discharge(float speed, float delta_t){
+            float tempFactor = temperature < 0 ? Spec::coldDischargeFactor : (temperature > 40.0 ? Spec::hotDischargeFactor : 1.0f);
+            float deltaQ = Spec::baseDischargeRate * speed * delta_t * tempFactor / 3600;
+            Q_now -= deltaQ;
+            current += -deltaQ / delta_t;
+            if (Q_now < 0){
+                current = 0;
+                Q_now = 0;
+            }
+        }
+
+        //@brief same as Battery::charge
+        //@return true if the battery was already full
+        bool charge(float V_applied, float delta_t){
+            float deltaQ = delta_t * V_applied / (1000 * Spec::R_internal);
+            if (Q_now < Spec::Q_max){
+                Q_now += deltaQ;
+                if (Q_now >= Spec::Q_max){
+                    Q_now = Spec::Q_max;
+                }
+                return false;
+            }
+            current = 0;
+            return true;
+        }
+
+        //@brief same as Battery::rechargeFromRegen
+        void rechargeFromRegen(float deltaQ){
+            Q_now += deltaQ;
+            if (Q_now > Spec::Q_max){
+                Q_now = Spec::Q_max;
+            }
+        }
+
+        //@brief same as Battery::updateTemperature
+        float updateTemperature(float delta_t, float ambientTemp){
+            float heatGenerated = 0.00001 * current * current * Spec::R_internal * delta_t;
+            float cooling = Spec::batteryHeatTransfer * (temperature - ambientTemp) * delta_t;
+            float netHeat = heatGenerated - cooling;
+            temperature += netHeat / Spec::batteryHeatCapacity;
+            return temperature;
+        }
+};
+
+template <class Spec>
+class StaticMotor{
+
+    private:
+        float speed; //m/s
+        float angularSpeed; //rad/s
+
+    public:
+        StaticMotor(){
+            speed = 0;
+            angularSpeed = 0;
+        }
+
+        float get_angularSpeed(){ return angularSpeed; }
+        void set_angularSpeed(float w){ angularSpeed = w; }
+
+        //@brief same as Motor::updateSpeed (with Motor::applyRegenerativeBraking and Motor::angularAcceleration)
+        float updateSpeed(float throttle, float brake, StaticBattery<Spec> &battery, float deltaTime){
+            if (speed > 0 && brake > 0){ //Regenerative braking
+                float regenTorque = brake * Spec::regenEfficiency * Spec::maxTorque;
+                float power = regenTorque * speed;
+                float regenPower = power > Spec::maxRegenPower ? Spec::maxRegenPower : power;
+                if (regenPower > 0){
+                    float regenCurrent = regenPower / Spec::V_max;
+                    battery.rechargeFromRegen(regenCurrent * deltaTime);
+                    battery.setCurrent(regenCurrent);
+                }
+            }
+
+            float netTorque = 0;
+            if (throttle > 0){
+                netTorque += throttle * Spec::maxTorque;
+            }
+            if (brake > 0){
+                netTorque -= brake * Spec::maxBrakeTorque;
+            }
+            if (throttle == 0 && brake == 0){
+                constexpr float dragTorque = Spec::dragFactor * Spec::maxTorque;
+                netTorque -= dragTorque;
+            }
+            angularSpeed += netTorque / Spec::inertia * deltaTime;
+            if (angularSpeed < 0.0){
+                angularSpeed = 0.0;
+            }
+
+            speed = Spec::wheelRadius * angularSpeed;
+            if (speed > Spec::maxSpeed){
+                speed = Spec::maxSpeed;
+            }
+            battery.discharge(speed, deltaTime);
+            return speed;
+        }
+};
+
+//Same stepping as Simulation::step, for a vehicle fixed at compile time
+template <class Spec>
+class StaticSimulation{
+
+    private:
+        DriverInput input;
+        StaticMotor<Spec> motor;
+        StaticBattery<Spec> battery;
+        bool isCharging;
+        float ambientTemp;
+        double totalTime;
+        float vehicleSpeed;
+
+    public:
+        StaticSimulation(float ambientTemp = 25){
+            this->ambientTemp = ambientTemp;
+            isCharging = false;
+            totalTime = 0;
+            vehicleSpeed = 0;
+        }
+
+        void step(float delta_t, bool charging){
+            totalTime += delta_t;
+            if (charging){
+                isCharging = true;
+                constexpr float chargingVoltage = Spec::chargerVoltageFactor * Spec::V_max;
+                if (battery.charge(chargingVoltage, delta_t)){
+                    isCharging = false;
+                }
+            }
+            vehicleSpeed = motor.updateSpeed(input.get_throttle(), input.get_brake(), battery, delta_t);
+            battery.updateTemperature(delta_t, ambientTemp);
+        }
+
+        DriverInput& get_input(){ return input; }
+        StaticMotor<Spec>& get_motor(){ return motor; }
+        StaticBattery<Spec>& get_battery(){ return battery; }
+        bool get_charging_state(){ return isCharging; }
+        double get_time(){ return totalTime; }
+        float get_speed(){ return vehicleSpeed; }
+};
+
+//Command line check: StaticSimulation against Simulation with the same parameters (must match bit for bit)
+int runStaticModelCheck();
+
+#endif
@@ -0,0 +1,349 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include "../headers/aging.h"
+#include "../headers/simulation.h"
+#include "../headers/drive_cycle.h"
+using namespace std;
+
+const double PI = 3.14159265358979323846;
+const int DAYS_PER_YEAR = 365;
+
+//default aging settings: one hour of the ECE-15 cycle a day in a temperate climate with hot summers.
+//The fade rates are realistic values (20% after 1000 cycles) instead of the showcase defaults of Battery.
+AgingOptions::AgingOptions(){
+    cycle = "ece15";
+    driveHours = 1;
+    dt = 0.016;
+    parkDt = 10;
+    ambientMean = 25;
+    seasonalSwing = 12;
+    dailySwing = 6;
+    cycleFade = 0.0002;
+    thermalFade = 2e-9;
+    years = 10;
+    sampleDays = 30;
+    validateDays = 365;
+    tolerance = 0.05;
+}
+
+//@brief the seasonal cosine of agingAmbient (1 around July 15, -1 in mid January)
+double seasonalCosine(double dayOfYear){
+    return cos(2 * PI * (dayOfYear - 196) / DAYS_PER_YEAR);
+}
+
+//@brief the daily cosine of agingAmbient (1 at 15:00, -1 at 3:00)
+double dailyCosine(double secondOfDay){
+    return cos(2 * PI * (secondOfDay - 15 * 3600) / 86400);
+}
+
+//@brief ambient temperature from the two cosines
+float combineAmbient(const AgingOptions &options, double seasonal, double daily){
+    return static_cast<float>(options.ambientMean + options.seasonalSwing * seasonal + options.dailySwing * daily);
+}
+
+float agingAmbient(const AgingOptions &options, double dayOfYear, double secondOfDay){
+    return combineAmbient(options, seasonalCosine(dayOfYear), dailyCosine(secondOfDay));
+}
+
+//@brief discharge tier of Battery::discharge at a temperature (-1 below 0 C, 1 above 40 C, 0 between)
+int dischargeTier(float temperature){
+    return temperature < 0 ? -1 : (temperature > 40.0 ? 1 : 0);
+}
+
+//The driving part of a day, recorded from one day and replayed for the others. Every day starts driving
+//from the same state (charged, standing still), and as long as the battery stays in one discharge tier
+//nothing of the drive depends on the battery temperature: speed, charge and current follow the same
+//trajectory every day, and only the temperature differs with the day's ambient. Another day's drive
+//is then stepped with Battery::updateTemperature alone, with the recorded current.
+struct DriveTrace{
+    bool recorded;
+    int tier; //Discharge tier the whole drive stayed in
+    float startQ; //Charge at the start of the drive (Ah)
+    vector<float> current; //Battery current during each step (A)
+    vector<double> daily; //dailyCosine at the start of each step
+    double throughputAh;
+    Simulation end; //State at the end of the drive
+
+    DriveTrace(){
+        recorded = false;
+        tier = 0;
+        startQ = 0;
+        throughputAh = 0;
+    }
+};
+
+//@brief one step of an aging day: set the ambient, step, and add the charge drawn and the time above 40 C
+void stepAgingDay(Simulation &sim, float step, float ambient, bool applyAging, DayAggregate &aggregate){
+    Battery &battery = sim.get_battery();
+    sim.set_ambientTemp(ambient);
+    float before = battery.get_Q_current();
+    sim.step(step, false);
+    float drawn = before - battery.get_Q_current();
+    if (drawn > 0){
+        aggregate.throughputAh += drawn;
+    }
+    float temp = battery.get_temp();
+    if (temp > 40){
+        aggregate.hotDegreeSeconds += (temp - 40) * static_cast<double>(step);
+    }
+    if (applyAging){
+        battery.wear(drawn, step);
+    }
+    aggregate.steps++;
+}
+
+//@brief park (key off, brake on) from t until end, in steps of at most parkDt that end exactly at end
+void parkAgingDay(Simulation &sim, const AgingOptions &options, int day, double &t, double end, bool applyAging, DayAggregate &aggregate){
+    sim.get_battery().setCurrent(0); //The drive's current stops when the vehicle is parked
+    sim.get_input().set_throttle(0.0);
+    sim.get_input().set_brake(1.0);
+    while (t < end){
+        float step = static_cast<float>(min(static_cast<double>(options.parkDt), end - t));
+        stepAgingDay(sim, step, agingAmbient(options, day % DAYS_PER_YEAR, t), applyAging, aggregate);
+        t += step;
+    }
+}
+
+//@brief drive the cycle from 8:00 for driveHours, recording the drive into trace if it is given
+void driveAgingDay(Simulation &sim, DriveCycle &cycle, const AgingOptions &options, int day, double &t, bool applyAging,
+                   DayAggregate &aggregate, DriveTrace* trace){
+    const double driveStart = 8 * 3600;
+    long long driveSteps = static_cast<long long>(options.driveHours * 3600.0 / options.dt + 0.5);
+    Battery &battery = sim.get_battery();
+    bool oneTier = true;
+    if (trace != nullptr){
+        trace->tier = dischargeTier(battery.get_temp());
+        trace->startQ = battery.get_Q_current();
+        trace->current.clear();
+        trace->daily.clear();
+    }
+    double throughputBefore = aggregate.throughputAh;
+    for (long long driveStep = 0; driveStep < driveSteps; driveStep++){
+        cycle.apply(driveStep * static_cast<double>(options.dt), sim.get_speed(), sim.get_input());
+        if (trace != nullptr){
+            oneTier = oneTier && dischargeTier(battery.get_temp()) == trace->tier;
+            trace->daily.push_back(dailyCosine(t));
+        }
+        stepAgingDay(sim, options.dt, agingAmbient(options, day % DAYS_PER_YEAR, t), applyAging, aggregate);
+        if (trace != nullptr){
+            trace->current.push_back(battery.get_current());
+        }
+        t = driveStart + (driveStep + 1) * static_cast<double>(options.dt);
+    }
+    t = max(t, driveStart + options.driveHours * 3600.0);
+    if (trace != nullptr){
+        trace->throughputAh = aggregate.throughputAh - throughputBefore;
+        trace->end = sim.fork();
+        trace->recorded = oneTier;
+    }
+}
+
+//@brief replay a recorded drive for another day: only the battery temperature is stepped
+//@return false (and the simulation untouched) if the day does not start like the trace or leaves its tier
+bool replayAgingDrive(Simulation &sim, const DriveTrace &trace, const AgingOptions &options, int day, double &t,
+                      DayAggregate &aggregate){
+    Battery battery = sim.get_battery();
+    if (battery.get_Q_current() != trace.startQ || sim.get_speed() != 0 || battery.get_current() != 0){
+        return false;
+    }
+    double seasonal = seasonalCosine(day % DAYS_PER_YEAR);
+    double hotDegreeSeconds = 0;
+    for (size_t k = 0; k < trace.current.size(); k++){
+        if (dischargeTier(battery.get_temp()) != trace.tier){
+            return false;
+        }
+        battery.setCurrent(trace.current[k]);
+        battery.updateTemperature(options.dt, combineAmbient(options, seasonal, trace.daily[k]));
+        float temp = battery.get_temp();
+        if (temp > 40){
+            hotDegreeSeconds += (temp - 40) * static_cast<double>(options.dt);
+        }
+    }
+
+    //Continue from the state the trace ended in, at this day's temperature
+    float temperature = battery.get_temp();
+    sim = trace.end.fork();
+    sim.get_battery().set_temp(temperature);
+    aggregate.throughputAh += trace.throughputAh;
+    aggregate.hotDegreeSeconds += hotDegreeSeconds;
+    aggregate.thermalSteps += trace.current.size();
+    t = max(8 * 3600 + trace.current.size() * static_cast<double>(options.dt), 8 * 3600 + options.driveHours * 3600.0);
+    return true;
+}
+
+//@brief one day. With traces (one per discharge tier, nullptr for none) the drive is replayed from the trace of
+//the tier it starts in, or simulated and recorded into it if that tier has no trace yet.
+DayAggregate simulateAgingDay(Simulation &sim, DriveCycle &cycle, const AgingOptions &options, int day, bool applyAging,
+                              DriveTrace* traces){
+    DayAggregate aggregate = {0, 0, 0, 0};
+
+    //Charged overnight
+    sim.get_battery().set_Q_current(sim.get_battery().get_Q_max());
+
+    double t = 0;
+    parkAgingDay(sim, options, day, t, 8 * 3600, applyAging, aggregate);
+    DriveTrace* trace = traces == nullptr || applyAging ? nullptr : &traces[dischargeTier(sim.get_battery().get_temp()) + 1];
+    if (trace == nullptr || !trace->recorded || !replayAgingDrive(sim, *trace, options, day, t, aggregate)){
+        driveAgingDay(sim, cycle, options, day, t, applyAging, aggregate, trace != nullptr && !trace->recorded ? trace : nullptr);
+    }
+    parkAgingDay(sim, options, day, t, 86400, applyAging, aggregate);
+    return aggregate;
+}
+
+DayAggregate simulateAgingDay(Simulation &sim, DriveCycle &cycle, const AgingOptions &options, int day, bool applyAging){
+    return simulateAgingDay(sim, cycle, options, day, applyAging, nullptr);
+}
+
+float extrapolateSOH(double throughputAh, double hotDegreeSeconds, float capacity, float cycleFade, float thermalFade){
+    double cycles = floor(throughputAh / capacity);
+    double soh = 1 - cycles * cycleFade - hotDegreeSeconds * thermalFade;
+    return static_cast<float>(soh < 0 ? 0 : soh);
+}
+
+//@brief set up a simulation the way every aging run starts: fade rates applied, battery at the
+//ambient temperature of midnight on the given day
+void prepareAgingSimulation(Simulation &sim, const AgingOptions &options, int day){
+    sim.get_battery().set_cycleFade(options.cycleFade);
+    sim.get_battery().set_thermalFade(options.thermalFade);
+    sim.get_battery().set_temp(agingAmbient(options, day, 0));
+}
+
+//Representative days of a year. The days are ranked by their ambient temperature and cut into groups of
+//sampleDays; the middle day of each group is simulated and stands for the whole group. Ranking by temperature
+//(instead of taking blocks of the calendar) keeps the hot days of a block together, so a group does not
+//average hot afternoons away with much cooler ones.
+struct YearSamples{
+    vector<DayAggregate> days; //One per group
+    vector<int> sampleOfDay; //Group of every day of the year
+};
+
+//@brief simulate the representative days of a year. The drive is simulated in full once and replayed for
+//the other days (see DriveTrace).
+//@return number of full steps simulated
+long long sampleYear(const AgingOptions &options, DriveCycle &cycle, YearSamples &samples){
+    vector<int> ranked(DAYS_PER_YEAR);
+    for (int d = 0; d < DAYS_PER_YEAR; d++){
+        ranked[d] = d;
+    }
+    //The daily swing is the same every day, so the seasonal term alone ranks the days
+    stable_sort(ranked.begin(), ranked.end(), [](int a, int b){ return seasonalCosine(a) < seasonalCosine(b); });
+
+    samples.days.clear();
+    samples.sampleOfDay.assign(DAYS_PER_YEAR, 0);
+    DriveTrace traces[3]; //Below 0 C, 0 to 40 C, above 40 C at the start of the drive
+    long long steps = 0;
+    for (int first = 0; first < DAYS_PER_YEAR; first += options.sampleDays){
+        int count = min(options.sampleDays, DAYS_PER_YEAR - first);
+        for (int r = first; r < first + count; r++){
+            samples.sampleOfDay[ranked[r]] = static_cast<int>(samples.days.size());
+        }
+        int day = ranked[first + count / 2]; //Middle of the days it stands for
+        Simulation sim;
+        prepareAgingSimulation(sim, options, day);
+        DriveCycle dayCycle = cycle;
+        samples.days.push_back(simulateAgingDay(sim, dayCycle, options, day, false, traces));
+        steps += samples.days.back().steps;
+    }
+    return steps;
+}
+
+//@brief add up the representative days standing for days [0, days)
+DayAggregate projectedTotals(const YearSamples &samples, long long days){
+    DayAggregate total = {0, 0, 0, 0};
+    for (long long d = 0; d < days; d++){
+        const DayAggregate &sample = samples.days[samples.sampleOfDay[d % DAYS_PER_YEAR]];
+        total.throughputAh += sample.throughputAh;
+        total.hotDegreeSeconds += sample.hotDegreeSeconds;
+    }
+    return total;
+}
+
+bool projectAging(const AgingOptions &options, AgingProjection &projection){
+    DriveCycle cycle;
+    if (!cycle.load(options.cycle)){
+        return false;
+    }
+    YearSamples samples;
+    projection.stepsSimulated = sampleYear(options, cycle, samples);
+    projection.thermalSteps = 0;
+    for (const DayAggregate &day : samples.days){
+        projection.thermalSteps += day.thermalSteps;
+    }
+
+    DayAggregate year = projectedTotals(samples, DAYS_PER_YEAR);
+    projection.throughputAhPerYear = year.throughputAh;
+    projection.hotDegreeSecondsPerYear = year.hotDegreeSeconds;
+    float capacity = Battery().get_Q_max();
+    projection.yearlySOH.clear();
+    for (int y = 1; y <= options.years; y++){
+        projection.yearlySOH.push_back(extrapolateSOH(year.throughputAh * y, year.hotDegreeSeconds * y,
+                                                      capacity, options.cycleFade, options.thermalFade));
+    }
+    return true;
+}
+
+//@brief project SOH over the years, then check the projection against stepping every day of the
+//validation period with the battery's own aging functions
+//@return 0 on success, 1 if the drive cycle cannot be loaded or the projected SOH is further than
+//options.tolerance from the brute-force one
+int runAging(const AgingOptions &options){
+    auto start = chrono::steady_clock::now();
+    AgingProjection projection;
+    if (!projectAging(options, projection)){
+        return 1;
+    }
+    double projectSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Aging projection: " << options.years << " years, " << options.driveHours << " h/day of " << options.cycle
+         << ", one simulated day per " << options.sampleDays << " days of similar temperature\n";
+    cout << "Per year: " << projection.throughputAhPerYear << " Ah throughput, "
+         << projection.hotDegreeSecondsPerYear / 3600 << " degree-hours above 40 C\n";
+    for (int y = 0; y < options.years; y++){
+        cout << "  year " << y + 1 << ": SOH " << projection.yearlySOH[y] * 100 << "%\n";
+    }
+    cout << "Projection took " << projectSeconds * 1000 << " ms (" << projection.stepsSimulated << " steps, "
+         << projection.thermalSteps << " replayed drive steps)\n";
+
+    if (options.validateDays <= 0){
+        return 0;
+    }
+
+    //Brute force: every day stepped in full with degradeSOH and degradeWithCycle applied each step
+    DriveCycle cycle;
+    cycle.load(options.cycle);
+    YearSamples samples;
+    sampleYear(options, cycle, samples);
+    DayAggregate projected = projectedTotals(samples, options.validateDays);
+
+    start = chrono::steady_clock::now();
+    Simulation sim;
+    prepareAgingSimulation(sim, options, 0);
+    DayAggregate measured = {0, 0, 0, 0};
+    for (int day = 0; day < options.validateDays; day++){
+        DayAggregate today = simulateAgingDay(sim, cycle, options, day, true);
+        measured.throughputAh += today.throughputAh;
+        measured.hotDegreeSeconds += today.hotDegreeSeconds;
+        measured.steps += today.steps;
+    }
+    double bruteSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    float capacity = sim.get_battery().get_Q_max();
+    float projectedSOH = extrapolateSOH(projected.throughputAh, projected.hotDegreeSeconds, capacity,
+                                        options.cycleFade, options.thermalFade);
+    float bruteSOH = sim.get_battery().get_SOH();
+    cout << "Validation over " << options.validateDays << " days (" << measured.steps << " steps in " << bruteSeconds << " s):\n";
+    cout << "  throughput: brute force " << measured.throughputAh << " Ah, projected " << projected.throughputAh << " Ah\n";
+    cout << "  above 40 C: brute force " << measured.hotDegreeSeconds / 3600 << " degree-hours, projected "
+         << projected.hotDegreeSeconds / 3600 << "\n";
+    float difference = fabs(bruteSOH - projectedSOH) * 100;
+    cout << "  SOH: brute force " << bruteSOH * 100 << "%, projected " << projectedSOH * 100 << "% (difference "
+         << difference << " points, tolerance " << options.tolerance << ")\n";
+    if (difference > options.tolerance){
+        cout << "Validation FAILED: the projection is " << difference << " SOH points from brute force\n";
+        return 1;
+    }
+    cout << "Validation passed\n";
+    return 0;
+}
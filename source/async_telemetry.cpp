@@ -0,0 +1,190 @@
+#include <iostream>
+#include <chrono>
+#include "../headers/async_telemetry.h"
+#include "../headers/profiler.h"
+using namespace std;
+
+long long nowNs(){
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//@brief create a ring with room for at least capacity records
+TelemetryRing::TelemetryRing(size_t capacity){
+    size_t size = 2;
+    while (size < capacity){
+        size *= 2;
+    }
+    slots.resize(size);
+    mask = size - 1;
+    head = 0;
+    tail = 0;
+}
+
+//@brief add a record (producer thread only)
+bool TelemetryRing::push(const TelemetrySlot &slot){
+    size_t h = head.load(memory_order_relaxed);
+    if (h - tail.load(memory_order_acquire) == slots.size()){
+        return false; //full
+    }
+    slots[h & mask] = slot;
+    head.store(h + 1, memory_order_release); //publish the slot to the consumer
+    return true;
+}
+
+//@brief take the oldest record (consumer thread only)
+bool TelemetryRing::pop(TelemetrySlot &slot){
+    size_t t = tail.load(memory_order_relaxed);
+    if (t == head.load(memory_order_acquire)){
+        return false; //empty
+    }
+    slot = slots[t & mask];
+    tail.store(t + 1, memory_order_release); //give the slot back to the producer
+    return true;
+}
+
+size_t TelemetryRing::size() const{
+    return head.load(memory_order_acquire) - tail.load(memory_order_acquire);
+}
+
+size_t TelemetryRing::capacity() const{
+    return slots.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+AsyncTelemetryWriter::AsyncTelemetryWriter(size_t capacity) : ring(capacity){
+    running = false;
+    written = 0;
+    rowsKept = 0;
+    dropped = 0;
+    highWaterMark = 0;
+    maxLagNs = 0;
+}
+
+AsyncTelemetryWriter::~AsyncTelemetryWriter(){
+    close();
+}
+
+//@brief open the log file and start the writer thread
+//@param path - CSV if the name ends in .csv, binary columnar format otherwise
+//@return false if the file cannot be opened (or the policies do not match the channels)
+bool AsyncTelemetryWriter::open(const string &path, const vector<SamplingPolicy> &policies){
+    close();
+    if (!sampler.configure(standardTelemetryChannels(true), policies)){
+        return false;
+    }
+    const vector<TelemetryChannel> &channels = sampler.get_outputChannels();
+    if (isCsvPath(path)){
+        csv.open(path);
+        if (!csv.is_open()){
+            return false;
+        }
+        for (size_t c = 0; c < channels.size(); c++){
+            csv << (c > 0 ? "," : "") << channels[c].name;
+        }
+        csv << "\n";
+    } else if (!binary.open(path, channels)){
+        return false;
+    }
+    written = 0;
+    rowsKept = 0;
+    dropped = 0;
+    highWaterMark = 0;
+    maxLagNs = 0;
+    running = true;
+    writerThread = thread(&AsyncTelemetryWriter::drain, this);
+    return true;
+}
+
+bool AsyncTelemetryWriter::is_open(){
+    return running;
+}
+
+//@brief queue one record (called from the frame thread). Never blocks: if the buffer is full the record is dropped.
+void AsyncTelemetryWriter::log(const TelemetryRecord &record){
+    PROFILE_SCOPE("AsyncTelemetryWriter::log");
+    if (!ring.push(TelemetrySlot{record, nowNs()})){
+        dropped++;
+        return;
+    }
+    size_t waiting = ring.size();
+    if (waiting > highWaterMark.load(memory_order_relaxed)){
+        highWaterMark.store(waiting, memory_order_relaxed);
+    }
+}
+
+void AsyncTelemetryWriter::writeRecord(const TelemetryRecord &record){
+    PROFILE_SCOPE("AsyncTelemetryWriter::writeRecord");
+    const float row[TELEMETRY_STANDARD_CHANNELS] = {record.time, record.speed, record.soc, record.batteryTemp, record.throttle, record.brake};
+    if (sampler.push(row, sampled) > 0){
+        writeSampled();
+    }
+}
+
+//@brief write the rows the sampler picked
+void AsyncTelemetryWriter::writeSampled(){
+    size_t width = sampler.get_outputChannels().size();
+    for (size_t r = 0; r + width <= sampled.size(); r += width){
+        if (csv.is_open()){
+            for (size_t c = 0; c < width; c++){
+                csv << (c > 0 ? "," : "") << sampled[r + c];
+            }
+            csv << "\n";
+        } else{
+            binary.write(&sampled[r]);
+        }
+        rowsKept++;
+    }
+    sampled.clear();
+}
+
+//@brief body of the writer thread: write out everything in the ring until the writer is closed
+void AsyncTelemetryWriter::drain(){
+    profiler.registerThread("telemetry writer");
+    TelemetrySlot slot;
+    while (true){
+        bool stopping = !running.load(); //read before draining so nothing logged before close() is missed
+        bool any = false;
+        while (ring.pop(slot)){
+            writeRecord(slot.record);
+            long long lag = nowNs() - slot.producedNs;
+            if (lag > maxLagNs.load(memory_order_relaxed)){
+                maxLagNs.store(lag, memory_order_relaxed);
+            }
+            written++;
+            any = true;
+        }
+        if (stopping){
+            return;
+        }
+        if (!any){
+            this_thread::sleep_for(chrono::milliseconds(1));
+        }
+    }
+}
+
+//@brief write everything still queued, stop the writer thread and close the file
+void AsyncTelemetryWriter::close(){
+    if (!running){
+        return;
+    }
+    running = false;
+    writerThread.join();
+    if (sampler.flush(sampled) > 0){
+        writeSampled();
+    }
+    binary.close();
+    if (csv.is_open()){
+        csv.close();
+    }
+}
+
+AsyncTelemetryStats AsyncTelemetryWriter::get_stats(){
+    AsyncTelemetryStats stats;
+    stats.written = written;
+    stats.rowsKept = rowsKept;
+    stats.dropped = dropped;
+    stats.highWaterMark = highWaterMark;
+    stats.maxLagSeconds = maxLagNs / 1e9;
+    return stats;
+}
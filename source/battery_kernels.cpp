@@ -0,0 +1,483 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include "../headers/battery_kernels.h"
+#include "../headers/vehicle.h"
+#include "../headers/components.h"
+//AVX2 is compiled on every x86 build (GCC and Clang compile single functions for it with the target
+//attribute) and picked at run time when the processor has it. NEON is part of every 64-bit ARM processor.
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define KERNELS_AVX2
+#define AVX2_TARGET __attribute__((target("avx2")))
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define KERNELS_AVX2
+#define AVX2_TARGET
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define KERNELS_NEON
+#include <arm_neon.h>
+#endif
+using namespace std;
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Scalar versions. These use the same float operations as the SIMD lanes below.
+
+void dischargeBatchScalar(float* Q_now, float* current, const float* speed, const float* temperature,
+                          int count, float delta_t){
+    for (int i = 0; i < count; i++){
+        float T = temperature[i];
+        float tempFactor = T < 0 ? 0.7f : (T > 40.0f ? 1.2f : 1.0f);
+        float deltaQ = 10.0f * speed[i] * delta_t * tempFactor / 3600;
+        float Q = Q_now[i] - deltaQ;
+        float I = current[i] + -deltaQ / delta_t;
+        bool empty = Q < 0;
+        Q_now[i] = empty ? 0 : Q;
+        current[i] = empty ? 0 : I;
+    }
+}
+
+void dischargeFlatBatchScalar(float* Q_now, float* current, const float* speed, int count, float delta_t){
+    for (int i = 0; i < count; i++){
+        float deltaQ = 10.0f * speed[i] * delta_t / 3600;
+        float Q = Q_now[i] - deltaQ;
+        float I = current[i] + -deltaQ / delta_t;
+        bool empty = Q < 0;
+        Q_now[i] = empty ? 0 : Q;
+        current[i] = empty ? 0 : I;
+    }
+}
+
+void updateTemperatureBatchScalar(float* temperature, const float* current, const float* R_internal,
+                                  const float* heatCapacity, float heatTransferCoeff,
+                                  int count, float delta_t, float ambientTemp){
+    for (int i = 0; i < count; i++){
+        float heatGenerated = 0.00001 * current[i] * current[i] * R_internal[i] * delta_t; //In double, like Battery
+        float cooling = heatTransferCoeff * (temperature[i] - ambientTemp) * delta_t;
+        temperature[i] += (heatGenerated - cooling) / heatCapacity[i];
+    }
+}
+
+void degradeSOHBatchScalar(float* stateOfHealth, const float* temperature, int count, float delta_t, float thermalFade){
+    for (int i = 0; i < count; i++){
+        float T = temperature[i];
+        float degraded = stateOfHealth[i] - thermalFade * delta_t * (T - 40);
+        if (degraded < 0){
+            degraded = 0;
+        }
+        stateOfHealth[i] = T > 40 ? degraded : stateOfHealth[i];
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//SIMD versions. Each processes full vectors and leaves the tail to the scalar loops.
+
+#if defined(KERNELS_AVX2)
+
+//@return true if the processor (and the operating system) support AVX2. Checked once.
+bool cpuHasAvx2(){
+#if defined(__GNUC__) || defined(__clang__)
+    static const bool supported = __builtin_cpu_supports("avx2");
+    return supported;
+#else
+    return true; //Only compiled when the whole build targets AVX2
+#endif
+}
+
+AVX2_TARGET void dischargeBatchAvx2(float* Q_now, float* current, const float* speed, const float* temperature,
+                        int count, float delta_t){
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 dt = _mm256_set1_ps(delta_t);
+    int i = 0;
+    for (; i + 8 <= count; i += 8){
+        __m256 T = _mm256_loadu_ps(temperature + i);
+        //tempFactor: 0.7 below 0 C, 1.2 above 40 C, 1.0 otherwise
+        __m256 tempFactor = _mm256_set1_ps(1.0f);
+        tempFactor = _mm256_blendv_ps(tempFactor, _mm256_set1_ps(0.7f), _mm256_cmp_ps(T, zero, _CMP_LT_OQ));
+        tempFactor = _mm256_blendv_ps(tempFactor, _mm256_set1_ps(1.2f), _mm256_cmp_ps(T, _mm256_set1_ps(40.0f), _CMP_GT_OQ));
+
+        __m256 deltaQ = _mm256_mul_ps(_mm256_set1_ps(10.0f), _mm256_loadu_ps(speed + i));
+        deltaQ = _mm256_mul_ps(deltaQ, dt);
+        deltaQ = _mm256_mul_ps(deltaQ, tempFactor);
+        deltaQ = _mm256_div_ps(deltaQ, _mm256_set1_ps(3600.0f));
+
+        __m256 Q = _mm256_sub_ps(_mm256_loadu_ps(Q_now + i), deltaQ);
+        __m256 I = _mm256_sub_ps(_mm256_loadu_ps(current + i), _mm256_div_ps(deltaQ, dt));
+
+        //Clamp at an empty battery
+        __m256 empty = _mm256_cmp_ps(Q, zero, _CMP_LT_OQ);
+        _mm256_storeu_ps(Q_now + i, _mm256_andnot_ps(empty, Q));
+        _mm256_storeu_ps(current + i, _mm256_andnot_ps(empty, I));
+    }
+    dischargeBatchScalar(Q_now + i, current + i, speed + i, temperature + i, count - i, delta_t);
+}
+
+AVX2_TARGET void dischargeFlatBatchAvx2(float* Q_now, float* current, const float* speed, int count, float delta_t){
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 dt = _mm256_set1_ps(delta_t);
+    int i = 0;
+    for (; i + 8 <= count; i += 8){
+        __m256 deltaQ = _mm256_mul_ps(_mm256_set1_ps(10.0f), _mm256_loadu_ps(speed + i));
+        deltaQ = _mm256_mul_ps(deltaQ, dt);
+        deltaQ = _mm256_div_ps(deltaQ, _mm256_set1_ps(3600.0f));
+
+        __m256 Q = _mm256_sub_ps(_mm256_loadu_ps(Q_now + i), deltaQ);
+        __m256 I = _mm256_sub_ps(_mm256_loadu_ps(current + i), _mm256_div_ps(deltaQ, dt));
+
+        //Clamp at an empty battery
+        __m256 empty = _mm256_cmp_ps(Q, zero, _CMP_LT_OQ);
+        _mm256_storeu_ps(Q_now + i, _mm256_andnot_ps(empty, Q));
+        _mm256_storeu_ps(current + i, _mm256_andnot_ps(empty, I));
+    }
+    dischargeFlatBatchScalar(Q_now + i, current + i, speed + i, count - i, delta_t);
+}
+
+AVX2_TARGET void updateTemperatureBatchAvx2(float* temperature, const float* current, const float* R_internal,
+                                const float* heatCapacity, float heatTransferCoeff,
+                                int count, float delta_t, float ambientTemp){
+    const __m256 dt = _mm256_set1_ps(delta_t);
+    const __m256 h = _mm256_set1_ps(heatTransferCoeff);
+    const __m256 ambient = _mm256_set1_ps(ambientTemp);
+    const __m256d c = _mm256_set1_pd(0.00001);
+    const __m256d dtDouble = _mm256_set1_pd(delta_t);
+    int i = 0;
+    for (; i + 8 <= count; i += 8){
+        __m256 I = _mm256_loadu_ps(current + i);
+        __m256 R = _mm256_loadu_ps(R_internal + i);
+        __m256 T = _mm256_loadu_ps(temperature + i);
+        //The heat is computed in double, 4 lanes at a time, like the double constant makes Battery do it
+        __m256d heatLow = _mm256_mul_pd(c, _mm256_cvtps_pd(_mm256_castps256_ps128(I)));
+        heatLow = _mm256_mul_pd(heatLow, _mm256_cvtps_pd(_mm256_castps256_ps128(I)));
+        heatLow = _mm256_mul_pd(heatLow, _mm256_cvtps_pd(_mm256_castps256_ps128(R)));
+        heatLow = _mm256_mul_pd(heatLow, dtDouble);
+        __m256d heatHigh = _mm256_mul_pd(c, _mm256_cvtps_pd(_mm256_extractf128_ps(I, 1)));
+        heatHigh = _mm256_mul_pd(heatHigh, _mm256_cvtps_pd(_mm256_extractf128_ps(I, 1)));
+        heatHigh = _mm256_mul_pd(heatHigh, _mm256_cvtps_pd(_mm256_extractf128_ps(R, 1)));
+        heatHigh = _mm256_mul_pd(heatHigh, dtDouble);
+        __m256 heat = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm256_cvtpd_ps(heatLow)), _mm256_cvtpd_ps(heatHigh), 1);
+        __m256 cooling = _mm256_mul_ps(_mm256_mul_ps(h, _mm256_sub_ps(T, ambient)), dt);
+        __m256 deltaTemp = _mm256_div_ps(_mm256_sub_ps(heat, cooling), _mm256_loadu_ps(heatCapacity + i));
+        _mm256_storeu_ps(temperature + i, _mm256_add_ps(T, deltaTemp));
+    }
+    updateTemperatureBatchScalar(temperature + i, current + i, R_internal + i, heatCapacity + i,
+                                 heatTransferCoeff, count - i, delta_t, ambientTemp);
+}
+
+AVX2_TARGET void degradeSOHBatchAvx2(float* stateOfHealth, const float* temperature, int count, float delta_t, float thermalFade){
+    const __m256 threshold = _mm256_set1_ps(40.0f);
+    const __m256 rate = _mm256_set1_ps(thermalFade * delta_t);
+    int i = 0;
+    for (; i + 8 <= count; i += 8){
+        __m256 T = _mm256_loadu_ps(temperature + i);
+        __m256 SOH = _mm256_loadu_ps(stateOfHealth + i);
+        __m256 degraded = _mm256_sub_ps(SOH, _mm256_mul_ps(rate, _mm256_sub_ps(T, threshold)));
+        degraded = _mm256_max_ps(degraded, _mm256_setzero_ps());
+        __m256 hot = _mm256_cmp_ps(T, threshold, _CMP_GT_OQ);
+        _mm256_storeu_ps(stateOfHealth + i, _mm256_blendv_ps(SOH, degraded, hot));
+    }
+    degradeSOHBatchScalar(stateOfHealth + i, temperature + i, count - i, delta_t, thermalFade);
+}
+
+#endif
+
+#if defined(KERNELS_NEON)
+
+void dischargeBatchNeon(float* Q_now, float* current, const float* speed, const float* temperature,
+                        int count, float delta_t){
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t dt = vdupq_n_f32(delta_t);
+    int i = 0;
+    for (; i + 4 <= count; i += 4){
+        float32x4_t T = vld1q_f32(temperature + i);
+        //tempFactor: 0.7 below 0 C, 1.2 above 40 C, 1.0 otherwise
+        float32x4_t tempFactor = vdupq_n_f32(1.0f);
+        tempFactor = vbslq_f32(vcltq_f32(T, zero), vdupq_n_f32(0.7f), tempFactor);
+        tempFactor = vbslq_f32(vcgtq_f32(T, vdupq_n_f32(40.0f)), vdupq_n_f32(1.2f), tempFactor);
+
+        float32x4_t deltaQ = vmulq_f32(vdupq_n_f32(10.0f), vld1q_f32(speed + i));
+        deltaQ = vmulq_f32(deltaQ, dt);
+        deltaQ = vmulq_f32(deltaQ, tempFactor);
+        deltaQ = vdivq_f32(deltaQ, vdupq_n_f32(3600.0f));
+
+        float32x4_t Q = vsubq_f32(vld1q_f32(Q_now + i), deltaQ);
+        float32x4_t I = vsubq_f32(vld1q_f32(current + i), vdivq_f32(deltaQ, dt));
+
+        //Clamp at an empty battery
+        uint32x4_t empty = vcltq_f32(Q, zero);
+        vst1q_f32(Q_now + i, vbslq_f32(empty, zero, Q));
+        vst1q_f32(current + i, vbslq_f32(empty, zero, I));
+    }
+    dischargeBatchScalar(Q_now + i, current + i, speed + i, temperature + i, count - i, delta_t);
+}
+
+void dischargeFlatBatchNeon(float* Q_now, float* current, const float* speed, int count, float delta_t){
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t dt = vdupq_n_f32(delta_t);
+    int i = 0;
+    for (; i + 4 <= count; i += 4){
+        float32x4_t deltaQ = vmulq_f32(vdupq_n_f32(10.0f), vld1q_f32(speed + i));
+        deltaQ = vmulq_f32(deltaQ, dt);
+        deltaQ = vdivq_f32(deltaQ, vdupq_n_f32(3600.0f));
+
+        float32x4_t Q = vsubq_f32(vld1q_f32(Q_now + i), deltaQ);
+        float32x4_t I = vsubq_f32(vld1q_f32(current + i), vdivq_f32(deltaQ, dt));
+
+        //Clamp at an empty battery
+        uint32x4_t empty = vcltq_f32(Q, zero);
+        vst1q_f32(Q_now + i, vbslq_f32(empty, zero, Q));
+        vst1q_f32(current + i, vbslq_f32(empty, zero, I));
+    }
+    dischargeFlatBatchScalar(Q_now + i, current + i, speed + i, count - i, delta_t);
+}
+
+void updateTemperatureBatchNeon(float* temperature, const float* current, const float* R_internal,
+                                const float* heatCapacity, float heatTransferCoeff,
+                                int count, float delta_t, float ambientTemp){
+    const float32x4_t dt = vdupq_n_f32(delta_t);
+    const float32x4_t h = vdupq_n_f32(heatTransferCoeff);
+    const float32x4_t ambient = vdupq_n_f32(ambientTemp);
+    const float64x2_t c = vdupq_n_f64(0.00001);
+    const float64x2_t dtDouble = vdupq_n_f64(delta_t);
+    int i = 0;
+    for (; i + 4 <= count; i += 4){
+        float32x4_t I = vld1q_f32(current + i);
+        float32x4_t R = vld1q_f32(R_internal + i);
+        float32x4_t T = vld1q_f32(temperature + i);
+        //The heat is computed in double, 2 lanes at a time, like the double constant makes Battery do it
+        float64x2_t heatLow = vmulq_f64(c, vcvt_f64_f32(vget_low_f32(I)));
+        heatLow = vmulq_f64(heatLow, vcvt_f64_f32(vget_low_f32(I)));
+        heatLow = vmulq_f64(heatLow, vcvt_f64_f32(vget_low_f32(R)));
+        heatLow = vmulq_f64(heatLow, dtDouble);
+        float64x2_t heatHigh = vmulq_f64(c, vcvt_high_f64_f32(I));
+        heatHigh = vmulq_f64(heatHigh, vcvt_high_f64_f32(I));
+        heatHigh = vmulq_f64(heatHigh, vcvt_high_f64_f32(R));
+        heatHigh = vmulq_f64(heatHigh, dtDouble);
+        float32x4_t heat = vcvt_high_f32_f64(vcvt_f32_f64(heatLow), heatHigh);
+        float32x4_t cooling = vmulq_f32(vmulq_f32(h, vsubq_f32(T, ambient)), dt);
+        float32x4_t deltaTemp = vdivq_f32(vsubq_f32(heat, cooling), vld1q_f32(heatCapacity + i));
+        vst1q_f32(temperature + i, vaddq_f32(T, deltaTemp));
+    }
+    updateTemperatureBatchScalar(temperature + i, current + i, R_internal + i, heatCapacity + i,
+                                 heatTransferCoeff, count - i, delta_t, ambientTemp);
+}
+
+void degradeSOHBatchNeon(float* stateOfHealth, const float* temperature, int count, float delta_t, float thermalFade){
+    const float32x4_t threshold = vdupq_n_f32(40.0f);
+    const float32x4_t rate = vdupq_n_f32(thermalFade * delta_t);
+    int i = 0;
+    for (; i + 4 <= count; i += 4){
+        float32x4_t T = vld1q_f32(temperature + i);
+        float32x4_t SOH = vld1q_f32(stateOfHealth + i);
+        float32x4_t degraded = vsubq_f32(SOH, vmulq_f32(rate, vsubq_f32(T, threshold)));
+        degraded = vmaxq_f32(degraded, vdupq_n_f32(0.0f));
+        vst1q_f32(stateOfHealth + i, vbslq_f32(vcgtq_f32(T, threshold), degraded, SOH));
+    }
+    degradeSOHBatchScalar(stateOfHealth + i, temperature + i, count - i, delta_t, thermalFade);
+}
+
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////
+//Entry points: the best version the processor runs
+
+const char* batteryKernelName(){
+#if defined(KERNELS_AVX2)
+    if (cpuHasAvx2()){
+        return "AVX2";
+    }
+#elif defined(KERNELS_NEON)
+    return "NEON";
+#endif
+    return "scalar";
+}
+
+void dischargeBatch(float* Q_now, float* current, const float* speed, const float* temperature,
+                    int count, float delta_t){
+#if defined(KERNELS_AVX2)
+    if (cpuHasAvx2()){
+        dischargeBatchAvx2(Q_now, current, speed, temperature, count, delta_t);
+        return;
+    }
+#elif defined(KERNELS_NEON)
+    dischargeBatchNeon(Q_now, current, speed, temperature, count, delta_t);
+    return;
+#endif
+    dischargeBatchScalar(Q_now, current, speed, temperature, count, delta_t);
+}
+
+void dischargeFlatBatch(float* Q_now, float* current, const float* speed, int count, float delta_t){
+#if defined(KERNELS_AVX2)
+    if (cpuHasAvx2()){
+        dischargeFlatBatchAvx2(Q_now, current, speed, count, delta_t);
+        return;
+    }
+#elif defined(KERNELS_NEON)
+    dischargeFlatBatchNeon(Q_now, current, speed, count, delta_t);
+    return;
+#endif
+    dischargeFlatBatchScalar(Q_now, current, speed, count, delta_t);
+}
+
+void updateTemperatureBatch(float* temperature, const float* current, const float* R_internal,
+                            const float* heatCapacity, float heatTransferCoeff,
+                            int count, float delta_t, float ambientTemp){
+#if defined(KERNELS_AVX2)
+    if (cpuHasAvx2()){
+        updateTemperatureBatchAvx2(temperature, current, R_internal, heatCapacity, heatTransferCoeff,
+                                   count, delta_t, ambientTemp);
+        return;
+    }
+#elif defined(KERNELS_NEON)
+    updateTemperatureBatchNeon(temperature, current, R_internal, heatCapacity, heatTransferCoeff,
+                               count, delta_t, ambientTemp);
+    return;
+#endif
+    updateTemperatureBatchScalar(temperature, current, R_internal, heatCapacity, heatTransferCoeff,
+                                 count, delta_t, ambientTemp);
+}
+
+void degradeSOHBatch(float* stateOfHealth, const float* temperature, int count, float delta_t, float thermalFade){
+#if defined(KERNELS_AVX2)
+    if (cpuHasAvx2()){
+        degradeSOHBatchAvx2(stateOfHealth, temperature, count, delta_t, thermalFade);
+        return;
+    }
+#elif defined(KERNELS_NEON)
+    degradeSOHBatchNeon(stateOfHealth, temperature, count, delta_t, thermalFade);
+    return;
+#endif
+    degradeSOHBatchScalar(stateOfHealth, temperature, count, delta_t, thermalFade);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////
+
+//Battery state arrays used by the benchmark
+struct BatteryArrays{
+    vector<float> Q_now, current, speed, temperature, R_internal, heatCapacity, stateOfHealth;
+
+    BatteryArrays(int count){
+        Q_now.resize(count); current.resize(count); speed.resize(count); temperature.resize(count);
+        R_internal.resize(count); heatCapacity.resize(count); stateOfHealth.resize(count);
+        //Spread the batteries over all the temperature tiers and a range of speeds
+        for (int i = 0; i < count; i++){
+            Q_now[i] = 20 + (i % 131);
+            current[i] = -(i % 97);
+            speed[i] = i % 101;
+            temperature[i] = -15 + (i % 71);
+            R_internal[i] = 0.02;
+            heatCapacity[i] = 1000;
+            stateOfHealth[i] = 1;
+        }
+    }
+};
+
+//@brief one step of all three batch functions
+void stepArrays(BatteryArrays &a, int count, float delta_t, bool simd){
+    if (simd){
+        dischargeBatch(a.Q_now.data(), a.current.data(), a.speed.data(), a.temperature.data(), count, delta_t);
+        updateTemperatureBatch(a.temperature.data(), a.current.data(), a.R_internal.data(), a.heatCapacity.data(),
+                               0.6, count, delta_t, 25);
+        degradeSOHBatch(a.stateOfHealth.data(), a.temperature.data(), count, delta_t, 0.001);
+    } else{
+        dischargeBatchScalar(a.Q_now.data(), a.current.data(), a.speed.data(), a.temperature.data(), count, delta_t);
+        updateTemperatureBatchScalar(a.temperature.data(), a.current.data(), a.R_internal.data(), a.heatCapacity.data(),
+                                     0.6, count, delta_t, 25);
+        degradeSOHBatchScalar(a.stateOfHealth.data(), a.temperature.data(), count, delta_t, 0.001);
+    }
+}
+
+//@brief largest difference relative to max(1, |reference|)
+float relativeError(float value, float reference){
+    float scale = fabs(reference) > 1 ? fabs(reference) : 1;
+    return fabs(value - reference) / scale;
+}
+
+//@brief time Battery objects, the scalar batch loops and the SIMD kernels at 1k, 100k and 1M batteries.
+//Also checks the kernels against the Battery member functions after one step.
+//@return 0 if the kernels are within the documented tolerance, 1 otherwise
+int runBatteryKernelBenchmark(){
+    const float delta_t = 0.016;
+    const int sizes[3] = {1000, 100000, 1000000};
+    int result = 0;
+
+    cout << "Battery kernels running on: " << batteryKernelName() << "\n";
+    for (int size : sizes){
+        //Repeat small sizes so every measurement covers about 20 million battery updates
+        int repeats = 20000000 / size;
+
+        //Existing scalar functions on Battery objects
+        vector<Battery> batteries(size);
+        BatteryArrays start(size);
+        for (int i = 0; i < size; i++){
+            batteries[i].set_Q_current(start.Q_now[i]);
+            batteries[i].setCurrent(start.current[i]);
+            batteries[i].set_temp(start.temperature[i]);
+        }
+
+        //Accuracy check: one step of each version from the same state
+        BatteryArrays simdCheck(size);
+        stepArrays(simdCheck, size, delta_t, true);
+        BatteryArrays flatCheck(size);
+        dischargeFlatBatch(flatCheck.Q_now.data(), flatCheck.current.data(), flatCheck.speed.data(), size, delta_t);
+        float maxErrQ = 0, maxErrT = 0, maxErrSOH = 0, maxErrFlat = 0;
+        for (int i = 0; i < size; i++){
+            Battery b;
+            b.set_Q_current(start.Q_now[i]);
+            b.setCurrent(start.current[i]);
+            b.set_temp(start.temperature[i]);
+            b.discharge(start.speed[i], delta_t);
+            b.updateTemperature(delta_t, 25);
+            b.degradeSOH(delta_t);
+            maxErrQ = max(maxErrQ, relativeError(simdCheck.Q_now[i], b.get_Q_current()));
+            maxErrT = max(maxErrT, relativeError(simdCheck.temperature[i], b.get_temp()));
+            maxErrSOH = max(maxErrSOH, relativeError(simdCheck.stateOfHealth[i], b.get_SOH()));
+            Battery flat; //Between the discharge steps the temperature factor is 1
+            flat.set_Q_current(start.Q_now[i]);
+            flat.setCurrent(start.current[i]);
+            flat.set_temp(20);
+            flat.discharge(start.speed[i], delta_t);
+            maxErrFlat = max(maxErrFlat, relativeError(flatCheck.Q_now[i], flat.get_Q_current()));
+            maxErrFlat = max(maxErrFlat, relativeError(flatCheck.current[i], flat.get_current()));
+        }
+
+        auto t0 = chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r++){
+            for (int i = 0; i < size; i++){
+                batteries[i].discharge(start.speed[i], delta_t);
+                batteries[i].updateTemperature(delta_t, 25);
+                batteries[i].degradeSOH(delta_t);
+            }
+        }
+        auto t1 = chrono::steady_clock::now();
+        BatteryArrays scalar(size);
+        for (int r = 0; r < repeats; r++){
+            stepArrays(scalar, size, delta_t, false);
+        }
+        auto t2 = chrono::steady_clock::now();
+        BatteryArrays simd(size);
+        for (int r = 0; r < repeats; r++){
+            stepArrays(simd, size, delta_t, true);
+        }
+        auto t3 = chrono::steady_clock::now();
+
+        double updates = static_cast<double>(size) * repeats;
+        double objectNs = chrono::duration<double, nano>(t1 - t0).count() / updates;
+        double scalarNs = chrono::duration<double, nano>(t2 - t1).count() / updates;
+        double simdNs = chrono::duration<double, nano>(t3 - t2).count() / updates;
+
+        cout << size << " batteries:\n";
+        cout << "  Battery objects: " << objectNs << " ns/battery\n";
+        cout << "  scalar batch:    " << scalarNs << " ns/battery (" << objectNs / scalarNs << "x)\n";
+        cout << "  " << batteryKernelName() << " batch:      " << simdNs << " ns/battery (" << objectNs / simdNs
+             << "x vs objects, " << scalarNs / simdNs << "x vs scalar batch)\n";
+        cout << "  max relative error vs Battery: Q " << maxErrQ << ", temperature " << maxErrT << ", SOH " << maxErrSOH
+             << ", flat discharge " << maxErrFlat << "\n";
+
+        if (maxErrQ > 0 || maxErrT > 0 || maxErrSOH > 1e-6 || maxErrFlat > 0){
+            cout << "  ERROR: outside the documented tolerance\n";
+            result = 1;
+        }
+    }
+    return result;
+}
@@ -0,0 +1,89 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <vector>
+#include "../headers/battery_tables.h"
+using namespace std;
+
+LookupTable::LookupTable(){
+    //A flat curve at 1 until set() is called
+    for (float &value : values){
+        value = 1;
+    }
+    first = 0;
+    scale = 1;
+    lastIndex = 1;
+}
+
+bool LookupTable::set(float firstX, float lastX, const float* points, int count){
+    if (count < 2 || count > MAX_POINTS || !(lastX > firstX)){
+        return false;
+    }
+    for (int i = 0; i < count; i++){
+        values[i] = points[i];
+    }
+    for (int i = count; i <= MAX_POINTS; i++){
+        values[i] = points[count - 1];
+    }
+    first = firstX;
+    scale = (count - 1) / (lastX - firstX);
+    lastIndex = count - 1;
+    return true;
+}
+
+bool BatteryTables::load(const string &path){
+    ifstream file(path);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+
+    //Strip the comments, then read the tables as whitespace separated tokens
+    stringstream content;
+    string line;
+    while (getline(file, line)){
+        size_t comment = line.find('#');
+        content << line.substr(0, comment) << "\n";
+    }
+
+    bool found[4] = {false, false, false, false};
+    const char* names[4] = {"ocv", "resistance", "discharge", "efficiency"};
+    LookupTable* tables[4] = {&ocv, &resistance, &discharge, &chargeEfficiency};
+    string keyword, name;
+    while (content >> keyword){
+        float firstX, lastX;
+        int count;
+        if (keyword != "table" || !(content >> name >> firstX >> lastX >> count) || count < 0){
+            cout << "Invalid table header in " << path << "\n";
+            return false;
+        }
+        vector<float> points(count);
+        for (float &point : points){
+            if (!(content >> point)){
+                cout << "Table " << name << " in " << path << " has fewer than " << count << " values\n";
+                return false;
+            }
+        }
+        int t = 0;
+        while (t < 4 && name != names[t]){
+            t++;
+        }
+        if (t == 4){
+            cout << "Unknown table " << name << " in " << path << " (skipped)\n";
+            continue;
+        }
+        if (!tables[t]->set(firstX, lastX, points.data(), count)){
+            cout << "Table " << name << " in " << path << " needs 2 to " << LookupTable::MAX_POINTS
+                 << " values over a non-empty range\n";
+            return false;
+        }
+        found[t] = true;
+    }
+    for (int t = 0; t < 4; t++){
+        if (!found[t]){
+            cout << "Table " << names[t] << " is missing from " << path << "\n";
+            return false;
+        }
+    }
+    return true;
+}
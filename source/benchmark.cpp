@@ -0,0 +1,404 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include "../headers/benchmark.h"
+#include "../headers/simulation.h"
+#include "../headers/telemetry.h"
+#include "../headers/async_telemetry.h"
+#include "../headers/log_analytics.h"
+#include "../headers/battery_kernels.h"
+#include "../headers/vehicle_model.h"
+#include "../headers/battery_tables.h"
+using namespace std;
+
+//Set by bench/alloc_counter.cpp when it is linked in (the benchmark build), nullptr otherwise
+long long (*allocationCounter)() = nullptr;
+
+long long allocationCount(){
+    return allocationCounter != nullptr ? allocationCounter() : -1;
+}
+
+//Results are written here so the compiler cannot drop the work being timed
+volatile float benchmarkSink;
+
+//default settings: 5 repetitions of at least 50 ms each
+BenchmarkOptions::BenchmarkOptions(){
+    filter = "";
+    minTime = 0.05;
+    repetitions = 5;
+    jsonPath = "";
+    baselinePath = "";
+    threshold = 0.1;
+}
+
+//@brief time one call of body(iterations)
+double timeRun(const function<void(long long)> &body, long long iterations){
+    auto start = chrono::steady_clock::now();
+    body(iterations);
+    return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+//@param opsPerIteration - operations done by each iteration of body (e.g. rows of a parsed file)
+BenchmarkResult runBenchmarkBatch(const string &name, const function<void(long long)> &body,
+                                  long long opsPerIteration, const BenchmarkOptions &options){
+    //Find an iteration count that takes at least minTime (this also warms up caches and branch predictors)
+    long long iterations = 1;
+    double seconds = timeRun(body, iterations);
+    while (seconds < options.minTime){
+        double scale = seconds > 0 ? options.minTime / seconds * 1.2 : 100;
+        iterations = static_cast<long long>(iterations * min(100.0, max(2.0, scale)));
+        seconds = timeRun(body, iterations);
+    }
+
+    vector<double> nsPerOp;
+    long long allocated = 0;
+    for (int r = 0; r < options.repetitions; r++){
+        long long before = allocationCount();
+        seconds = timeRun(body, iterations);
+        allocated += allocationCount() - before;
+        nsPerOp.push_back(seconds * 1e9 / (iterations * opsPerIteration));
+    }
+    sort(nsPerOp.begin(), nsPerOp.end());
+
+    BenchmarkResult result;
+    result.name = name;
+    result.ops = iterations * opsPerIteration;
+    result.nsPerOp = nsPerOp[nsPerOp.size() / 2];
+    result.opsPerSecond = result.nsPerOp > 0 ? 1e9 / result.nsPerOp : 0;
+    result.allocationsPerOp = allocationCount() < 0 ? -1 : static_cast<double>(allocated) / (static_cast<double>(result.ops) * options.repetitions);
+    return result;
+}
+
+BenchmarkResult runBenchmark(const string &name, const function<void(long long)> &body, const BenchmarkOptions &options){
+    return runBenchmarkBatch(name, body, 1, options);
+}
+
+bool writeBenchmarkJson(const string &path, const vector<BenchmarkResult> &results){
+    ofstream file(path);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+    file << "{\n  \"build\": {\n";
+#ifdef __VERSION__
+    file << "    \"compiler\": \"" << __VERSION__ << "\",\n";
+#endif
+#ifdef __OPTIMIZE__
+    file << "    \"optimized\": true,\n";
+#else
+    file << "    \"optimized\": false,\n";
+#endif
+    file << "    \"batteryKernels\": \"" << batteryKernelName() << "\",\n";
+    file << "    \"built\": \"" << __DATE__ << " " << __TIME__ << "\"\n  },\n";
+    file << "  \"benchmarks\": [\n" << setprecision(9);
+    for (size_t i = 0; i < results.size(); i++){
+        const BenchmarkResult &result = results[i];
+        file << "    {\"name\": \"" << result.name << "\", \"ops\": " << result.ops
+             << ", \"ns_per_op\": " << result.nsPerOp << ", \"ops_per_second\": " << result.opsPerSecond
+             << ", \"allocations_per_op\": ";
+        if (result.allocationsPerOp < 0){
+            file << "null"; //Not counted in this build
+        } else{
+            file << result.allocationsPerOp;
+        }
+        file << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return true;
+}
+
+//@brief read the name and ns_per_op of every benchmark in a file written by writeBenchmarkJson
+bool readBenchmarkJson(const string &path, vector<BenchmarkResult> &results){
+    ifstream file(path);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+    string line;
+    while (getline(file, line)){
+        size_t name = line.find("\"name\": \"");
+        size_t ns = line.find("\"ns_per_op\": ");
+        if (name == string::npos || ns == string::npos){
+            continue;
+        }
+        name += 9;
+        BenchmarkResult result = {line.substr(name, line.find('"', name) - name), 0, 0, 0, 0};
+        try{
+            result.nsPerOp = stod(line.substr(ns + 13));
+        } catch (...){
+            continue;
+        }
+        results.push_back(result);
+    }
+    return true;
+}
+
+int compareWithBaseline(const string &path, const vector<BenchmarkResult> &results, double threshold){
+    vector<BenchmarkResult> baseline;
+    if (!readBenchmarkJson(path, baseline)){
+        return 1;
+    }
+    cout << "Compared with " << path << " (regression above +" << threshold * 100 << "%):\n";
+    int regressions = 0;
+    for (const BenchmarkResult &result : results){
+        for (const BenchmarkResult &old : baseline){
+            if (old.name != result.name || old.nsPerOp <= 0){
+                continue;
+            }
+            double change = result.nsPerOp / old.nsPerOp - 1;
+            bool regression = change > threshold;
+            regressions += regression;
+            cout << "  " << left << setw(34) << result.name << right << showpos << fixed << setprecision(1)
+                 << change * 100 << "%" << noshowpos << defaultfloat << setprecision(6) << (regression ? "  REGRESSION" : "") << "\n";
+        }
+    }
+    cout << regressions << " regression" << (regressions == 1 ? "" : "s") << "\n";
+    return regressions > 0 ? 1 : 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+//@brief write a CSV log like the one the window writes (the input of averageSpeed)
+bool writeBenchmarkLog(const string &path, int rows){
+    ofstream file(path);
+    if (!file.is_open()){
+        return false;
+    }
+    Simulation sim;
+    bool charging = false;
+    file << "Time,Speed,SOC,BatteryTemp,Throttle,Brake\n";
+    for (int i = 0; i < rows; i++){
+        scriptedDriver(sim.get_time(), sim.get_battery(), sim.get_input(), charging);
+        sim.step(0.016, charging);
+        file << sim.get_time() << "," << sim.get_speed() << "," << sim.get_battery().get_SOC() << ","
+             << sim.get_battery().get_temp() << "," << sim.get_input().get_throttle() << ","
+             << sim.get_input().get_brake() << "\n";
+    }
+    return true;
+}
+
+int runBenchmarks(const BenchmarkOptions &options){
+    //Every benchmark starts from its own default objects. Where an operation would drift into another
+    //branch (battery full or empty, wheels stopped), the state is put back every 1024 operations.
+    struct Benchmark{
+        string name;
+        function<void(long long)> body;
+        long long opsPerIteration;
+    };
+    const float dt = 0.016;
+    const int logRows = 10000;
+    const string csvPath = "benchmark_log.csv";
+    const string binaryPath = "benchmark_log.evtl";
+    BatteryTables tables; //Flat curves if the file is missing, which costs the same to look up
+    tables.load("assets/battery_tables.txt");
+    vector<Benchmark> benchmarks = {
+        {"Battery::discharge", [&](long long n){
+            Battery battery;
+            for (long long i = 0; i < n; i++){
+                if ((i & 1023) == 0) battery.set_Q_current(150);
+                battery.discharge(20, dt);
+            }
+            benchmarkSink = battery.get_Q_current();
+        }, 1},
+        {"Battery::discharge/tables", [&](long long n){
+            Battery battery;
+            battery.set_tables(&tables);
+            for (long long i = 0; i < n; i++){
+                if ((i & 1023) == 0) battery.set_Q_current(150);
+                battery.discharge(20, dt);
+            }
+            benchmarkSink = battery.get_Q_current();
+        }, 1},
+        {"LookupTable::at", [&](long long n){
+            float sum = 0;
+            float x = -30;
+            for (long long i = 0; i < n; i++){
+                sum += tables.resistance.at(x);
+                x = x > 70 ? -30 : x + 0.37f; //Sweeps the whole table and both clamped ends
+            }
+            benchmarkSink = sum;
+        }, 1},
+        {"Battery::updateTemperature", [&](long long n){
+            Battery battery;
+            battery.setCurrent(-50);
+            float temperature = 0;
+            for (long long i = 0; i < n; i++){
+                temperature += battery.updateTemperature(dt, 25);
+            }
+            benchmarkSink = temperature;
+        }, 1},
+        {"Battery::charge", [&](long long n){
+            Battery battery;
+            bool full = false;
+            for (long long i = 0; i < n; i++){
+                if ((i & 1023) == 0) battery.set_Q_current(0);
+                battery.charge(84, dt, full);
+            }
+            benchmarkSink = battery.get_Q_current();
+        }, 1},
+        {"Motor::updateSpeed/throttle", [&](long long n){
+            Motor motor;
+            Battery battery;
+            EV vehicle;
+            DriverInput input;
+            input.set_throttle(1.0);
+            float speed = 0;
+            for (long long i = 0; i < n; i++){
+                if ((i & 1023) == 0) battery.set_Q_current(150);
+                speed += motor.updateSpeed(input, vehicle, battery, dt);
+            }
+            benchmarkSink = speed;
+        }, 1},
+        {"Motor::updateSpeed/brake-regen", [&](long long n){
+            Motor motor;
+            Battery battery;
+            EV vehicle;
+            DriverInput input;
+            input.set_brake(0.5);
+            float speed = 0;
+            for (long long i = 0; i < n; i++){
+                if ((i & 1023) == 0){ //Braking from 1000 rad/s takes ~4000 steps, so the wheels keep turning
+                    motor.set_angularSpeed(1000);
+                    motor.set_speed(50);
+                    battery.set_Q_current(100);
+                }
+                speed += motor.updateSpeed(input, vehicle, battery, dt);
+            }
+            benchmarkSink = speed;
+        }, 1},
+        {"Motor::updateSpeed/coast", [&](long long n){
+            Motor motor;
+            Battery battery;
+            EV vehicle;
+            DriverInput input;
+            float speed = 0;
+            for (long long i = 0; i < n; i++){
+                if ((i & 1023) == 0){
+                    motor.set_angularSpeed(1000);
+                    battery.set_Q_current(150);
+                }
+                speed += motor.updateSpeed(input, vehicle, battery, dt);
+            }
+            benchmarkSink = speed;
+        }, 1},
+        {"Motor::calculateRegenPower", [&](long long n){
+            Motor motor;
+            DriverInput input;
+            input.set_brake(0.5);
+            motor.set_speed(20);
+            float power = 0;
+            for (long long i = 0; i < n; i++){
+                power += motor.calculateRegenPower(input);
+            }
+            benchmarkSink = power;
+        }, 1},
+        {"Charger::startCharging", [&](long long n){
+            Charger charger;
+            Battery battery;
+            for (long long i = 0; i < n; i++){
+                if ((i & 1023) == 0) battery.set_Q_current(0);
+                charger.startCharging(battery, dt);
+            }
+            benchmarkSink = battery.get_Q_current();
+        }, 1},
+        {"Simulation::step", [&](long long n){
+            Simulation sim;
+            bool charging = false;
+            for (long long i = 0; i < n; i++){
+                scriptedDriver(sim.get_time(), sim.get_battery(), sim.get_input(), charging);
+                sim.step(dt, charging);
+            }
+            benchmarkSink = sim.get_speed();
+        }, 1},
+        {"StaticSimulation::step", [&](long long n){
+            StaticSimulation<DefaultVehicleSpec> sim;
+            bool charging = false;
+            for (long long i = 0; i < n; i++){
+                scriptedDriver(sim.get_time(), sim.get_battery().get_SOC(), sim.get_input(), charging);
+                sim.step(dt, charging);
+            }
+            benchmarkSink = sim.get_speed();
+        }, 1},
+        {"StaticMotor::updateSpeed/coast", [&](long long n){
+            StaticMotor<DefaultVehicleSpec> motor;
+            StaticBattery<DefaultVehicleSpec> battery;
+            float speed = 0;
+            for (long long i = 0; i < n; i++){
+                if ((i & 1023) == 0){
+                    motor.set_angularSpeed(1000);
+                    battery.set_Q_current(150);
+                }
+                speed += motor.updateSpeed(0, 0, battery, dt);
+            }
+            benchmarkSink = speed;
+        }, 1},
+        {"TelemetryWriter::write", [&](long long n){
+            TelemetryWriter writer;
+            writer.open(binaryPath, standardTelemetryChannels(true));
+            for (long long i = 0; i < n; i++){
+                float time = i * dt;
+                writer.write(TelemetryRecord{time, 20, 80, 25, 1, 0});
+            }
+            writer.close();
+        }, 1},
+        {"AsyncTelemetryWriter::log", [&](long long n){
+            AsyncTelemetryWriter writer;
+            writer.open(binaryPath);
+            for (long long i = 0; i < n; i++){
+                float time = i * dt;
+                writer.log(TelemetryRecord{time, 20, 80, 25, 1, 0});
+            }
+            writer.close();
+        }, 1},
+        {"loadLog/csv (per row)", [&](long long n){
+            for (long long i = 0; i < n; i++){
+                LogColumns log;
+                loadLog(csvPath, log, nullptr);
+                benchmarkSink = log.rows() > 0 ? log.speed[0] : 0;
+            }
+        }, logRows},
+    };
+
+    if (!writeBenchmarkLog(csvPath, logRows)){
+        cout << "Cannot open file " << csvPath << "\n";
+        return 1;
+    }
+
+    cout << "Microbenchmarks (" << options.repetitions << " repetitions of at least " << options.minTime * 1000
+         << " ms, median reported)\n";
+    cout << left << setw(34) << "benchmark" << right << setw(12) << "ns/op" << setw(16) << "ops/s" << setw(14) << "allocs/op" << "\n";
+    vector<BenchmarkResult> results;
+    for (const Benchmark &benchmark : benchmarks){
+        if (!options.filter.empty() && benchmark.name.find(options.filter) == string::npos){
+            continue;
+        }
+        BenchmarkResult result = runBenchmarkBatch(benchmark.name, benchmark.body, benchmark.opsPerIteration, options);
+        results.push_back(result);
+        cout << left << setw(34) << result.name << right << fixed << setprecision(2) << setw(12) << result.nsPerOp
+             << setprecision(0) << setw(16) << result.opsPerSecond << setprecision(4) << setw(14);
+        if (result.allocationsPerOp < 0){
+            cout << "n/a";
+        } else{
+            cout << result.allocationsPerOp;
+        }
+        cout << defaultfloat << setprecision(6) << "\n";
+    }
+    remove(csvPath.c_str());
+    remove(binaryPath.c_str());
+
+    if (!options.jsonPath.empty()){
+        if (!writeBenchmarkJson(options.jsonPath, results)){
+            return 1;
+        }
+        cout << "Results written to " << options.jsonPath << "\n";
+    }
+    if (!options.baselinePath.empty()){
+        return compareWithBaseline(options.baselinePath, results, options.threshold);
+    }
+    return 0;
+}
@@ -0,0 +1,598 @@
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../headers/cli.h"
+#include "../headers/simulation.h"
+#include "../headers/fleet.h"
+#include "../headers/battery_kernels.h"
+#include "../headers/telemetry.h"
+#include "../headers/log_analytics.h"
+#include "../headers/sweep.h"
+#include "../headers/aging.h"
+#include "../headers/integrator.h"
+#include "../headers/benchmark.h"
+#include "../headers/snapshot.h"
+#include "../headers/vehicle_model.h"
+#include "../headers/depot.h"
+#include "../headers/route.h"
+#include "../headers/range_oracle.h"
+#include "../headers/telemetry_sampling.h"
+#include "../headers/regression.h"
+using namespace std;
+
+//@brief print the available command line modes
+void printUsage(){
+    cout << "Usage:\n";
+    cout << "  main                                   start the interactive simulation window\n";
+    cout << "  main --headless [options]              run the simulation without a window\n";
+    cout << "      --dt <seconds>                     fixed time step (default 0.016)\n";
+    cout << "      --duration <seconds>               simulated time (default 3600)\n";
+    cout << "      --ambient <celsius>                ambient temperature (default 25)\n";
+    cout << "      --log <file>                       log every step (CSV if the name ends in .csv, binary .evtl otherwise)\n";
+    cout << "      --log-sampling <policy>            keep only some rows of the log: all (default), change[:deadband[:heartbeat]],\n";
+    cout << "                                         rate:<seconds> or bucket:<seconds> (mean, min and max per interval)\n";
+    cout << "      --cycle <ece15|file.csv>           replay a drive cycle instead of the scripted driver\n";
+    cout << "                                         (Time,Throttle,Brake or Time,Speed columns; repeats to fill the duration)\n";
+    cout << "      --adaptive [tolerance]             integrate each dt with adaptive steps and events (default tolerance 1e-6)\n";
+    cout << "      --load-state <file.evss>           continue from a saved snapshot instead of a fresh vehicle\n";
+    cout << "      --battery-tables [file]            table-driven battery curves (default assets/battery_tables.txt)\n";
+    cout << "      --save-state <file.evss>           save a snapshot of the full state at the end\n";
+    cout << "      --fidelity <level>                 reduced, standard (default) or detailed model (the fleet step of one vehicle)\n";
+    cout << "  main --fleet [options]                 step many vehicles at once and report throughput\n";
+    cout << "      --vehicles <count>                 fleet size (default 10000)\n";
+    cout << "      --steps <count>                    number of time steps (default 1000)\n";
+    cout << "      --dt <seconds>                     fixed time step (default 0.016)\n";
+    cout << "      --fidelity <level>                 reduced, standard (default) or detailed model; all compares the three\n";
+    cout << "      --scaling [threads]                step with 1 to N threads (default: all cores) and report the speedup\n";
+    cout << "  main --bench [options]                 microbenchmarks of the component hot paths (ns/op, ops/s, allocations/op)\n";
+    cout << "      --filter <text>                    only run benchmarks whose name contains the text\n";
+    cout << "      --min-time <seconds>               time per repetition (default 0.05)\n";
+    cout << "      --repetitions <count>              timed repetitions, the median is reported (default 5)\n";
+    cout << "      --json <file>                      also write the results as JSON\n";
+    cout << "      --baseline <file.json> [--threshold <fraction>]\n";
+    cout << "                                         compare with an earlier run, exit code 1 if slower by more than\n";
+    cout << "                                         the threshold (default 0.1)\n";
+    cout << "  main --check-fast-forward              compare charging/parking fast-forward with stepping frame by frame\n";
+    cout << "  main --check-integrator                compare fixed Euler steps and the adaptive integrator on a test scenario\n";
+    cout << "  main --check-snapshot                  save/restore a warmed-up run and time forking 1000 what-if branches from it\n";
+    cout << "  main --check-static-model              compare the compile-time vehicle models with the runtime classes\n";
+    cout << "  main --check-range                     build the remaining-range table, time queries and check its error\n";
+    cout << "  main --check-fleet                     compare a standard-fidelity fleet with one Simulation per vehicle\n";
+    cout << "  main --regress [options]               run the scenario library and compare every trace with its golden trace\n";
+    cout << "      --golden <file>                    golden traces (default assets/golden_traces.csv)\n";
+    cout << "      --filter <text>                    only run scenarios whose name contains the text\n";
+    cout << "      --threads <count>                  worker threads (default: all cores)\n";
+    cout << "      --update                           write the traces as the new golden traces\n";
+    cout << "  main --bench-battery                   benchmark the batched battery kernels at 1k, 100k and 1M batteries\n";
+    cout << "  main --to-csv <log.evtl> <out.csv>     convert a binary telemetry log to CSV (for graph.py)\n";
+    cout << "  main --decimate <log> <out.csv> [--points n]\n";
+    cout << "                                         keep the rows that shape a plot of each channel (LTTB, default 2000 points)\n";
+    cout << "  main --analyze <log>... [options]      Speed/SOC/BatteryTemp statistics of one or many logs (.csv or .evtl)\n";
+    cout << "      --window <seconds>                 also compute statistics per time window\n";
+    cout << "      --windows-out <file>               write the window statistics to a CSV file\n";
+    cout << "      --threads <count>                  threads used to parse and aggregate (default: all cores)\n";
+    cout << "  main --sweep [options]                 run a grid of vehicle configurations over a drive cycle in parallel\n";
+    cout << "      --capacity, --vmax, --rinternal, --heatcap, --torque, --maxspeed, --wheel <values>\n";
+    cout << "                                         values as from:to:count, v1,v2,... or a single value\n";
+    cout << "      --cycle <ece15|file.csv>           drive cycle (default ece15)\n";
+    cout << "      --duration <seconds>               simulated time per configuration (default 1800)\n";
+    cout << "      --dt <seconds>                     fixed time step (default 0.05)\n";
+    cout << "      --threads <count>                  threads (default: all cores)\n";
+    cout << "      --out <file>                       results table (default sweep.csv)\n";
+    cout << "      --battery-tables [file]            table-driven battery curves, shared by all threads (default assets/battery_tables.txt)\n";
+    cout << "      --resume                           keep finished rows of --out and run only the missing ones\n";
+    cout << "  main --aging [options]                 project battery state of health over years of daily driving\n";
+    cout << "      --years <count>                    length of the projection (default 10)\n";
+    cout << "      --sample-days <count>              simulate one representative day per this many days (default 30)\n";
+    cout << "      --validate-days <count>            days to step in full to check the projection (default 365, 0 to skip)\n";
+    cout << "      --drive-hours <hours>              driving per day (default 1)\n";
+    cout << "      --cycle <ece15|file.csv>           drive cycle (default ece15)\n";
+    cout << "      --ambient <celsius>                yearly mean ambient temperature (default 25)\n";
+    cout << "      --dt <seconds>                     time step while driving (default 0.016)\n";
+    cout << "      --park-dt <seconds>                time step while parked (default 10)\n";
+    cout << "      --tolerance <points>               largest SOH difference from brute force that passes validation (default 0.05)\n";
+    cout << "  main --depot [options]                 discrete-event simulation of a charging depot shared by a fleet\n";
+    cout << "      --vehicles <count>                 vehicles (default 1000)\n";
+    cout << "      --chargers <count>                 charging points (default 20)\n";
+    cout << "      --grid-kw <kW>                     power the depot may draw from the grid (default 150)\n";
+    cout << "      --days <count>                     length of the run (default 30)\n";
+    cout << "      --handling <seconds>               time at a charger before charging starts (default 300)\n";
+    cout << "      --shift-hours <hours>              mean driving time per shift (default 3)\n";
+    cout << "      --seed <number>                    seed of the vehicle schedules (default 1)\n";
+    cout << "  main --routes [options]                estimate energy and arrival SOC of routes with cached segment results\n";
+    cout << "      --file <routes.csv>                Route,Length,Grade,SpeedLimit,Ambient rows (default: generated routes)\n";
+    cout << "      --queries <count>                  route queries to answer (default 10000)\n";
+    cout << "      --check <count>                    queries also answered without the cache to measure its error (default 200)\n";
+    cout << "      --dt <seconds>                     time step of the segment drives (default 0.1)\n";
+    cout << "      --seed <number>                    seed of the generated routes and queries (default 1)\n";
+}
+
+//@brief read the value that follows an option, converting it to a float
+//@param argc, argv - the program arguments, i - index of the option (moved to the value), value - the result
+//@return false if the value is missing or not a positive number
+bool readPositiveFloat(int argc, char* argv[], int &i, float &value){
+    if (i + 1 >= argc){
+        cout << "Missing value for " << argv[i] << "\n";
+        return false;
+    }
+    i++;
+    try{
+        value = stof(argv[i]);
+    } catch (...){
+        cout << "Invalid number: " << argv[i] << "\n";
+        return false;
+    }
+    if (value <= 0){
+        cout << "Value for " << argv[i - 1] << " must be positive\n";
+        return false;
+    }
+    return true;
+}
+
+//@brief read the value that follows an option, converting it to a positive integer
+bool readPositiveInt(int argc, char* argv[], int &i, int &value){
+    float number;
+    if (!readPositiveFloat(argc, argv, i, number)){
+        return false;
+    }
+    value = static_cast<int>(number);
+    if (value <= 0){
+        cout << "Value for " << argv[i - 1] << " must be at least 1\n";
+        return false;
+    }
+    return true;
+}
+
+//@brief read the optional file name after --battery-tables
+//@return the file, or the bundled curves if no file follows
+string readTablesPath(int argc, char* argv[], int &i){
+    if (i + 1 < argc && argv[i + 1][0] != '-'){
+        return argv[++i];
+    }
+    return "assets/battery_tables.txt";
+}
+
+//@brief parse the options of the headless mode and run it
+int runHeadlessCommand(int argc, char* argv[]){
+    HeadlessConfig config;
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--dt"){
+            if (!readPositiveFloat(argc, argv, i, config.dt)) return 1;
+        } else if (arg == "--duration"){
+            if (!readPositiveFloat(argc, argv, i, config.duration)) return 1;
+        } else if (arg == "--ambient"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --ambient\n";
+                return 1;
+            }
+            try{
+                config.ambientTemp = stof(argv[++i]); //Ambient temperature may be negative
+            } catch (...){
+                cout << "Invalid number: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--log"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --log\n";
+                return 1;
+            }
+            config.logPath = argv[++i];
+        } else if (arg == "--log-sampling"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --log-sampling\n";
+                return 1;
+            }
+            if (!parseSamplingPolicy(argv[++i], config.logSampling)) return 1;
+        } else if (arg == "--cycle"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --cycle\n";
+                return 1;
+            }
+            config.cycle = argv[++i];
+        } else if (arg == "--battery-tables"){
+            config.tablesPath = readTablesPath(argc, argv, i);
+        } else if (arg == "--load-state" || arg == "--save-state"){
+            if (i + 1 >= argc){
+                cout << "Missing value for " << arg << "\n";
+                return 1;
+            }
+            if (arg == "--load-state"){
+                config.loadStatePath = argv[++i];
+            } else{
+                config.saveStatePath = argv[++i];
+            }
+        } else if (arg == "--fidelity"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --fidelity\n";
+                return 1;
+            }
+            if (!parseFidelity(argv[++i], config.fidelity)) return 1;
+        } else if (arg == "--adaptive"){
+            config.adaptive = true;
+            //The tolerance is optional
+            if (i + 1 < argc && argv[i + 1][0] != '-'){
+                float tolerance;
+                if (!readPositiveFloat(argc, argv, i, tolerance)) return 1;
+                config.integrator.relTol = tolerance;
+                config.integrator.absTol = tolerance;
+            }
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    return runHeadless(config);
+}
+
+//@brief parse the options of the fleet benchmark and run it
+int runFleetCommand(int argc, char* argv[]){
+    int vehicles = 10000, steps = 1000;
+    float dt = 0.016;
+    int maxThreads = 0; //0 means no scaling run
+    Fidelity level = Fidelity::Standard;
+    bool compareFidelity = false;
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--vehicles"){
+            if (!readPositiveInt(argc, argv, i, vehicles)) return 1;
+        } else if (arg == "--steps"){
+            if (!readPositiveInt(argc, argv, i, steps)) return 1;
+        } else if (arg == "--dt"){
+            if (!readPositiveFloat(argc, argv, i, dt)) return 1;
+        } else if (arg == "--fidelity"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --fidelity\n";
+                return 1;
+            }
+            string name = argv[++i];
+            if (name == "all"){
+                compareFidelity = true;
+            } else if (!parseFidelity(name, level)){
+                return 1;
+            }
+        } else if (arg == "--scaling"){
+            maxThreads = static_cast<int>(thread::hardware_concurrency());
+            if (maxThreads < 1){
+                maxThreads = 1;
+            }
+            //The thread count is optional
+            if (i + 1 < argc && argv[i + 1][0] != '-'){
+                if (!readPositiveInt(argc, argv, i, maxThreads)) return 1;
+            }
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (compareFidelity){
+        return runFidelityComparison(vehicles, steps, dt);
+    }
+    if (maxThreads > 0){
+        return runFleetScaling(vehicles, steps, dt, maxThreads);
+    }
+    return runFleetBenchmark(vehicles, steps, dt, level);
+}
+
+//@brief parse the options of the log analytics and run it
+int runAnalyzeCommand(int argc, char* argv[]){
+    vector<string> paths;
+    float window = 0;
+    int threads = static_cast<int>(thread::hardware_concurrency());
+    string windowsPath;
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--window"){
+            if (!readPositiveFloat(argc, argv, i, window)) return 1;
+        } else if (arg == "--threads"){
+            if (!readPositiveInt(argc, argv, i, threads)) return 1;
+        } else if (arg == "--windows-out"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --windows-out\n";
+                return 1;
+            }
+            windowsPath = argv[++i];
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0){
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        } else{
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()){
+        cout << "No log files given\n";
+        return 1;
+    }
+    if (!windowsPath.empty() && window <= 0){
+        cout << "--windows-out needs --window\n";
+        return 1;
+    }
+    return runLogAnalytics(paths, window, threads < 1 ? 1 : threads, windowsPath);
+}
+
+//@brief parse the options of the parameter sweep and run it
+int runSweepCommand(int argc, char* argv[]){
+    ParameterSweep sweep;
+    SweepOptions options;
+    options.threads = static_cast<int>(thread::hardware_concurrency());
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--duration"){
+            if (!readPositiveFloat(argc, argv, i, options.duration)) return 1;
+        } else if (arg == "--dt"){
+            if (!readPositiveFloat(argc, argv, i, options.dt)) return 1;
+        } else if (arg == "--threads"){
+            if (!readPositiveInt(argc, argv, i, options.threads)) return 1;
+        } else if (arg == "--resume"){
+            options.resume = true;
+        } else if (arg == "--battery-tables"){
+            options.tablesPath = readTablesPath(argc, argv, i);
+        } else if (arg == "--cycle" || arg == "--out"){
+            if (i + 1 >= argc){
+                cout << "Missing value for " << arg << "\n";
+                return 1;
+            }
+            (arg == "--cycle" ? options.cycle : options.outputPath) = argv[++i];
+        } else if (arg.size() > 2 && arg.compare(0, 2, "--") == 0 && i + 1 < argc){
+            if (!sweep.setValues(arg.substr(2), argv[++i])){
+                return 1;
+            }
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (options.threads < 1){
+        options.threads = 1;
+    }
+    return runSweep(sweep, options);
+}
+
+//@brief parse the options of the aging projection and run it
+int runAgingCommand(int argc, char* argv[]){
+    AgingOptions options;
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--years"){
+            if (!readPositiveInt(argc, argv, i, options.years)) return 1;
+        } else if (arg == "--sample-days"){
+            if (!readPositiveInt(argc, argv, i, options.sampleDays)) return 1;
+        } else if (arg == "--validate-days"){
+            if (i + 1 >= argc){
+                cout << "Missing value for " << arg << "\n";
+                return 1;
+            }
+            try{
+                options.validateDays = stoi(argv[++i]);
+            } catch (...){
+                cout << "Invalid number: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--drive-hours"){
+            if (!readPositiveFloat(argc, argv, i, options.driveHours)) return 1;
+        } else if (arg == "--ambient"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --ambient\n";
+                return 1;
+            }
+            try{
+                options.ambientMean = stof(argv[++i]); //Ambient temperature may be negative
+            } catch (...){
+                cout << "Invalid number: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--dt"){
+            if (!readPositiveFloat(argc, argv, i, options.dt)) return 1;
+        } else if (arg == "--park-dt"){
+            if (!readPositiveFloat(argc, argv, i, options.parkDt)) return 1;
+        } else if (arg == "--tolerance"){
+            if (!readPositiveFloat(argc, argv, i, options.tolerance)) return 1;
+        } else if (arg == "--cycle" && i + 1 < argc){
+            options.cycle = argv[++i];
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (options.driveHours > 15){
+        cout << "At most 15 hours of driving per day\n";
+        return 1;
+    }
+    return runAging(options);
+}
+
+//@brief parse the options of the depot simulation and run it
+int runDepotCommand(int argc, char* argv[]){
+    DepotOptions options;
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--vehicles"){
+            if (!readPositiveInt(argc, argv, i, options.vehicles)) return 1;
+        } else if (arg == "--chargers"){
+            if (!readPositiveInt(argc, argv, i, options.chargers)) return 1;
+        } else if (arg == "--grid-kw"){
+            float kW;
+            if (!readPositiveFloat(argc, argv, i, kW)) return 1;
+            options.gridPowerCap = kW * 1000;
+        } else if (arg == "--days"){
+            if (!readPositiveInt(argc, argv, i, options.days)) return 1;
+        } else if (arg == "--handling"){
+            if (!readPositiveFloat(argc, argv, i, options.handlingSeconds)) return 1;
+        } else if (arg == "--shift-hours"){
+            if (!readPositiveFloat(argc, argv, i, options.shiftHours)) return 1;
+        } else if (arg == "--seed"){
+            int seed;
+            if (!readPositiveInt(argc, argv, i, seed)) return 1;
+            options.seed = seed;
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (options.shiftHours + options.shiftHoursSpread + options.shiftStart + options.shiftStartSpread >= 24){
+        cout << "A shift has to end before the next day's departures\n";
+        return 1;
+    }
+    return runDepot(options);
+}
+
+//@brief parse the options of the route estimator benchmark and run it
+int runRoutesCommand(int argc, char* argv[]){
+    RouteQueryOptions options;
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--file" && i + 1 < argc){
+            options.routesPath = argv[++i];
+        } else if (arg == "--queries"){
+            if (!readPositiveInt(argc, argv, i, options.queries)) return 1;
+        } else if (arg == "--check"){
+            if (i + 1 >= argc){
+                cout << "Missing value for --check\n";
+                return 1;
+            }
+            try{
+                options.checkQueries = stoi(argv[++i]); //0 skips the check
+            } catch (...){
+                cout << "Invalid number: " << argv[i] << "\n";
+                return 1;
+            }
+        } else if (arg == "--dt"){
+            if (!readPositiveFloat(argc, argv, i, options.dt)) return 1;
+        } else if (arg == "--seed"){
+            int seed;
+            if (!readPositiveInt(argc, argv, i, seed)) return 1;
+            options.seed = seed;
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    return runRouteQueries(options);
+}
+
+//@brief parse the options of the regression run and run it
+int runRegressCommand(int argc, char* argv[]){
+    RegressionOptions options;
+    options.threads = static_cast<int>(thread::hardware_concurrency());
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--threads"){
+            if (!readPositiveInt(argc, argv, i, options.threads)) return 1;
+        } else if (arg == "--dt"){
+            if (!readPositiveFloat(argc, argv, i, options.dt)) return 1;
+        } else if (arg == "--update"){
+            options.update = true;
+        } else if ((arg == "--golden" || arg == "--filter") && i + 1 < argc){
+            (arg == "--golden" ? options.goldenPath : options.filter) = argv[++i];
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    if (options.threads < 1){
+        options.threads = 1;
+    }
+    return runRegression(options);
+}
+
+//@brief parse the options of --decimate and decimate the log
+int runDecimateCommand(int argc, char* argv[]){
+    if (argc < 4){
+        printUsage();
+        return 1;
+    }
+    int points = 2000;
+    for (int i = 4; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--points"){
+            if (!readPositiveInt(argc, argv, i, points)) return 1;
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    return decimateLog(argv[2], argv[3], points) ? 0 : 1;
+}
+
+//@brief parse the options of the microbenchmarks and run them
+int runBenchCommand(int argc, char* argv[]){
+    BenchmarkOptions options;
+    for (int i = 2; i < argc; i++){
+        string arg = argv[i];
+        if (arg == "--min-time"){
+            float seconds;
+            if (!readPositiveFloat(argc, argv, i, seconds)) return 1;
+            options.minTime = seconds;
+        } else if (arg == "--repetitions"){
+            if (!readPositiveInt(argc, argv, i, options.repetitions)) return 1;
+        } else if (arg == "--threshold"){
+            float threshold;
+            if (!readPositiveFloat(argc, argv, i, threshold)) return 1;
+            options.threshold = threshold;
+        } else if ((arg == "--filter" || arg == "--json" || arg == "--baseline") && i + 1 < argc){
+            (arg == "--filter" ? options.filter : arg == "--json" ? options.jsonPath : options.baselinePath) = argv[++i];
+        } else{
+            cout << "Unknown option: " << arg << "\n";
+            printUsage();
+            return 1;
+        }
+    }
+    return runBenchmarks(options);
+}
+
+int runCommandLine(int argc, char* argv[]){
+    string mode = argv[1];
+    if (mode == "--headless"){
+        return runHeadlessCommand(argc, argv);
+    } else if (mode == "--fleet"){
+        return runFleetCommand(argc, argv);
+    } else if (mode == "--bench"){
+        return runBenchCommand(argc, argv);
+    } else if (mode == "--check-fast-forward"){
+        return runFastForwardCheck();
+    } else if (mode == "--check-integrator"){
+        return runIntegratorCheck();
+    } else if (mode == "--check-snapshot"){
+        return runSnapshotCheck();
+    } else if (mode == "--check-static-model"){
+        return runStaticModelCheck();
+    } else if (mode == "--check-fleet"){
+        return runFleetCheck();
+    } else if (mode == "--check-range"){
+        return runRangeOracleCheck();
+    } else if (mode == "--regress"){
+        return runRegressCommand(argc, argv);
+    } else if (mode == "--bench-battery"){
+        return runBatteryKernelBenchmark();
+    } else if (mode == "--to-csv"){
+        if (argc != 4){
+            printUsage();
+            return 1;
+        }
+        return convertTelemetryToCsv(argv[2], argv[3]) ? 0 : 1;
+    } else if (mode == "--decimate"){
+        return runDecimateCommand(argc, argv);
+    } else if (mode == "--analyze"){
+        return runAnalyzeCommand(argc, argv);
+    } else if (mode == "--sweep"){
+        return runSweepCommand(argc, argv);
+    } else if (mode == "--aging"){
+        return runAgingCommand(argc, argv);
+    } else if (mode == "--depot"){
+        return runDepotCommand(argc, argv);
+    } else if (mode == "--routes"){
+        return runRoutesCommand(argc, argv);
+    }
+    printUsage();
+    return mode == "--help" ? 0 : 1;
+}
@@ -1,7 +1,11 @@
 #include <iostream>
+#include <cmath>
 #include "../headers/driver_input.h"
 #include "../headers/vehicle.h"
 #include "../headers/components.h"
+#include "../headers/profiler.h"
+#include "../headers/snapshot.h"
+#include "../headers/battery_tables.h"
 using namespace std;
 
 
@@ -22,7 +26,7 @@ Battery::Battery(float Q_max, float V_max, float R_internal, float heatCapacity)
         this->voltage = 0.9 * V_max; //nominal voltage is about 90% of the max voltage 
     } 
     if (R_internal <= -1){
-        R_internal = 0.02;
+        this->R_internal = 0.02;
     } else {
         this->R_internal = R_internal;
     }
@@ -37,7 +41,10 @@ Battery::Battery(float Q_max, float V_max, float R_internal, float heatCapacity)
     this->temperature = 25; 
     this->totalTimeSeconds = 0;     
     this->totalDistanceKm = 0; 
-
+    this->cycleCharge = 0;
+    this->cycleFade = 0.1;
+    this->thermalFade = 0.001;
+    this->tables = nullptr;
 
 };
 
@@ -55,9 +62,88 @@ Battery::Battery(){
     temperature = 25; //Room temperature in Celsius at the start
     totalTimeSeconds = 0; //by default starts at 0
     totalDistanceKm = 0; //by default starts at 0
+    cycleCharge = 0; //no charge used yet
+    cycleFade = 0.1; //10% per cycle (chosen for showcase)
+    thermalFade = 0.001; //per second per degree above 40°C
+    tables = nullptr; //Fixed model
 
 };
 
+//copy constructor (copies every field, so a copy continues exactly where the original is)
+Battery::Battery(const Battery& other){
+    *this = other;
+}
+
+//assignment operator overload
+Battery& Battery::operator=(const Battery& other){
+    if (this != &other){
+        Q_max = other.Q_max;
+        Q_now = other.Q_now;
+        V_max = other.V_max;
+        R_internal = other.R_internal;
+        voltage = other.voltage;
+        current = other.current;
+        stateOfHealth = other.stateOfHealth;
+        temperature = other.temperature;
+        heatCapacity = other.heatCapacity;
+        heatTransferCoeff = other.heatTransferCoeff;
+        totalTimeSeconds = other.totalTimeSeconds;
+        totalDistanceKm = other.totalDistanceKm;
+        cycleCharge = other.cycleCharge;
+        cycleFade = other.cycleFade;
+        thermalFade = other.thermalFade;
+        tables = other.tables;
+    }
+    return *this;
+}
+
+//@brief write every field to a snapshot section
+void Battery::saveState(StateWriter &out){
+    out.beginSection("BATT");
+    out.putFloat(Q_max);
+    out.putFloat(Q_now);
+    out.putFloat(V_max);
+    out.putFloat(R_internal);
+    out.putFloat(voltage);
+    out.putFloat(current);
+    out.putFloat(stateOfHealth);
+    out.putFloat(temperature);
+    out.putFloat(heatCapacity);
+    out.putFloat(heatTransferCoeff);
+    out.putFloat(totalTimeSeconds);
+    out.putFloat(totalDistanceKm);
+    out.putFloat(cycleCharge);
+    out.putFloat(cycleFade);
+    out.putFloat(thermalFade);
+    out.endSection();
+}
+
+//@brief read the fields back from a snapshot section
+//@return false if the section is too short (the object is then left unchanged)
+bool Battery::loadState(StateReader in){
+    Battery loaded(*this);
+    loaded.Q_max = in.getFloat();
+    loaded.Q_now = in.getFloat();
+    loaded.V_max = in.getFloat();
+    loaded.R_internal = in.getFloat();
+    loaded.voltage = in.getFloat();
+    loaded.current = in.getFloat();
+    loaded.stateOfHealth = in.getFloat();
+    loaded.temperature = in.getFloat();
+    loaded.heatCapacity = in.getFloat();
+    loaded.heatTransferCoeff = in.getFloat();
+    loaded.totalTimeSeconds = in.getFloat();
+    loaded.totalDistanceKm = in.getFloat();
+    loaded.cycleCharge = in.getFloat();
+    loaded.cycleFade = in.getFloat();
+    loaded.thermalFade = in.getFloat();
+    if (!in.is_ok()){
+        return false;
+    }
+    *this = loaded;
+    return true;
+}
+
 //@brief function that returns the state of charge of the battery
 float Battery::get_SOC(){
     //the current state of charge in percent is the ratio of charge remaining and max charge capacity
@@ -69,20 +155,39 @@ void Battery::setCurrent(float I) {
     current = I;
 }
 
+//The discharge rate coefficient
+const float BASE_DISCHARGE_RATE = 10; //0.01
+
+//@brief how temperature changes the discharge rate
+float dischargeTempFactor(float temperature){
+    if (temperature < COLD_DISCHARGE_LIMIT){
+        return 0.7;  //When temperature is below 0 C, discharge is 30% less effective
+    } else if (temperature > HOT_DISCHARGE_LIMIT){
+        return 1.2;  //There is 20% more discharge at high temperatures
+    }
+    return 1.0; //Base factor at reasonable temperatures
+}
+
+//@brief discharge rate factor at a temperature: the tiers of the fixed model, or the discharge curve
+float Battery::tempFactor(float temperature){
+    return tables == nullptr ? dischargeTempFactor(temperature) : tables->discharge.at(temperature);
+}
+
+//@brief internal resistance at the battery's temperature
+float Battery::resistance(){
+    return tables == nullptr ? R_internal : R_internal * tables->resistance.at(temperature);
+}
+
 //@brief function that discharges the battery by modifyin the current amount of charge in the battery
 //based on speed and time. Discharge rate is affected by temperature. This function is called every fraction of a second in main. 
 //@param speed - the current speed of the car, delta_t - the change in time (which would be the interval between each frame)
 void Battery::discharge(float speed, float delta_t){
+    PROFILE_SCOPE("Battery::discharge");
     //The discharge rate coefficient
-    float baseDischargeRate = 10; //0.01
+    float baseDischargeRate = BASE_DISCHARGE_RATE;
 
     //Temperature factor adjustment
-    float tempFactor = 1.0; //Base factor at reasonable temperatures 
-    if (temperature < 0){
-        tempFactor = 0.7;  //When temperature is below 0 C, discharge is 30% less effective
-    } else if (temperature > 40.0){
-        tempFactor = 1.2;  //There is 20% more discharge at high temperatures
-    }
+    float tempFactor = this->tempFactor(temperature);
 
     //Calculate deltaQ (change in charge) based on the Base discharge rate, temperature factor
     //Assume a linear discharge rate proportional to speed and delta_t
@@ -102,8 +207,10 @@ void Battery::discharge(float speed, float delta_t){
 //@brief function that charges the battery. This function is called when the EV is going through a charging station.
 //@param V_applied - Charging station applies a voltage, delta_t - how long was this voltage applied for, isFull - indicates if the battery is full
 bool Battery::charge(float V_applied, float delta_t, bool &isFull){
+    PROFILE_SCOPE("Battery::charge");
     //The change in charge is the current applied (V_applied/R_internal) times the change in time (which will be every frame)
-    float deltaQ = delta_t*V_applied/(1000*R_internal); 
+    //With tables, the resistance depends on the temperature and less of the current is stored near full
+    float deltaQ = tables == nullptr ? delta_t*V_applied/(1000*R_internal) : delta_t*chargeRate(V_applied);
 
     //Ensure that Q_now is capped at Q_max
     if(Q_now < Q_max){
@@ -125,9 +232,10 @@ bool Battery::charge(float V_applied, float delta_t, bool &isFull){
 //@param delta_t - time elapsed, ambientTemp - temperature of the environment
 //@return temperature
 float Battery::updateTemperature(float delta_t, float ambientTemp){
+    PROFILE_SCOPE("Battery::updateTemperature");
     //Formulas listed below:
     //Q = I^2 * R * t
-    float heatGenerated = 0.00001 * current * current * R_internal * delta_t;
+    float heatGenerated = 0.00001 * current * current * resistance() * delta_t;
 
     //Q = h * (T_batt - T_ambient) * t
     float cooling = heatTransferCoeff * (temperature - ambientTemp) * delta_t;
@@ -144,6 +252,68 @@ float Battery::updateTemperature(float delta_t, float ambientTemp){
     return temperature;
 }
 
+//@return half the float spacing at a value: a smaller change added to it rounds away
+float halfUlp(float value){
+    value = fabs(value);
+    return (nextafterf(value, INFINITY) - value) / 2;
+}
+
+//@brief the result of calling updateTemperature steps times with the same current and ambient
+//temperature, in one go. Every step moves the temperature a fixed fraction of the way to the
+//temperature where heating and cooling balance, so after n steps the remaining gap is (1 - fraction)^n.
+//Near the balance a step's change is smaller than half the float spacing of the temperature and rounds
+//away, so stepping stalls there; the relaxation stops at the same gap.
+//@param steps - number of updateTemperature calls to skip, delta_t - length of each, ambientTemp - temperature of the environment
+//@return temperature
+float Battery::relaxTemperature(long long steps, float delta_t, float ambientTemp){
+    if (steps <= 0){
+        return temperature;
+    }
+    double heating = 0.00001 * current * current * resistance() * delta_t / heatCapacity; //Per step (with tables, at the starting temperature)
+    double fraction = heatTransferCoeff * delta_t / static_cast<double>(heatCapacity); //Per step
+    if (fraction <= 0){
+        if (fabs(heating) > halfUlp(temperature)){
+            temperature += heating * steps;
+        }
+    } else{
+        double balance = ambientTemp + heating / fraction;
+        double gap = temperature - balance;
+        //Gap where a step stops changing the temperature, with the spacing on the side the temperature comes from
+        double stallGap = halfUlp(static_cast<float>(balance)) / fraction;
+        stallGap = halfUlp(static_cast<float>(gap > 0 ? balance + stallGap : balance - stallGap)) / fraction;
+        if (fabs(gap) > stallGap){
+            double stallSteps = ceil(log(stallGap / fabs(gap)) / log(1 - fraction));
+            double relaxed = stallSteps < steps ? stallSteps : static_cast<double>(steps);
+            temperature = balance + gap * pow(1 - fraction, relaxed);
+        }
+    }
+    return temperature;
+}
+
+//@brief charge drawn per second while driving at a speed (the rate discharge() applies over delta_t)
+//@param speed - vehicle speed, temperature - battery temperature
+//@return Ah/s
+float Battery::dischargeRate(float speed, float temperature){
+    return BASE_DISCHARGE_RATE * speed * tempFactor(temperature) / 3600;
+}
+
+//@brief charge gained per second at a charging voltage (the rate charge() applies over delta_t)
+float Battery::chargeRate(float V_applied){
+    if (tables == nullptr){
+        return V_applied / (1000 * R_internal);
+    }
+    return V_applied / (1000 * resistance()) * tables->chargeEfficiency.at(get_SOC());
+}
+
+//@brief temperature change per second (the rate updateTemperature() applies over delta_t)
+//@param temperature - battery temperature, current - battery current, ambientTemp - temperature of the environment
+float Battery::heatBalance(float temperature, float current, float ambientTemp){
+    float R = tables == nullptr ? R_internal : R_internal * tables->resistance.at(temperature);
+    float heatGenerated = 0.00001 * current * current * R;
+    float cooling = heatTransferCoeff * (temperature - ambientTemp);
+    return (heatGenerated - cooling) / heatCapacity;
+}
+
 //@brief update the battery's state of health based on usage
 //@param delta_t - time elapsed (to update function every call)
 void Battery::degradeSOH(float delta_t){
@@ -151,7 +321,7 @@ void Battery::degradeSOH(float delta_t){
     if (temperature > 40){
         //Decrease the state of health proportionally to by how much the temperature
         //exceeds 40°C and how long this condition lasts (delta_t).
-        stateOfHealth -= 0.001 * delta_t * (temperature - 40);
+        stateOfHealth -= thermalFade * delta_t * (temperature - 40);
         //Cap at zero
         if (stateOfHealth < 0) {
             stateOfHealth = 0;
@@ -172,17 +342,14 @@ void Battery::rechargeFromRegen(float deltaQ){
 //@brief function that degrades the battery's state of health based on charge used
 //@param deltaQ - change in charge
 void Battery::degradeWithCycle(float deltaQ){
-    //Static variable to accumulate charge
-    static float cycleCharge = 0;
-
     //Add the value of deltaQ (charge used or replenished) to the accumulator
     cycleCharge += deltaQ;
 
     //When the accumulated charge reaches or exceeds the battery's max capacity,
     //we consider one full charge-discharge cycle completed
     if (cycleCharge >= Q_max) {
-        //Decrease the state of health by 10% per full cycle (10% is not a realistic parameter, but it was chosen for simplicity and showcase)
-        stateOfHealth -= 0.1;
+        //Decrease the state of health by 10% per full cycle by default (10% is not a realistic parameter, but it was chosen for simplicity and showcase)
+        stateOfHealth -= cycleFade;
 
         //Prevent SOH from dropping below zero.
         if (stateOfHealth < 0) 
@@ -193,6 +360,16 @@ void Battery::degradeWithCycle(float deltaQ){
     }
 }
 
+//@brief battery wear after a step, the order every wearing run applies it in (aging projection, sweeps,
+//regression scenarios; Fleet::wear does the same on its arrays)
+//@param drawn - charge drawn over the step (Ah, nothing if the battery gained charge), delta_t - step length
+void Battery::wear(float drawn, float delta_t){
+    degradeSOH(delta_t);
+    if (drawn > 0){
+        degradeWithCycle(drawn);
+    }
+}
+
 //setters
 void Battery::set_Q_max(float Q){
     Q_max = Q;
@@ -214,6 +391,18 @@ void Battery::set_SOH(float SOH){
     stateOfHealth = SOH;
 }
 
+void Battery::set_cycleFade(float fade){
+    cycleFade = fade;
+}
+
+void Battery::set_thermalFade(float fade){
+    thermalFade = fade;
+}
+
+void Battery::set_temp(float T){
+    temperature = T;
+}
+
 //getters
 float Battery::get_Q_max(){
     return Q_max;
@@ -231,6 +420,22 @@ float Battery::get_R_internal(){
     return R_internal;
 }
 
+float Battery::get_heatCapacity(){
+    return heatCapacity;
+}
+
+float Battery::get_heatTransferCoeff(){
+    return heatTransferCoeff;
+}
+
+float Battery::get_cycleFade(){
+    return cycleFade;
+}
+
+float Battery::get_thermalFade(){
+    return thermalFade;
+}
+
 float Battery::get_SOH(){
     return stateOfHealth;
 }
@@ -239,6 +444,26 @@ float Battery::get_temp(){
     return temperature;
 }
 
+void Battery::set_tables(const BatteryTables* tables){
+    this->tables = tables;
+}
+
+const BatteryTables* Battery::get_tables(){
+    return tables;
+}
+
+float Battery::get_voltage(){
+    if (tables == nullptr){
+        return voltage;
+    }
+    //The current is negative while discharging, so the voltage sags below the OCV, and rises while charging
+    return V_max * tables->ocv.at(get_SOC()) + current * resistance();
+}
+
+float Battery::get_current(){
+    return current;
+}
+
 
 /////////////////////////////////////////////////////////////////////////////////////////
 //default constructor
@@ -255,15 +480,14 @@ Motor::Motor(){
     heatTransferCoeff = 1.2; // Heat transfer coefficient for motor cooling (W/C)
     temperature = 25; // Current temperature of the motor (C)
     heatCapacity = 12; // Thermal capacity of motor, heat needed to raise temp by 1°C (J/C)
+    angularSpeed = 0; // The wheels start at rest
 }
 
 //constructor for user chosen parameters
 Motor::Motor(float maxTorque, float maxSpeed){
-        if(maxTorque == -1){
-            this->maxTorque = 200;
-        }
-        this->maxTorque = maxTorque;
-        this->maxSpeed = maxSpeed;
+        //-1 selects the default value
+        this->maxTorque = maxTorque == -1 ? 200 : maxTorque;
+        this->maxSpeed = maxSpeed == -1 ? 100 : maxSpeed;
         speed = 0; //Speed of the vehicle in km/h
         R_internal = 0; //Internal resistance of the motor - we haven't actually used this attribute anywhere yet as we only modelled the electrical activity of the battery, but we plan to in the future
         efficiency = 1; //Efficiency of the motor - also can be implemented in the future
@@ -274,6 +498,7 @@ Motor::Motor(float maxTorque, float maxSpeed){
         heatTransferCoeff = 1.2; // Heat transfer coefficient for motor cooling (W/C)
         temperature = 25; // Current temperature of the motor (C)
         heatCapacity = 12;
+        angularSpeed = 0;
     }
 
 //copy constructor
@@ -288,6 +513,7 @@ Motor::Motor(const Motor& other) : maxTorque(other.maxTorque), maxSpeed(other.ma
         this->heatTransferCoeff = other.heatTransferCoeff; // Heat transfer coefficient for motor cooling (W/C)
         this->temperature = other.temperature; // Current temperature of the motor (C)
         this->heatCapacity = other.heatCapacity;
+        this->angularSpeed = other.angularSpeed;
 }
 
 //assignment operator overload
@@ -305,10 +531,54 @@ Motor& Motor::operator=(const Motor& other) {
         heatTransferCoeff = other.heatTransferCoeff;
         temperature = other.temperature;
         heatCapacity = other.heatCapacity;
+        angularSpeed = other.angularSpeed;
     }
     return *this;
 }
 
+//@brief write every field to a snapshot section
+void Motor::saveState(StateWriter &out){
+    out.beginSection("MOTR");
+    out.putFloat(speed);
+    out.putFloat(R_internal);
+    out.putFloat(efficiency);
+    out.putFloat(maxSpeed);
+    out.putFloat(maxTorque);
+    out.putFloat(maxBrakeTorque);
+    out.putFloat(inertia);
+    out.putFloat(regenEfficiency);
+    out.putFloat(maxRegenPower);
+    out.putFloat(heatTransferCoeff);
+    out.putFloat(temperature);
+    out.putFloat(heatCapacity);
+    out.putFloat(angularSpeed);
+    out.endSection();
+}
+
+//@brief read the fields back from a snapshot section
+//@return false if the section is too short (the object is then left unchanged)
+bool Motor::loadState(StateReader in){
+    Motor loaded(*this);
+    loaded.speed = in.getFloat();
+    loaded.R_internal = in.getFloat();
+    loaded.efficiency = in.getFloat();
+    loaded.maxSpeed = in.getFloat();
+    loaded.maxTorque = in.getFloat();
+    loaded.maxBrakeTorque = in.getFloat();
+    loaded.inertia = in.getFloat();
+    loaded.regenEfficiency = in.getFloat();
+    loaded.maxRegenPower = in.getFloat();
+    loaded.heatTransferCoeff = in.getFloat();
+    loaded.temperature = in.getFloat();
+    loaded.heatCapacity = in.getFloat();
+    loaded.angularSpeed = in.getFloat();
+    if (!in.is_ok()){
+        return false;
+    }
+    *this = loaded;
+    return true;
+}
+
 //@brief function that checks if regenerative braking is being applied
 //@param input - driver's input to check brake conditions
 //@return true if it's in regenerative state
@@ -367,15 +637,10 @@ void Motor::set_speed(float num){
     }
 }
 
-//@brief function that updates speed based on driver input
-//@param input - driver input (throttle/brake), battery - the battery being used by the car, vehicle - the vehicle being used (for its wheelRadius), deltaTime - time elapsed
-//@return speed
-float Motor::updateSpeed(DriverInput &input, EV &vehicle, Battery &battery, float deltaTime){
-    if (isRegenerating(input)){ //check if regenerative braking is at play
-        applyRegenerativeBraking(input, vehicle, battery, deltaTime); //apply regenerative braking
-    }
-    //set angular Speed to 0 initially
-    static float angularSpeed = 0;
+//@brief angular acceleration of the wheels for the driver input (throttle, brake or passive drag)
+//@param input - driver input (throttle/brake)
+//@return rad/s^2
+float Motor::angularAcceleration(DriverInput &input){
     float netTorque = 0;
     //get inputs
     float throttle = input.get_throttle();
@@ -400,7 +665,19 @@ float Motor::updateSpeed(DriverInput &input, EV &vehicle, Battery &battery, floa
     }
 
     //Calculate angular acceleration using torque/inertia
-    float angularAcceleration = netTorque / inertia;
+    return netTorque / inertia;
+}
+
+//@brief function that updates speed based on driver input
+//@param input - driver input (throttle/brake), battery - the battery being used by the car, vehicle - the vehicle being used (for its wheelRadius), deltaTime - time elapsed
+//@return speed
+float Motor::updateSpeed(DriverInput &input, EV &vehicle, Battery &battery, float deltaTime){
+    PROFILE_SCOPE("Motor::updateSpeed");
+    if (isRegenerating(input)){ //check if regenerative braking is at play
+        applyRegenerativeBraking(input, vehicle, battery, deltaTime); //apply regenerative braking
+    }
+    //Calculate angular acceleration using torque/inertia
+    float angularAcceleration = this->angularAcceleration(input);
     angularSpeed += angularAcceleration * deltaTime;
 
     //No negative angular speed is allowed as our car does not go in reverse yet
@@ -423,6 +700,50 @@ float Motor::updateSpeed(DriverInput &input, EV &vehicle, Battery &battery, floa
 }
 
 
+float Motor::get_maxSpeed(){
+    return maxSpeed;
+}
+
+float Motor::get_maxTorque(){
+    return maxTorque;
+}
+
+float Motor::get_maxBrakeTorque(){
+    return maxBrakeTorque;
+}
+
+float Motor::get_inertia(){
+    return inertia;
+}
+
+float Motor::get_R_internal(){
+    return R_internal;
+}
+
+float Motor::get_efficiency(){
+    return efficiency;
+}
+
+void Motor::set_R_internal(float R){
+    R_internal = R;
+}
+
+void Motor::set_efficiency(float efficiency){
+    this->efficiency = efficiency;
+}
+
+float Motor::get_regenEfficiency(){
+    return regenEfficiency;
+}
+
+float Motor::get_angularSpeed(){
+    return angularSpeed;
+}
+
+void Motor::set_angularSpeed(float w){
+    angularSpeed = w;
+}
+
 void Motor:: setMaxRegenPower(float power) {
     maxRegenPower = power;
 }
@@ -440,12 +761,18 @@ Charger::Charger(){
     efficiency = 0.9; // 90% efficiency
 }
 
+//@brief voltage the charger applies to a battery (based on the max voltage of the battery)
+float Charger::chargingVoltage(Battery &battery){
+    return 0.2 *battery.get_V_max();
+}
+
 //@brief start delivering current to battery
 //@param battery - the battery object, delta_t - time elapsed
 void Charger::startCharging(Battery &battery, float delta_t){
+    PROFILE_SCOPE("Charger::startCharging");
     isCharging = true;
     //simple charging logic
-    float chargingVoltage = 0.2 *battery.get_V_max(); //set charging voltage based on max voltage of battery
+    float chargingVoltage = this->chargingVoltage(battery);
     float chargingCurrent = maxPowerOutput / chargingVoltage * efficiency; //current = power / voltage * efficiency
     if(battery.charge(chargingVoltage, delta_t, isCharging) == true){
         //if true then stop charging
@@ -457,7 +784,35 @@ bool Charger::get_charging_state(){
     return isCharging;
 }
 
+//@brief power the charger can deliver (W)
+float Charger::get_maxPowerOutput(){
+    return maxPowerOutput;
+}
+
 //@brief stop charging the battery
 void Charger::stopCharging(){
     isCharging = false;
-}
\ No newline at end of file
+}
+
+//@brief write every field to a snapshot section
+void Charger::saveState(StateWriter &out){
+    out.beginSection("CHRG");
+    out.putBool(isCharging);
+    out.putFloat(maxPowerOutput);
+    out.putFloat(efficiency);
+    out.endSection();
+}
+
+//@brief read the fields back from a snapshot section
+//@return false if the section is too short (the object is then left unchanged)
+bool Charger::loadState(StateReader in){
+    Charger loaded(*this);
+    loaded.isCharging = in.getBool();
+    loaded.maxPowerOutput = in.getFloat();
+    loaded.efficiency = in.getFloat();
+    if (!in.is_ok()){
+        return false;
+    }
+    *this = loaded;
+    return true;
+}
@@ -0,0 +1,436 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include "../headers/depot.h"
+using namespace std;
+
+//default depot: 1000 vehicles on morning shifts sharing 20 chargers behind a 150 kW connection, for a month.
+//The longest shift (4 h) draws 100 Ah, two thirds of a full battery, so a vehicle that leaves charged
+//comes back with charge to spare and strandings only come from vehicles that left without a full charge.
+DepotOptions::DepotOptions(){
+    vehicles = 1000;
+    chargers = 20;
+    gridPowerCap = 150000;
+    days = 30;
+    handlingSeconds = 300;
+    shiftStart = 7;
+    shiftStartSpread = 1;
+    shiftHours = 3;
+    shiftHoursSpread = 1;
+    averageSpeed = 2.5;
+    seed = 1;
+}
+
+EventQueue::EventQueue(int slots){
+    heap.reserve(slots);
+    position.assign(slots, -1);
+    times.assign(slots, 0);
+    types.assign(slots, DEPOT_ARRIVAL);
+}
+
+bool EventQueue::earlier(int a, int b) const{
+    return times[a] < times[b] || (times[a] == times[b] && a < b);
+}
+
+void EventQueue::swapEntries(int a, int b){
+    swap(heap[a], heap[b]);
+    position[heap[a]] = a;
+    position[heap[b]] = b;
+}
+
+void EventQueue::siftUp(int index){
+    while (index > 0){
+        int parent = (index - 1) / 2;
+        if (!earlier(heap[index], heap[parent])){
+            break;
+        }
+        swapEntries(index, parent);
+        index = parent;
+    }
+}
+
+void EventQueue::siftDown(int index){
+    int count = static_cast<int>(heap.size());
+    while (true){
+        int first = index;
+        int left = 2 * index + 1;
+        int right = left + 1;
+        if (left < count && earlier(heap[left], heap[first])){
+            first = left;
+        }
+        if (right < count && earlier(heap[right], heap[first])){
+            first = right;
+        }
+        if (first == index){
+            break;
+        }
+        swapEntries(index, first);
+        index = first;
+    }
+}
+
+void EventQueue::schedule(int slot, double time, DepotEventType type){
+    types[slot] = type;
+    if (position[slot] < 0){
+        times[slot] = time;
+        position[slot] = static_cast<int>(heap.size());
+        heap.push_back(slot);
+        siftUp(position[slot]);
+        return;
+    }
+    //Already pending: move it to its new place
+    bool sooner = time < times[slot];
+    times[slot] = time;
+    if (sooner){
+        siftUp(position[slot]);
+    } else{
+        siftDown(position[slot]);
+    }
+}
+
+void EventQueue::cancel(int slot){
+    int index = position[slot];
+    if (index < 0){
+        return;
+    }
+    int last = static_cast<int>(heap.size()) - 1;
+    swapEntries(index, last);
+    heap.pop_back();
+    position[slot] = -1;
+    if (index < last){
+        siftDown(index);
+        siftUp(index);
+    }
+}
+
+bool EventQueue::empty() const{
+    return heap.empty();
+}
+
+bool EventQueue::pending(int slot) const{
+    return position[slot] >= 0;
+}
+
+int EventQueue::pop(double &time, DepotEventType &type){
+    int slot = heap[0];
+    time = times[slot];
+    type = types[slot];
+    cancel(slot);
+    return slot;
+}
+
+//Where a vehicle is in its day
+enum DepotVehicleState{
+    VEHICLE_DRIVING,
+    VEHICLE_WAITING_CHARGER, //In the queue for a free charger
+    VEHICLE_HANDLING, //At a charger, being plugged in
+    VEHICLE_WAITING_POWER, //Plugged in, waiting until the grid connection has power to spare
+    VEHICLE_CHARGING,
+    VEHICLE_DONE //Charged (or no charge needed), parked until departure
+};
+
+//Small deterministic generator for the vehicle schedules (64-bit LCG, top 53 bits as a double in [0, 1))
+struct DepotRandom{
+    unsigned long long state;
+
+    double uniform(){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 11) * (1.0 / 9007199254740992.0);
+    }
+    //@brief uniform in [mean - spread, mean + spread]
+    double around(double mean, double spread){
+        return mean + spread * (2 * uniform() - 1);
+    }
+};
+
+//The whole depot while a run is in progress
+struct Depot{
+    const DepotOptions &options;
+    DepotResults &results;
+    EventQueue events;
+    DepotRandom random;
+
+    vector<Battery> batteries;
+    vector<DepotVehicleState> state;
+    vector<int> chargerOf; //Charging point in use by each vehicle, -1 for none
+    vector<double> arrivalTime;
+    vector<double> chargeStart;
+    vector<int> visit; //Number of the vehicle's current stay, to skip queue entries left by an earlier stay
+    vector<bool> queuedThisStay;
+
+    vector<Charger> chargers;
+    vector<double> occupiedSince;
+    vector<int> freeChargers;
+
+    //FIFO queues as vectors with a read index; entries are (vehicle, visit)
+    vector<pair<int, int>> chargerQueue;
+    size_t chargerQueueHead;
+    vector<pair<int, int>> powerQueue;
+    size_t powerQueueHead;
+    int waiting; //Vehicles in either queue
+    int powerSlots; //Sessions the grid connection can supply at once
+    int activeSessions;
+    long long departures;
+
+    Depot(const DepotOptions &options, DepotResults &results) : options(options), results(results), events(2 * options.vehicles){
+        random.state = options.seed;
+        batteries.resize(options.vehicles);
+        state.assign(options.vehicles, VEHICLE_DONE);
+        chargerOf.assign(options.vehicles, -1);
+        arrivalTime.assign(options.vehicles, 0);
+        chargeStart.assign(options.vehicles, 0);
+        visit.assign(options.vehicles, 0);
+        queuedThisStay.assign(options.vehicles, false);
+        chargers.resize(options.chargers);
+        occupiedSince.assign(options.chargers, 0);
+        for (int c = options.chargers - 1; c >= 0; c--){
+            freeChargers.push_back(c);
+        }
+        chargerQueueHead = 0;
+        powerQueueHead = 0;
+        waiting = 0;
+        activeSessions = 0;
+        departures = 0;
+        powerSlots = static_cast<int>(options.gridPowerCap / chargers[0].get_maxPowerOutput());
+    }
+
+    static int stageSlot(int vehicle){ return 2 * vehicle; }
+    static int departureSlot(int vehicle){ return 2 * vehicle + 1; }
+
+    //@brief time of a vehicle's departure on a day
+    double departureOn(int day){
+        return day * 86400.0 + random.around(options.shiftStart, options.shiftStartSpread) * 3600;
+    }
+
+    void handle(int slot, double now, DepotEventType type){
+        int vehicle = slot / 2;
+        switch (type){
+            case DEPOT_ARRIVAL: arrive(vehicle, now); break;
+            case DEPOT_PLUG_IN: plugIn(vehicle, now); break;
+            case DEPOT_CHARGE_COMPLETE: completeCharge(vehicle, now); break;
+            case DEPOT_DEPARTURE: depart(vehicle, now); break;
+        }
+    }
+
+    void arrive(int vehicle, double now){
+        state[vehicle] = VEHICLE_WAITING_CHARGER;
+        arrivalTime[vehicle] = now;
+        visit[vehicle]++;
+        queuedThisStay[vehicle] = false;
+        //The next shift starts on the next day
+        int day = static_cast<int>(now / 86400) + 1;
+        if (day < options.days){
+            events.schedule(departureSlot(vehicle), departureOn(day), DEPOT_DEPARTURE);
+        }
+        if (freeChargers.empty()){
+            results.queued++;
+            queuedThisStay[vehicle] = true;
+            chargerQueue.push_back({vehicle, visit[vehicle]});
+            waiting++;
+            if (waiting > results.maxQueueLength){
+                results.maxQueueLength = waiting;
+            }
+            return;
+        }
+        takeCharger(vehicle, now);
+    }
+
+    void takeCharger(int vehicle, double now){
+        int c = freeChargers.back();
+        freeChargers.pop_back();
+        chargerOf[vehicle] = c;
+        occupiedSince[c] = now;
+        state[vehicle] = VEHICLE_HANDLING;
+        events.schedule(stageSlot(vehicle), now + options.handlingSeconds, DEPOT_PLUG_IN);
+    }
+
+    void plugIn(int vehicle, double now){
+        if (activeSessions >= powerSlots){
+            if (!queuedThisStay[vehicle]){
+                results.queued++;
+                queuedThisStay[vehicle] = true;
+            }
+            state[vehicle] = VEHICLE_WAITING_POWER;
+            powerQueue.push_back({vehicle, visit[vehicle]});
+            waiting++;
+            if (waiting > results.maxQueueLength){
+                results.maxQueueLength = waiting;
+            }
+            return;
+        }
+        startSession(vehicle, now);
+    }
+
+    void startSession(int vehicle, double now){
+        Battery &battery = batteries[vehicle];
+        Charger &charger = chargers[chargerOf[vehicle]];
+        double wait = now - arrivalTime[vehicle] - options.handlingSeconds;
+        results.totalWaitSeconds += wait;
+        if (wait > results.maxWaitSeconds){
+            results.maxWaitSeconds = wait;
+        }
+        activeSessions++;
+        results.sessions++;
+        state[vehicle] = VEHICLE_CHARGING;
+        chargeStart[vehicle] = now;
+        //Charger::startCharging adds chargeRate(chargingVoltage) Ah per second until the battery is full
+        double missing = battery.get_Q_max() - battery.get_Q_current();
+        double rate = battery.chargeRate(charger.chargingVoltage(battery));
+        events.schedule(stageSlot(vehicle), now + (missing > 0 ? missing / rate : 0), DEPOT_CHARGE_COMPLETE);
+    }
+
+    //@brief apply the session so far to the battery and free the power and the charger
+    void endSession(int vehicle, double now){
+        Battery &battery = batteries[vehicle];
+        Charger &charger = chargers[chargerOf[vehicle]];
+        float before = battery.get_Q_current();
+        charger.startCharging(battery, static_cast<float>(now - chargeStart[vehicle]));
+        charger.stopCharging();
+        battery.setCurrent(0);
+        results.chargedAh += battery.get_Q_current() - before;
+        activeSessions--;
+        releaseCharger(vehicle, now);
+
+        //Power for the next plugged-in vehicle
+        while (activeSessions < powerSlots && powerQueueHead < powerQueue.size()){
+            pair<int, int> next = powerQueue[powerQueueHead++];
+            if (visit[next.first] == next.second && state[next.first] == VEHICLE_WAITING_POWER){
+                waiting--;
+                startSession(next.first, now);
+            }
+        }
+    }
+
+    void releaseCharger(int vehicle, double now){
+        int c = chargerOf[vehicle];
+        results.chargerBusySeconds += now - occupiedSince[c];
+        chargerOf[vehicle] = -1;
+        freeChargers.push_back(c);
+        while (!freeChargers.empty() && chargerQueueHead < chargerQueue.size()){
+            pair<int, int> next = chargerQueue[chargerQueueHead++];
+            if (visit[next.first] == next.second && state[next.first] == VEHICLE_WAITING_CHARGER){
+                waiting--;
+                takeCharger(next.first, now);
+            }
+        }
+    }
+
+    void completeCharge(int vehicle, double now){
+        endSession(vehicle, now);
+        state[vehicle] = VEHICLE_DONE;
+    }
+
+    void depart(int vehicle, double now){
+        Battery &battery = batteries[vehicle];
+        switch (state[vehicle]){
+            case VEHICLE_CHARGING:
+                events.cancel(stageSlot(vehicle));
+                endSession(vehicle, now);
+                results.departedShort++;
+                break;
+            case VEHICLE_HANDLING:
+                events.cancel(stageSlot(vehicle));
+                releaseCharger(vehicle, now);
+                results.departedShort++;
+                break;
+            case VEHICLE_WAITING_POWER:
+                releaseCharger(vehicle, now);
+                waiting--;
+                results.departedShort++;
+                break;
+            case VEHICLE_WAITING_CHARGER:
+                waiting--;
+                results.departedShort++;
+                break;
+            default:
+                break;
+        }
+        float SOC = battery.get_SOC();
+        results.averageDepartureSOC += SOC;
+        if (departures == 0 || SOC < results.minDepartureSOC){
+            results.minDepartureSOC = SOC;
+        }
+        departures++;
+
+        //The shift, driven at the average speed in one Battery::discharge call (the discharge is linear in time).
+        //discharge() stops at an empty battery, so a shift that needs more than is left is counted here.
+        state[vehicle] = VEHICLE_DRIVING;
+        double shift = random.around(options.shiftHours, options.shiftHoursSpread) * 3600;
+        double needed = battery.dischargeRate(options.averageSpeed, battery.get_temp()) * shift;
+        if (needed > battery.get_Q_current()){
+            results.stranded++;
+            results.strandedAh += needed - battery.get_Q_current();
+        }
+        battery.discharge(options.averageSpeed, static_cast<float>(shift));
+        battery.setCurrent(0);
+        events.schedule(stageSlot(vehicle), now + shift, DEPOT_ARRIVAL);
+    }
+};
+
+bool simulateDepot(const DepotOptions &options, DepotResults &results){
+    results = DepotResults{0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0};
+    if (options.vehicles <= 0 || options.chargers <= 0 || options.days <= 0){
+        cout << "The depot needs vehicles, chargers and at least one day\n";
+        return false;
+    }
+    Depot depot(options, results);
+    if (depot.powerSlots < 1){
+        cout << "The grid power cap is below the power of one charger (" << depot.chargers[0].get_maxPowerOutput() << " W)\n";
+        return false;
+    }
+
+    //Everyone starts the month charged and parked, leaving for the first shift
+    for (int v = 0; v < options.vehicles; v++){
+        depot.events.schedule(Depot::departureSlot(v), depot.departureOn(0), DEPOT_DEPARTURE);
+    }
+
+    const double end = options.days * 86400.0;
+    double now = 0;
+    while (!depot.events.empty()){
+        DepotEventType type;
+        int slot = depot.events.pop(now, type);
+        if (now > end){
+            now = end;
+            break;
+        }
+        depot.handle(slot, now, type);
+        results.events++;
+    }
+    results.simulatedSeconds = end;
+    if (depot.departures > 0){
+        results.averageDepartureSOC /= depot.departures;
+    }
+    return true;
+}
+
+int runDepot(const DepotOptions &options){
+    DepotResults results;
+    auto start = chrono::steady_clock::now();
+    if (!simulateDepot(options, results)){
+        return 1;
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Depot: " << options.vehicles << " vehicles, " << options.chargers << " chargers, "
+         << options.gridPowerCap / 1000 << " kW grid cap, " << options.days << " days\n";
+    cout << "Charging sessions: " << results.sessions << " (" << results.chargedAh << " Ah delivered)\n";
+    cout << "Queued arrivals: " << results.queued << ", longest queue " << results.maxQueueLength << " vehicles\n";
+    if (results.sessions > 0){
+        cout << "Wait for a charger: " << results.totalWaitSeconds / results.sessions / 60 << " min on average, "
+             << results.maxWaitSeconds / 60 << " min at most\n";
+    }
+    cout << "Charger utilization: " << results.chargerBusySeconds / (options.chargers * results.simulatedSeconds) * 100 << "%\n";
+    cout << "Departures not fully charged: " << results.departedShort << ", average SOC at departure "
+         << results.averageDepartureSOC << "%, lowest " << results.minDepartureSOC << "%\n";
+    cout << "Stranded shifts (ran empty on the road): " << results.stranded;
+    if (results.stranded > 0){
+        cout << ", " << results.strandedAh << " Ah short in total";
+    }
+    cout << "\n";
+    cout << results.events << " events in " << seconds * 1000 << " ms";
+    if (seconds > 0){
+        cout << " (" << results.events / seconds << " events per second)";
+    }
+    cout << "\n";
+    return 0;
+}
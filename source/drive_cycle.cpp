@@ -0,0 +1,207 @@
+#include <iostream>
+#include <charconv>
+#include <cstring>
+#include <cmath>
+#include "../headers/drive_cycle.h"
+#include "../headers/log_analytics.h"
+using namespace std;
+
+//ECE-15 elementary urban cycle (the urban part of NEDC), as (time s, speed km/h) corner points.
+//Speeds between the points change linearly. It is 195 s long, 1.013 km, and is the built-in cycle "ece15".
+const float ECE15_POINTS[][2] = {
+    {0, 0}, {11, 0}, {15, 15}, {23, 15}, {25, 10}, {28, 0},
+    {49, 0}, {54, 15}, {56, 15}, {61, 32}, {85, 32}, {96, 0},
+    {117, 0}, {122, 15}, {124, 15}, {133, 35}, {135, 35}, {143, 50}, {155, 50}, {163, 35},
+    {176, 35}, {188, 10}, {191, 0}, {195, 0}
+};
+
+DriveCycle::DriveCycle(){
+    speedTrace = false;
+    cursor = 0;
+}
+
+//@brief load a trace from a CSV file with a Time column and either Throttle and Brake or Speed columns
+//@return false if the file cannot be read or has no usable columns
+bool DriveCycle::loadCsv(const string &path){
+    MappedFile file;
+    if (!file.open(path) || file.size() == 0){
+        cout << "Cannot open drive cycle " << path << "\n";
+        return false;
+    }
+    const char* data = file.data();
+    const char* end = data + file.size();
+
+    //Find the columns in the header
+    const char* headerEnd = static_cast<const char*>(memchr(data, '\n', end - data));
+    if (headerEnd == nullptr){
+        headerEnd = end;
+    }
+    int timeColumn = -1, throttleColumn = -1, brakeColumn = -1, speedColumn = -1, columns = 0;
+    const char* field = data;
+    while (field <= headerEnd){
+        const char* comma = static_cast<const char*>(memchr(field, ',', headerEnd - field));
+        const char* fieldEnd = comma ? comma : headerEnd;
+        string column(field, fieldEnd);
+        if (!column.empty() && column.back() == '\r'){
+            column.pop_back();
+        }
+        if (column == "Time") timeColumn = columns;
+        else if (column == "Throttle") throttleColumn = columns;
+        else if (column == "Brake") brakeColumn = columns;
+        else if (column == "Speed") speedColumn = columns;
+        columns++;
+        if (!comma){
+            break;
+        }
+        field = comma + 1;
+    }
+    if (timeColumn < 0 || ((throttleColumn < 0 || brakeColumn < 0) && speedColumn < 0)){
+        cout << "Drive cycle " << path << " needs Time and Throttle,Brake or Speed columns\n";
+        return false;
+    }
+
+    //Prefer the pedals when a file has both (like output.csv)
+    speedTrace = throttleColumn < 0 || brakeColumn < 0;
+    times.clear();
+    throttle.clear();
+    brake.clear();
+    speed.clear();
+    vector<float> values(columns);
+    const char* line = headerEnd + 1;
+    while (line < end){
+        const char* newline = static_cast<const char*>(memchr(line, '\n', end - line));
+        const char* lineEnd = newline ? newline : end;
+        const char* f = line;
+        int index = 0;
+        bool ok = true;
+        while (index < columns && f <= lineEnd){
+            const char* comma = static_cast<const char*>(memchr(f, ',', lineEnd - f));
+            const char* fEnd = comma ? comma : lineEnd;
+            if (from_chars(f, fEnd, values[index]).ec != errc()){
+                ok = false;
+                break;
+            }
+            index++;
+            f = fEnd + 1;
+        }
+        //Skip unreadable rows and rows that go back in time
+        if (ok && index == columns && (times.empty() || values[timeColumn] > times.back())){
+            times.push_back(values[timeColumn]);
+            if (speedTrace){
+                speed.push_back(values[speedColumn]);
+            } else{
+                throttle.push_back(values[throttleColumn]);
+                brake.push_back(values[brakeColumn]);
+            }
+        }
+        line = lineEnd + 1;
+    }
+    if (times.empty()){
+        cout << "Drive cycle " << path << " has no rows\n";
+        return false;
+    }
+    name = path;
+    cursor = 0;
+    return true;
+}
+
+//@brief load one of the cycles built into the program ("ece15")
+bool DriveCycle::loadBuiltin(const string &cycleName){
+    if (cycleName != "ece15"){
+        return false;
+    }
+    name = cycleName;
+    speedTrace = true;
+    times.clear();
+    speed.clear();
+    throttle.clear();
+    brake.clear();
+    for (const float* point : ECE15_POINTS){
+        times.push_back(point[0]);
+        speed.push_back(point[1] / 3.6f); //km/h to m/s
+    }
+    cursor = 0;
+    return true;
+}
+
+bool DriveCycle::load(const string &pathOrName){
+    if (loadBuiltin(pathOrName)){
+        return true;
+    }
+    return loadCsv(pathOrName);
+}
+
+string DriveCycle::get_name(){
+    return name;
+}
+
+bool DriveCycle::isSpeedTrace(){
+    return speedTrace;
+}
+
+//@return length of one pass through the cycle in seconds
+double DriveCycle::duration(){
+    return times.empty() ? 0 : times.back();
+}
+
+size_t DriveCycle::samples(){
+    return times.size();
+}
+
+//@brief linear interpolation of a column at a time (wrapped into the cycle)
+float DriveCycle::interpolate(const vector<float> &values, double time){
+    double period = duration();
+    if (period > 0){
+        time = fmod(time, period);
+    }
+    if (time <= times.front()){
+        return values.front();
+    }
+    if (time >= times.back()){
+        return values.back();
+    }
+    //Move the cursor to the segment containing time. Replays go forward, so this is usually 0 or 1 steps;
+    //after wrapping around (or a jump back) it starts again from the beginning.
+    if (cursor + 1 >= times.size() || times[cursor] > time){
+        cursor = 0;
+    }
+    while (times[cursor + 1] < time){
+        cursor++;
+    }
+    double t0 = times[cursor], t1 = times[cursor + 1];
+    double fraction = (time - t0) / (t1 - t0);
+    return static_cast<float>(values[cursor] + (values[cursor + 1] - values[cursor]) * fraction);
+}
+
+float DriveCycle::targetSpeed(double time){
+    return speedTrace ? interpolate(speed, time) : 0;
+}
+
+void DriveCycle::apply(double time, float vehicleSpeed, DriverInput &input){
+    if (times.empty()){
+        return;
+    }
+    if (!speedTrace){
+        input.set_throttle(interpolate(throttle, time));
+        input.set_brake(interpolate(brake, time));
+        return;
+    }
+
+    //Proportional driver: press the throttle when slower than the target and the brake when faster.
+    //Inside a small deadband the throttle is held lightly, because releasing both pedals applies
+    //the strong passive drag of Motor::updateSpeed.
+    float target = interpolate(speed, time);
+    float error = target - vehicleSpeed;
+    const float gain = 0.5; //pedal position per m/s of error
+    const float deadband = 0.2; //m/s
+    if (target <= 0 && vehicleSpeed <= deadband){
+        input.set_throttle(0.0); //Stopped: hold the brake
+        input.set_brake(1.0);
+    } else if (error > -deadband){
+        input.set_throttle(error > 0 ? gain * error : 0.01);
+        input.set_brake(0.0);
+    } else{
+        input.set_throttle(0.0);
+        input.set_brake(-gain * error);
+    }
+}
@@ -1,4 +1,5 @@
 #include "../headers/driver_input.h"
+#include "../headers/snapshot.h"
 
 //Constructor (Initialize throttle and brake positions to zero (no input))
 DriverInput::DriverInput() {
@@ -36,3 +37,24 @@ void DriverInput::set_brake(float intensity) {
         brakePosition = intensity;
     }
 }
+
+//@brief write every field to a snapshot section
+void DriverInput::saveState(StateWriter &out){
+    out.beginSection("DRVR");
+    out.putFloat(throttlePosition);
+    out.putFloat(brakePosition);
+    out.endSection();
+}
+
+//@brief read the fields back from a snapshot section
+//@return false if the section is too short (the object is then left unchanged)
+bool DriverInput::loadState(StateReader in){
+    DriverInput loaded(*this);
+    loaded.throttlePosition = in.getFloat();
+    loaded.brakePosition = in.getFloat();
+    if (!in.is_ok()){
+        return false;
+    }
+    *this = loaded;
+    return true;
+}
@@ -0,0 +1,541 @@
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <cmath>
+#include "../headers/fleet.h"
+#include "../headers/thread_pool.h"
+#include "../headers/battery_kernels.h"
+#include "../headers/simulation.h"
+using namespace std;
+
+//default constructor (empty fleet with the default components)
+Fleet::Fleet(){
+    Motor motor;
+    Battery battery;
+    EV defaultBody;
+    configure(motor, battery, defaultBody);
+    rcResistance = 0.015;
+    rcCapacitance = 2000; //30 s time constant with rcResistance
+    fidelity = Fidelity::Standard;
+}
+
+//@brief copy the constants every vehicle shares from the components of a vehicle
+//@param motor - braking torque, inertia, regen and losses, battery - heat transfer, body - road load of the Detailed level
+void Fleet::configure(Motor &motor, Battery &battery, EV &body){
+    maxBrakeTorque = motor.get_maxBrakeTorque();
+    inertia = motor.get_inertia();
+    regenEfficiency = motor.get_regenEfficiency();
+    maxRegenPower = motor.getMaxRegenPower();
+    heatTransferCoeff = battery.get_heatTransferCoeff();
+    cycleFade = battery.get_cycleFade();
+    thermalFade = battery.get_thermalFade();
+    motorResistance = motor.get_R_internal();
+    motorEfficiency = motor.get_efficiency();
+    this->body = body;
+}
+
+const char* fidelityName(Fidelity level){
+    switch (level){
+        case Fidelity::Reduced: return "reduced";
+        case Fidelity::Standard: return "standard";
+        case Fidelity::Detailed: return "detailed";
+    }
+    return "";
+}
+
+bool parseFidelity(const string &name, Fidelity &level){
+    for (Fidelity candidate : {Fidelity::Reduced, Fidelity::Standard, Fidelity::Detailed}){
+        if (name == fidelityName(candidate)){
+            level = candidate;
+            return true;
+        }
+    }
+    cout << "Unknown fidelity " << name << " (use reduced, standard or detailed)\n";
+    return false;
+}
+
+//@brief add one vehicle to the fleet. Passing -1 for a parameter uses the default value.
+//@return index of the new vehicle
+int Fleet::addVehicle(float Q_max, float V_max, float R_internal, float heatCapacity,
+                      float maxTorque, float maxSpeed, float wheelRadius){
+    this->Q_max.push_back(Q_max <= -1 ? 150 : Q_max);
+    this->Q_now.push_back(Q_max <= -1 ? 150 : Q_max); //Starting fully charged
+    this->V_max.push_back(V_max <= -1 ? 420 : V_max);
+    this->R_internal.push_back(R_internal <= -1 ? 0.02 : R_internal);
+    this->heatCapacity.push_back(heatCapacity <= -1 ? 1000 : heatCapacity);
+    temperature.push_back(25);
+    stateOfHealth.push_back(1);
+    cycleCharge.push_back(0);
+    startCharge.push_back(0);
+    current.push_back(0);
+    rcVoltage.push_back(0);
+
+    this->maxTorque.push_back(maxTorque == -1 ? 200 : maxTorque);
+    this->maxSpeed.push_back(maxSpeed == -1 ? 100 : maxSpeed);
+    this->wheelRadius.push_back(wheelRadius == -1 ? 0.5 : wheelRadius);
+    angularSpeed.push_back(0);
+    speed.push_back(0);
+
+    throttle.push_back(0);
+    brake.push_back(0);
+    charging.push_back(0);
+
+    return size() - 1;
+}
+
+//@brief add one vehicle that continues from the state of the given components
+//@return index of the new vehicle
+int Fleet::addVehicle(Battery &battery, Motor &motor, EV &body){
+    int i = addVehicle(battery.get_Q_max(), battery.get_V_max(), battery.get_R_internal(), battery.get_heatCapacity(),
+                       motor.get_maxTorque(), motor.get_maxSpeed(), body.get_wheelRadius());
+    Q_now[i] = battery.get_Q_current();
+    temperature[i] = battery.get_temp();
+    stateOfHealth[i] = battery.get_SOH();
+    current[i] = battery.get_current();
+    angularSpeed[i] = motor.get_angularSpeed();
+    float v = wheelRadius[i] * angularSpeed[i];
+    speed[i] = v > maxSpeed[i] ? maxSpeed[i] : v;
+    return i;
+}
+
+int Fleet::size() const{
+    return static_cast<int>(Q_now.size());
+}
+
+//@brief reserve space for a number of vehicles so adding them does not reallocate every array
+void Fleet::reserve(int count){
+    Q_max.reserve(count); Q_now.reserve(count); V_max.reserve(count); R_internal.reserve(count);
+    heatCapacity.reserve(count); temperature.reserve(count); stateOfHealth.reserve(count); cycleCharge.reserve(count);
+    startCharge.reserve(count); current.reserve(count);
+    rcVoltage.reserve(count);
+    maxTorque.reserve(count); maxSpeed.reserve(count); wheelRadius.reserve(count);
+    angularSpeed.reserve(count); speed.reserve(count);
+    throttle.reserve(count); brake.reserve(count); charging.reserve(count);
+}
+
+//@brief set the driver input of one vehicle, with the same clamping as DriverInput
+void Fleet::setInput(int i, float throttle, float brake){
+    this->throttle[i] = throttle > 1 ? 1 : (throttle < 0 ? 0 : throttle);
+    this->brake[i] = brake > 1 ? 1 : (brake < 0 ? 0 : brake);
+}
+
+//@brief advance every vehicle by one time step
+void Fleet::step(float delta_t, float ambientTemp){
+    stepRange(0, size(), delta_t, ambientTemp);
+}
+
+//@brief advance vehicles [begin, end) by one time step. Each vehicle only touches its own entries,
+//so disjoint ranges can be stepped independently.
+void Fleet::stepRange(int begin, int end, float delta_t, float ambientTemp){
+    switch (fidelity){
+        case Fidelity::Reduced: stepLevel<Fidelity::Reduced>(begin, end, delta_t, ambientTemp); break;
+        case Fidelity::Standard: stepLevel<Fidelity::Standard>(begin, end, delta_t, ambientTemp); break;
+        case Fidelity::Detailed: stepLevel<Fidelity::Detailed>(begin, end, delta_t, ambientTemp); break;
+    }
+}
+
+//@brief the step loop of one fidelity level (the level's extra or skipped terms are decided at compile time).
+//Standard runs charging, regen and the motor per vehicle, then the battery discharge and temperature for the
+//whole range with the batch kernels (AVX2/NEON where the processor has them).
+template <Fidelity level>
+void Fleet::stepLevel(int begin, int end, float delta_t, float ambientTemp){
+    for (int i = begin; i < end; i++){
+        float Q = Q_now[i];
+        startCharge[i] = Q;
+        float I = current[i];
+        float v = speed[i];
+        float w = angularSpeed[i];
+        float T = temperature[i];
+        float thr = throttle[i];
+        float brk = brake[i];
+
+        //Charger::startCharging -> Battery::charge
+        float chargeCurrent = 0; //Detailed: current into the battery from the charger (A)
+        if (charging[i]){
+            float chargingVoltage = 0.2 * V_max[i];
+            float deltaQ = delta_t * chargingVoltage / (1000 * R_internal[i]);
+            if (Q < Q_max[i]){
+                Q += deltaQ;
+                if (Q >= Q_max[i]){
+                    Q = Q_max[i];
+                }
+                chargeCurrent = deltaQ * 3600 / delta_t;
+            } else{
+                I = 0;
+            }
+        }
+
+        //Motor::applyRegenerativeBraking
+        float regenCurrent = 0;
+        if (level != Fidelity::Reduced && v > 0 && brk > 0){
+            float power = brk * regenEfficiency * maxTorque[i] * v;
+            if (power > maxRegenPower){
+                power = maxRegenPower;
+            }
+            if (power > 0){
+                regenCurrent = power / V_max[i];
+                Q += regenCurrent * delta_t;
+                if (Q > Q_max[i]){
+                    Q = Q_max[i];
+                }
+                I = regenCurrent;
+            }
+        }
+
+        //Motor::updateSpeed
+        float netTorque = 0;
+        if (thr > 0){
+            netTorque += thr * maxTorque[i];
+        }
+        if (brk > 0){
+            netTorque -= brk * maxBrakeTorque;
+        }
+        if (thr == 0 && brk == 0){
+            float dragTorque = 0.8 * maxTorque[i];
+            netTorque -= dragTorque;
+        }
+        if constexpr (level == Fidelity::Detailed){
+            //Aerodynamic drag and rolling resistance on a flat road, as a torque on the wheels
+            netTorque -= body.roadLoadForce(v, 0) * wheelRadius[i];
+        }
+        w += netTorque / inertia * delta_t;
+        if (w < 0.0){
+            w = 0.0;
+        }
+        v = wheelRadius[i] * w;
+        if (v > maxSpeed[i]){
+            v = maxSpeed[i];
+        }
+
+        if constexpr (level == Fidelity::Detailed){
+            //Electrical power for the motor's mechanical power, with its efficiency and winding losses, drawn
+            //from an RC equivalent circuit: terminal voltage = OCV(SOC) - I * R_internal - voltage over the RC pair
+            //The power is priced at the wheel speed after the top speed cap: w keeps growing under throttle at the
+            //cap (as in Motor::updateSpeed), and would otherwise draw without bound
+            float mechanicalPower = thr * maxTorque[i] * (v / wheelRadius[i]);
+            float ocv = V_max[i] * (0.8f + 0.2f * Q / Q_max[i]);
+            float terminal = ocv + I * R_internal[i] - rcVoltage[i]; //I of the last step, negative while discharging
+            float motorCurrent = mechanicalPower / (motorEfficiency * terminal);
+            float electricalPower = mechanicalPower / motorEfficiency + motorCurrent * motorCurrent * motorResistance;
+            float drawn = electricalPower / terminal;
+            Q -= drawn * delta_t / 3600;
+            I = regenCurrent + chargeCurrent - drawn;
+            if (Q < 0){
+                I = 0;
+                Q = 0;
+            }
+            rcVoltage[i] += delta_t * (-I / rcCapacitance - rcVoltage[i] / (rcResistance * rcCapacitance));
+
+            float heatGenerated = 0.00001 * (I * I * R_internal[i] + rcVoltage[i] * rcVoltage[i] / rcResistance) * delta_t;
+            float cooling = heatTransferCoeff * (T - ambientTemp) * delta_t;
+            T += (heatGenerated - cooling) / heatCapacity[i];
+        }
+
+        Q_now[i] = Q;
+        current[i] = I;
+        speed[i] = v;
+        angularSpeed[i] = w;
+        temperature[i] = T;
+    }
+
+    if constexpr (level == Fidelity::Reduced){
+        //Battery::discharge without the temperature tiers (the temperature is held)
+        dischargeFlatBatch(Q_now.data() + begin, current.data() + begin, speed.data() + begin, end - begin, delta_t);
+    } else if constexpr (level == Fidelity::Standard){
+        //Battery::discharge and Battery::updateTemperature
+        int count = end - begin;
+        dischargeBatch(Q_now.data() + begin, current.data() + begin, speed.data() + begin, temperature.data() + begin, count, delta_t);
+        updateTemperatureBatch(temperature.data() + begin, current.data() + begin, R_internal.data() + begin, heatCapacity.data() + begin,
+                               heatTransferCoeff, count, delta_t, ambientTemp);
+    }
+    wear(begin, end, delta_t);
+}
+
+//@brief Battery::wear of vehicles [begin, end) after a step: degradeSOH with the temperature after the step,
+//then degradeWithCycle for the charge drawn over the step
+void Fleet::wear(int begin, int end, float delta_t){
+    degradeSOHBatch(stateOfHealth.data() + begin, temperature.data() + begin, end - begin, delta_t, thermalFade);
+    for (int i = begin; i < end; i++){
+        float drawn = startCharge[i] - Q_now[i];
+        if (drawn > 0){
+            cycleCharge[i] += drawn;
+            if (cycleCharge[i] >= Q_max[i]){
+                stateOfHealth[i] -= cycleFade;
+                if (stateOfHealth[i] < 0){
+                    stateOfHealth[i] = 0;
+                }
+                cycleCharge[i] = 0;
+            }
+        }
+    }
+}
+
+//@brief advance every vehicle by one time step using a thread pool. The fleet is cut into chunks of
+//chunkSize vehicles that the pool's threads share out; the call returns when all chunks are done.
+//Every vehicle is computed the same way whichever thread runs it, so results do not depend on the thread count.
+void Fleet::stepParallel(ThreadPool &pool, float delta_t, float ambientTemp, int chunkSize){
+    int count = size();
+    int chunks = (count + chunkSize - 1) / chunkSize;
+    pool.run(chunks, [&](int chunk){
+        int begin = chunk * chunkSize;
+        int end = begin + chunkSize < count ? begin + chunkSize : count;
+        stepRange(begin, end, delta_t, ambientTemp);
+    });
+}
+
+//@brief set every vehicle's input from the scripted 30 s pattern (accelerate 10 s, coast 10 s, brake 5 s,
+//wait 5 s). Vehicle i starts (i % 30) seconds into the pattern so the fleet is not all in the same phase.
+void Fleet::applyScriptedInputs(float time){
+    for (int i = 0; i < size(); i++){
+        float t = time + (i % 30);
+        float phase = t - 30 * static_cast<int>(t / 30);
+        if (phase < 10){
+            setInput(i, 1, 0);
+        } else if (phase < 20 || phase >= 25){
+            setInput(i, 0, 0);
+        } else{
+            setInput(i, 0, 1);
+        }
+    }
+}
+
+//@brief state of charge of one vehicle in percent
+float Fleet::get_SOC(int i) const{
+    return (Q_now[i] / Q_max[i]) * 100.0;
+}
+
+//@brief configure a fleet as the benchmarks' vehicle and add default vehicles to it: the default motor and
+//battery, with the motor losses and the body of a mid-size car that only the Detailed level uses
+void addBenchmarkVehicles(Fleet &fleet, int vehicles){
+    Motor motor;
+    motor.set_R_internal(0.05);
+    motor.set_efficiency(0.9);
+    Battery battery;
+    EV car;
+    car.setMass(1500);
+    car.setDragCoefficient(0.3);
+    car.setFrontalArea(2.2);
+    fleet.configure(motor, battery, car);
+    fleet.reserve(vehicles);
+    for (int i = 0; i < vehicles; i++){
+        fleet.addVehicle(-1, -1, -1, -1, -1, -1, -1);
+    }
+}
+
+//@brief step a fleet of vehicles driving the scripted 30 s pattern (each vehicle starts at a different
+//point of the pattern) and report the throughput
+//@param vehicles - fleet size, steps - number of time steps, delta_t - fixed time step, level - model fidelity
+//@return 0
+int runFleetBenchmark(int vehicles, int steps, float delta_t, Fidelity level){
+    Fleet fleet;
+    fleet.fidelity = level;
+    addBenchmarkVehicles(fleet, vehicles);
+
+    double stepSeconds = 0;
+    for (int s = 0; s < steps; s++){
+        //Inputs are set outside the timed part, like a driver changing pedals between frames
+        fleet.applyScriptedInputs(s * delta_t);
+        auto start = chrono::steady_clock::now();
+        fleet.step(delta_t, 25);
+        auto end = chrono::steady_clock::now();
+        stepSeconds += chrono::duration<double>(end - start).count();
+    }
+
+    double vehicleSteps = static_cast<double>(vehicles) * steps;
+    float averageSOC = 0;
+    for (int i = 0; i < vehicles; i++){
+        averageSOC += fleet.get_SOC(i);
+    }
+    averageSOC /= vehicles;
+
+    cout << "Fleet run: " << vehicles << " vehicles x " << steps << " steps of " << delta_t << " s, "
+         << fidelityName(level) << " fidelity\n";
+    cout << "Stepping took " << stepSeconds << " s (" << stepSeconds / steps * 1e6 << " us per step)\n";
+    if (stepSeconds > 0){
+        cout << "Throughput: " << vehicleSteps / stepSeconds << " vehicle*steps per second\n";
+    }
+    cout << "Average final SOC: " << averageSOC << "%\n";
+    return 0;
+}
+
+//@brief run the same scripted fleet at every fidelity level and report the cost per vehicle-step and how far
+//each level's final state is from the detailed and the standard one (mean absolute difference over the fleet).
+//Vehicle i's battery starts at -10 + (i % 61) C in a 25 C ambient, so the discharge tiers below 0 and above
+//40 C and the cooling towards the ambient (which the reduced level leaves out) show in the differences.
+//@return 0
+int runFidelityComparison(int vehicles, int steps, float delta_t){
+    const Fidelity levels[3] = {Fidelity::Reduced, Fidelity::Standard, Fidelity::Detailed};
+    Fleet fleets[3];
+    double seconds[3];
+    for (int l = 0; l < 3; l++){
+        Fleet &fleet = fleets[l];
+        fleet.fidelity = levels[l];
+        addBenchmarkVehicles(fleet, vehicles);
+        for (int i = 0; i < vehicles; i++){
+            fleet.temperature[i] = -10 + (i % 61);
+        }
+        seconds[l] = 0;
+        for (int s = 0; s < steps; s++){
+            fleet.applyScriptedInputs(s * delta_t);
+            auto start = chrono::steady_clock::now();
+            fleet.step(delta_t, 25);
+            auto end = chrono::steady_clock::now();
+            seconds[l] += chrono::duration<double>(end - start).count();
+        }
+    }
+
+    double vehicleSteps = static_cast<double>(vehicles) * steps;
+    cout << "Fidelity comparison: " << vehicles << " vehicles x " << steps << " steps of " << delta_t << " s, "
+         << "batteries starting at -10 to 50 C in a 25 C ambient\n";
+    cout << "Differences are mean absolute differences at the end of the run. Reduced and standard share the motor\n"
+         << "model, so only the detailed road load changes the speed.\n";
+    cout << "level  ns/vehicle-step  cost  vs detailed: dSOC(%)  dSpeed(m/s)  dTemp(C)  vs standard: dSOC(%)  dTemp(C)\n";
+    for (int l = 0; l < 3; l++){
+        const Fleet &fleet = fleets[l];
+        double dSOC[2] = {0, 0}, dSpeed = 0, dTemp[2] = {0, 0};
+        for (int r = 0; r < 2; r++){
+            const Fleet &reference = fleets[r == 0 ? 2 : 1];
+            for (int i = 0; i < vehicles; i++){
+                dSOC[r] += fabs(fleet.get_SOC(i) - reference.get_SOC(i));
+                dTemp[r] += fabs(fleet.temperature[i] - reference.temperature[i]);
+                if (r == 0){
+                    dSpeed += fabs(fleet.speed[i] - reference.speed[i]);
+                }
+            }
+        }
+        cout << fidelityName(levels[l]) << "  " << seconds[l] / vehicleSteps * 1e9 << "  " << seconds[l] / seconds[1] << "x  "
+             << dSOC[0] / vehicles << "  " << dSpeed / vehicles << "  " << dTemp[0] / vehicles << "  "
+             << dSOC[1] / vehicles << "  " << dTemp[1] / vehicles << "\n";
+    }
+    return 0;
+}
+
+//@brief checksum of the fleet state, used to check that every thread count gives the same result
+unsigned long long fleetChecksum(const Fleet &fleet){
+    unsigned long long hash = 1469598103934665603ULL; //FNV-1a
+    const vector<float>* fields[5] = {&fleet.Q_now, &fleet.current, &fleet.speed, &fleet.angularSpeed, &fleet.temperature};
+    for (const vector<float>* field : fields){
+        for (float value : *field){
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            hash = (hash ^ bits) * 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+//@brief step the same scripted fleet with 1, 2, ... maxThreads threads, report throughput and speedup,
+//and check that every thread count ends in exactly the same state
+//@return 0 if all runs agree, 1 otherwise
+int runFleetScaling(int vehicles, int steps, float delta_t, int maxThreads){
+    const int chunkSize = 4096;
+    double baseSeconds = 0;
+    unsigned long long baseChecksum = 0;
+    int result = 0;
+
+    cout << "Fleet scaling: " << vehicles << " vehicles x " << steps << " steps, chunks of " << chunkSize << " vehicles\n";
+    cout << "threads  seconds  vehicle*steps/s  speedup  steals  checksum\n";
+    for (int threads = 1; threads <= maxThreads; threads++){
+        Fleet fleet;
+        addBenchmarkVehicles(fleet, vehicles);
+        ThreadPool pool(threads);
+
+        double stepSeconds = 0;
+        for (int s = 0; s < steps; s++){
+            fleet.applyScriptedInputs(s * delta_t);
+            auto start = chrono::steady_clock::now();
+            fleet.stepParallel(pool, delta_t, 25, chunkSize);
+            auto end = chrono::steady_clock::now();
+            stepSeconds += chrono::duration<double>(end - start).count();
+        }
+
+        unsigned long long checksum = fleetChecksum(fleet);
+        if (threads == 1){
+            baseSeconds = stepSeconds;
+            baseChecksum = checksum;
+        }
+        cout << threads << "  " << stepSeconds << "  " << static_cast<double>(vehicles) * steps / stepSeconds
+             << "  " << baseSeconds / stepSeconds << "x  " << pool.get_steals() << "  " << hex << checksum << dec;
+        if (checksum != baseChecksum){
+            cout << "  MISMATCH";
+            result = 1;
+        }
+        cout << "\n";
+    }
+    return result;
+}
+
+//@brief drive a Standard fleet and one Simulation per vehicle with the same inputs for 20 minutes and compare
+//every vehicle after every step. The vehicles run the scripted pattern at different phases, start between
+//40 and 100% SOC and between -10 and 50 C, every third has a 20 Ah battery (so it completes charge cycles and
+//runs empty) and every other one is plugged in while it brakes. The simulations get the same wear as the fleet.
+//@return 0 if every vehicle matches bit for bit, 1 otherwise
+int runFleetCheck(){
+    const int vehicles = 60;
+    const float dt = 0.016;
+    const long long steps = 75000;
+    const float ambientTemp = 25;
+
+    Fleet fleet;
+    vector<Simulation> sims;
+    for (int i = 0; i < vehicles; i++){
+        sims.push_back(Simulation(ambientTemp));
+        Simulation &sim = sims.back();
+        sim.configure(Motor(), Battery(i % 3 == 0 ? 20 : -1, -1, -1, -1), EV());
+        Battery &battery = sim.get_battery();
+        battery.set_Q_current(battery.get_Q_max() * (40 + (i % 7) * 10) / 100);
+        battery.set_temp(-10 + (i % 61));
+        fleet.addVehicle(battery, sim.get_motor(), sim.get_vehicle());
+    }
+
+    const char* fields[5] = {"charge", "current", "speed", "temperature", "SOH"};
+    long long mismatches = 0;
+    double fleetSeconds = 0, simSeconds = 0;
+    for (long long s = 0; s < steps; s++){
+        fleet.applyScriptedInputs(s * dt);
+        for (int i = 0; i < vehicles; i++){
+            fleet.charging[i] = i % 2 == 1 && fleet.brake[i] > 0;
+        }
+        auto start = chrono::steady_clock::now();
+        fleet.step(dt, ambientTemp);
+        auto middle = chrono::steady_clock::now();
+        for (int i = 0; i < vehicles; i++){
+            Simulation &sim = sims[i];
+            sim.get_input().set_throttle(fleet.throttle[i]);
+            sim.get_input().set_brake(fleet.brake[i]);
+            sim.stepWithWear(dt, fleet.charging[i] != 0);
+        }
+        auto end = chrono::steady_clock::now();
+        fleetSeconds += chrono::duration<double>(middle - start).count();
+        simSeconds += chrono::duration<double>(end - middle).count();
+
+        for (int i = 0; i < vehicles; i++){
+            Battery &battery = sims[i].get_battery();
+            const float expected[5] = {battery.get_Q_current(), battery.get_current(), sims[i].get_speed(), battery.get_temp(), battery.get_SOH()};
+            const float actual[5] = {fleet.Q_now[i], fleet.current[i], fleet.speed[i], fleet.temperature[i], fleet.stateOfHealth[i]};
+            for (int f = 0; f < 5; f++){
+                if (memcmp(&expected[f], &actual[f], sizeof(float)) != 0){
+                    if (mismatches == 0){
+                        cout << "First mismatch: vehicle " << i << ", step " << s + 1 << ", " << fields[f] << " " << actual[f]
+                             << " (simulation " << expected[f] << ")\n";
+                    }
+                    mismatches++;
+                }
+            }
+        }
+    }
+
+    float minSOH = 1;
+    for (int i = 0; i < vehicles; i++){
+        minSOH = fleet.stateOfHealth[i] < minSOH ? fleet.stateOfHealth[i] : minSOH;
+    }
+    cout << "Fleet check: " << vehicles << " vehicles x " << steps << " steps of " << dt << " s against one Simulation each\n";
+    cout << "Fleet " << fleetSeconds / steps * 1e6 << " us per step, simulations " << simSeconds / steps * 1e6 << " us per step\n";
+    cout << "Lowest SOH at the end: " << minSOH << "\n";
+    if (mismatches > 0){
+        cout << "FAILED: " << mismatches << " values differ\n";
+        return 1;
+    }
+    cout << "Every vehicle matches its simulation bit for bit (charge, current, speed, temperature and SOH)\n";
+    return 0;
+}
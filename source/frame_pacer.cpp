@@ -0,0 +1,78 @@
+#include <iostream>
+#include <thread>
+#include "../headers/frame_pacer.h"
+using namespace std;
+
+//Sleeps end up to about this late, so the last part of the wait is spun instead
+const chrono::microseconds SPIN_MARGIN(1000);
+
+FramePacer::FramePacer(float rateHz){
+    vsync = false;
+    frames = 0;
+    missed = 0;
+    set_rate(rateHz);
+    lastFrame = chrono::steady_clock::now();
+    deadline = lastFrame + period;
+}
+
+void FramePacer::set_rate(float rateHz){
+    if (rateHz <= 0){
+        cout << "Frame rate must be positive\n";
+        return;
+    }
+    period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(1.0 / rateHz));
+}
+
+float FramePacer::get_rate(){
+    return 1 / chrono::duration<float>(period).count();
+}
+
+void FramePacer::set_vsync(bool on){
+    vsync = on;
+}
+
+bool FramePacer::get_vsync(){
+    return vsync;
+}
+
+chrono::steady_clock::time_point FramePacer::wait(){
+    auto now = chrono::steady_clock::now();
+    if (vsync){
+        //display() waited for the screen; a frame counts as missed when it took more than one refresh
+        if (now - lastFrame > period + period / 2){
+            missed++;
+        }
+    } else if (now > deadline){
+        missed++; //The frame's work overran
+        if (now - deadline > period){
+            deadline = now; //Far behind: start again from now instead of rushing frames to catch up
+        }
+    } else{
+        if (deadline - now > SPIN_MARGIN){
+            this_thread::sleep_until(deadline - SPIN_MARGIN);
+        }
+        while (chrono::steady_clock::now() < deadline){
+            this_thread::yield();
+        }
+        now = chrono::steady_clock::now();
+    }
+    deadline = (vsync ? now : deadline) + period;
+
+    float interval = chrono::duration<float>(now - lastFrame).count();
+    lastFrame = now;
+    frames++;
+    frameTimes.add(interval * 1000);
+    return now;
+}
+
+float FramePacer::framePercentile(float percentile){
+    return frameTimes.percentile(percentile);
+}
+
+long long FramePacer::get_frames(){
+    return frames;
+}
+
+long long FramePacer::get_missed(){
+    return missed;
+}
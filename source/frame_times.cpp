@@ -0,0 +1,46 @@
+#include <algorithm>
+#include "../headers/frame_times.h"
+using namespace std;
+
+FrameTimes::FrameTimes(size_t capacity){
+    reset(capacity);
+}
+
+void FrameTimes::reset(size_t capacity){
+    times.assign(capacity > 0 ? capacity : 1, 0);
+    next = 0;
+    count = 0;
+}
+
+void FrameTimes::add(float ms){
+    times[next] = ms;
+    next = next + 1 == times.size() ? 0 : next + 1;
+    if (count < times.size()){
+        count++;
+    }
+}
+
+size_t FrameTimes::size() const{
+    return count;
+}
+
+float FrameTimes::percentile(float percentile) const{
+    if (count == 0){
+        return 0;
+    }
+    vector<float> sorted(times.begin(), times.begin() + count);
+    size_t index = static_cast<size_t>(percentile / 100 * (count - 1) + 0.5);
+    nth_element(sorted.begin(), sorted.begin() + index, sorted.end());
+    return sorted[index];
+}
+
+void FrameTimes::histogram(vector<int> &bins, float binMs) const{
+    fill(bins.begin(), bins.end(), 0);
+    if (bins.empty() || binMs <= 0){
+        return;
+    }
+    for (size_t i = 0; i < count; i++){
+        size_t bin = static_cast<size_t>(times[i] / binMs);
+        bins[min(bin, bins.size() - 1)]++;
+    }
+}
@@ -5,9 +5,31 @@
 # "pip install pandas"
 # "pip install matplotlib"
 
+import numpy as np
 import pandas as pd
 import matplotlib.pyplot as plt
 
+# Largest-Triangle-Three-Buckets: pick the points that keep the shape of the line,
+# so long logs plot quickly (same as "main --decimate")
+def lttb(x, y, points=2000):
+    x = np.asarray(x, dtype=float)
+    y = np.asarray(y, dtype=float)
+    if points >= len(x) or points < 3:
+        return x, y
+    edges = (np.arange(points - 1) * (len(x) - 2) / (points - 2)).astype(int) + 1
+    edges[-1] = len(x) - 1
+    picked = [0]
+    for b in range(points - 2):
+        start, end = edges[b], edges[b + 1]
+        nextEnd = edges[b + 2] if b + 2 < points - 1 else len(x)
+        meanX = x[end:nextEnd].mean()
+        meanY = y[end:nextEnd].mean()
+        a = picked[-1]
+        area = np.abs((x[a] - meanX) * (y[start:end] - y[a]) - (x[a] - x[start:end]) * (meanY - y[a]))
+        picked.append(start + int(np.argmax(area)))
+    picked.append(len(x) - 1)
+    return x[picked], y[picked]
+
 # Load the CSV file
 outputData = pd.read_csv("output.csv")
 
@@ -16,7 +38,7 @@ plt.figure(figsize=(12, 6))
 
 # Speed Plot
 plt.subplot(2, 1, 1)
-plt.plot(outputData["Time"], outputData["Speed"], label="Speed in meters/second", color="red")
+plt.plot(*lttb(outputData["Time"], outputData["Speed"]), label="Speed in meters/second", color="red")
 plt.ylabel("Speed in meters/second")
 plt.title("EV Speed and SOC Over Time")
 plt.grid(True)
@@ -24,7 +46,7 @@ plt.legend()
 
 # SOC Plot
 plt.subplot(2, 1, 2)
-plt.plot(outputData["Time"], outputData["SOC"], label="State of Charge (%)", color="green")
+plt.plot(*lttb(outputData["Time"], outputData["SOC"]), label="State of Charge (%)", color="green")
 plt.xlabel("Time in seconds")
 plt.ylabel("SOC (%)")
 plt.grid(True)
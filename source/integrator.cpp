@@ -0,0 +1,386 @@
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <chrono>
+#include <vector>
+#include "../headers/integrator.h"
+#include "../headers/simulation.h"
+using namespace std;
+
+//default tolerances: well below what the float state of the components can show
+IntegratorOptions::IntegratorOptions(){
+    relTol = 1e-6;
+    absTol = 1e-6;
+    minStep = 1e-6;
+    maxStep = 600;
+}
+
+//State of the ODE: wheel angular speed (rad/s), battery charge (Ah), battery temperature (C)
+const int STATE_SIZE = 3;
+const int EVENT_COUNT = 6;
+
+//The components and the inputs that stay constant over one integrateVehicle call
+struct VehicleModel{
+    Motor *motor;
+    Battery *battery;
+    DriverInput *input;
+    float wheelRadius;
+    float maxSpeed;
+    float Q_max;
+    float V_max;
+    float ambientTemp;
+    float angularAcceleration; //Depends only on the driver input
+    float chargeRate; //0 when the charger is not plugged in
+};
+
+//@brief vehicle speed for an angular speed (updateSpeed's conversion and cap)
+float speedAt(const VehicleModel &model, double angularSpeed){
+    float speed = model.wheelRadius * static_cast<float>(angularSpeed > 0 ? angularSpeed : 0);
+    return speed > model.maxSpeed ? model.maxSpeed : speed;
+}
+
+//@brief rates of change of the state, from the same component equations the fixed step uses
+//@param y - state, dy - rates (output), current - battery current (output)
+void vehicleRates(const VehicleModel &model, const double* y, double* dy, float &current){
+    //Wheels: constant angular acceleration, stopped wheels stay stopped while braking or coasting
+    dy[0] = (y[0] <= 0 && model.angularAcceleration < 0) ? 0 : model.angularAcceleration;
+
+    float speed = speedAt(model, y[0]);
+    model.motor->set_speed(speed);
+    float regenCurrent = model.motor->calculateRegenPower(*model.input) / model.V_max;
+    float drain = model.battery->dischargeRate(speed, static_cast<float>(y[2]));
+
+    //Battery charge, held at 0 when empty and at Q_max when full
+    double dQ = regenCurrent + model.chargeRate - drain;
+    current = regenCurrent - drain;
+    if (y[1] <= 0 && dQ < 0){
+        dQ = 0;
+        current = 0; //An empty battery cannot supply current
+    } else if (y[1] >= model.Q_max && dQ > 0){
+        dQ = 0;
+    }
+    dy[1] = dQ;
+
+    dy[2] = model.battery->heatBalance(static_cast<float>(y[2]), current, model.ambientTemp);
+}
+
+//@brief event functions: each changes sign where the equations change form
+void eventValues(const VehicleModel &model, const double* y, double* g){
+    g[0] = model.angularAcceleration < 0 ? y[0] : 1; //Wheels stopping (only possible while decelerating)
+    g[1] = model.wheelRadius * y[0] - model.maxSpeed; //Reaching max speed
+    g[2] = y[1]; //Battery empty
+    g[3] = y[1] - model.Q_max; //Battery full
+    g[4] = y[2] - 40; //Hot discharge tier
+    g[5] = y[2]; //Cold discharge tier
+}
+
+//Dormand-Prince 5(4) coefficients (the equations do not depend on time, so the stage times are not needed)
+const double DP_A[7][6] = {
+    {0, 0, 0, 0, 0, 0},
+    {1.0 / 5, 0, 0, 0, 0, 0},
+    {3.0 / 40, 9.0 / 40, 0, 0, 0, 0},
+    {44.0 / 45, -56.0 / 15, 32.0 / 9, 0, 0, 0},
+    {19372.0 / 6561, -25360.0 / 2187, 64448.0 / 6561, -212.0 / 729, 0, 0},
+    {9017.0 / 3168, -355.0 / 33, 46732.0 / 5247, 49.0 / 176, -5103.0 / 18656, 0},
+    {35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84}};
+const double DP_B5[7] = {35.0 / 384, 0, 500.0 / 1113, 125.0 / 192, -2187.0 / 6784, 11.0 / 84, 0};
+const double DP_B4[7] = {5179.0 / 57600, 0, 7571.0 / 16695, 393.0 / 640, -92097.0 / 339200, 187.0 / 2100, 1.0 / 40};
+
+//@brief one Runge-Kutta step of size h from y0 (k1 = rates at y0)
+//@param y1 - the 5th order solution (output)
+//@return error estimate scaled by the tolerances (<= 1 means the step is accurate enough)
+double rungeKuttaStep(const VehicleModel &model, const double* y0, const double* k1, double h,
+                      const IntegratorOptions &options, double* y1){
+    double k[7][STATE_SIZE];
+    float current;
+    for (int j = 0; j < STATE_SIZE; j++){
+        k[0][j] = k1[j];
+    }
+    double y[STATE_SIZE];
+    for (int stage = 1; stage < 7; stage++){
+        for (int j = 0; j < STATE_SIZE; j++){
+            double sum = 0;
+            for (int s = 0; s < stage; s++){
+                sum += DP_A[stage][s] * k[s][j];
+            }
+            y[j] = y0[j] + h * sum;
+        }
+        vehicleRates(model, y, k[stage], current);
+    }
+
+    //The last stage is evaluated at the 5th order solution, so y holds it now
+    double error = 0;
+    for (int j = 0; j < STATE_SIZE; j++){
+        y1[j] = y[j];
+        double difference = 0;
+        for (int s = 0; s < 7; s++){
+            difference += (DP_B5[s] - DP_B4[s]) * k[s][j];
+        }
+        double scale = options.absTol + options.relTol * max(fabs(y0[j]), fabs(y1[j]));
+        error = max(error, fabs(h * difference) / scale);
+    }
+    return error;
+}
+
+//@brief true if g went from one side of zero to the other side (or onto it)
+bool crosses(double before, double after){
+    return (before > 0 && after <= 0) || (before < 0 && after >= 0);
+}
+
+//@brief find the earliest event between y0 and the end of a step of size h (y1). Bisection on the step
+//size brackets each crossing; the result ends just after it so the next step starts on the new side.
+//@return step size to the earliest event, h if there is none
+double findEvent(const VehicleModel &model, const double* y0, const double* k1, double h,
+                 const IntegratorOptions &options, const double* y1){
+    double g0[EVENT_COUNT], g1[EVENT_COUNT];
+    eventValues(model, y0, g0);
+    eventValues(model, y1, g1);
+    double eventStep = h;
+    for (int e = 0; e < EVENT_COUNT; e++){
+        if (!crosses(g0[e], g1[e])){
+            continue;
+        }
+        double low = 0, high = h;
+        double yMid[STATE_SIZE], gMid[EVENT_COUNT];
+        while (high - low > 1e-9 * max(1.0, h)){
+            double mid = 0.5 * (low + high);
+            rungeKuttaStep(model, y0, k1, mid, options, yMid);
+            eventValues(model, yMid, gMid);
+            if (crosses(g0[e], gMid[e])){
+                high = mid;
+            } else{
+                low = mid;
+            }
+        }
+        eventStep = min(eventStep, high);
+    }
+    return eventStep;
+}
+
+float integrateVehicle(Motor &motor, Battery &battery, EV &vehicle, Charger &charger, DriverInput &input,
+                       bool charging, float ambientTemp, double duration, const IntegratorOptions &options,
+                       IntegratorStats &stats){
+    VehicleModel model;
+    model.motor = &motor;
+    model.battery = &battery;
+    model.input = &input;
+    model.wheelRadius = vehicle.get_wheelRadius();
+    model.maxSpeed = motor.get_maxSpeed();
+    model.Q_max = battery.get_Q_max();
+    model.V_max = battery.get_V_max();
+    model.ambientTemp = ambientTemp;
+    model.angularAcceleration = motor.angularAcceleration(input);
+    model.chargeRate = charging ? battery.chargeRate(charger.chargingVoltage(battery)) : 0;
+
+    double y[STATE_SIZE] = {motor.get_angularSpeed(), battery.get_Q_current(), battery.get_temp()};
+    double k1[STATE_SIZE], y1[STATE_SIZE];
+    float current = 0;
+
+    double t = 0;
+    double h = min(options.maxStep, duration);
+    while (t < duration){
+        bool last = h >= duration - t;
+        if (last){
+            h = duration - t;
+        }
+        vehicleRates(model, y, k1, current);
+
+        //Try the step, cut it short at the earliest event inside it, and shrink it until its error is
+        //within the tolerances. Cutting at the event first keeps the kinks out of the error estimate.
+        double error, tried;
+        for (;;){
+            tried = h;
+            error = rungeKuttaStep(model, y, k1, h, options, y1);
+            double eventStep = findEvent(model, y, k1, h, options, y1);
+            if (eventStep < h){
+                h = eventStep;
+                last = false;
+                error = rungeKuttaStep(model, y, k1, h, options, y1);
+            }
+            if (error <= 1 || h <= options.minStep){
+                if (eventStep < tried){
+                    stats.events++;
+                }
+                break;
+            }
+            stats.rejected++;
+            h = max(options.minStep, h * max(0.2, 0.9 * pow(error, -0.2)));
+            last = false;
+        }
+
+        for (int j = 0; j < STATE_SIZE; j++){
+            y[j] = y1[j];
+        }
+        //Land exactly on the clamped values (the event step ends a hair past them)
+        if (y[0] < 0){
+            y[0] = 0;
+        }
+        if (y[1] < 0){
+            y[1] = 0;
+        } else if (y[1] > model.Q_max){
+            y[1] = model.Q_max;
+        }
+        t = last ? duration : t + h;
+        stats.accepted++;
+
+        //Next step size from the error of the step that was tried
+        double growth = error > 0 ? 0.9 * pow(error, -0.2) : 5;
+        h = min(options.maxStep, tried * min(5.0, max(0.2, growth)));
+    }
+
+    //Write the state back into the components
+    vehicleRates(model, y, k1, current);
+    float speed = speedAt(model, y[0]);
+    motor.set_angularSpeed(static_cast<float>(y[0]));
+    motor.set_speed(speed);
+    battery.set_Q_current(static_cast<float>(y[1]));
+    battery.set_temp(static_cast<float>(y[2]));
+    battery.setCurrent(current);
+    if (charging){
+        charger.startCharging(battery, 0); //Updates the charging state (stops when the battery is full)
+    }
+    return speed;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+//One phase of the check scenario: inputs held for a duration
+struct CheckPhase{
+    const char* name;
+    float duration;
+    float throttle;
+    float brake;
+    bool charging;
+    float ambientTemp;
+};
+
+//State at the end of a phase
+struct PhaseEnd{
+    float speed;
+    float SOC;
+    float temperature;
+    long long steps; //Steps taken from the start of the scenario
+};
+
+//@brief run the check scenario with fixed Euler steps (dt > 0) or the adaptive integrator (dt == 0)
+//@return steps taken
+long long runCheckScenario(const vector<CheckPhase> &phases, float dt, const IntegratorOptions &options,
+                           vector<PhaseEnd> &ends, long long &events){
+    Simulation sim;
+    ends.clear();
+    long long steps = 0;
+    events = 0;
+    for (const CheckPhase &phase : phases){
+        sim.get_input().set_throttle(phase.throttle);
+        sim.get_input().set_brake(phase.brake);
+        sim.set_ambientTemp(phase.ambientTemp);
+        if (dt > 0){
+            long long count = static_cast<long long>(phase.duration / dt + 0.5);
+            for (long long i = 0; i < count; i++){
+                sim.step(dt, phase.charging);
+            }
+            steps += count;
+        } else{
+            IntegratorStats stats = {0, 0, 0};
+            sim.advance(phase.duration, phase.charging, options, stats);
+            steps += stats.accepted + stats.rejected;
+            events += stats.events;
+        }
+        ends.push_back(PhaseEnd{sim.get_speed(), sim.get_battery().get_SOC(), sim.get_battery().get_temp(), steps});
+    }
+    return steps;
+}
+
+//@return the spacing of floats at a value (the components store the state as float)
+float floatSpacing(float value){
+    value = fabs(value);
+    return nextafterf(value, INFINITY) - value;
+}
+
+//@brief the largest error the adaptive integrator may have after a number of steps: every step may add
+//its local error allowance (absTol + relTol * |state|), plus the rounding of storing the state as float
+//@param value - reference value, scale - the channel per unit of the integrated state (wheel radius for the
+//speed, 100 / Q_max for the SOC, 1 for the temperature)
+double adaptiveErrorBound(const IntegratorOptions &options, long long steps, float value, double scale){
+    double state = fabs(value) / scale;
+    return steps * (options.absTol + options.relTol * state) * scale + floatSpacing(value);
+}
+
+int runIntegratorCheck(){
+    //Accelerate to max speed, cruise until the battery is empty, brake to a stop, park on a hot day
+    //(the battery crosses 40 C) and charge to full
+    vector<CheckPhase> phases = {
+        {"accelerate", 30, 1.0, 0.0, false, 25},
+        {"cruise", 1200, 0.3, 0.0, false, 25},
+        {"coast", 20, 0.0, 0.0, false, 25},
+        {"brake", 60, 0.0, 1.0, false, 25},
+        {"park (hot)", 7200, 0.0, 1.0, false, 48},
+        {"charge", 3600, 0.0, 1.0, true, 48},
+    };
+
+    IntegratorOptions reference;
+    reference.relTol = 1e-12;
+    reference.absTol = 1e-12;
+    vector<PhaseEnd> exact;
+    long long events;
+    runCheckScenario(phases, 0, reference, exact, events);
+
+    float totalTime = 0;
+    for (const CheckPhase &phase : phases){
+        totalTime += phase.duration;
+    }
+    cout << "Integrator check: " << phases.size() << " phases, " << totalTime << " simulated seconds\n";
+    cout << "Errors are the largest difference from a 1e-12 tolerance run at the end of any phase\n";
+    cout << left << setw(22) << "method" << setw(10) << "steps" << setw(8) << "events" << setw(14) << "speed err"
+         << setw(14) << "SOC err" << setw(14) << "temp err" << "time (ms)\n";
+
+    struct Method{
+        string name;
+        float dt;
+        double tolerance;
+    };
+    vector<Method> methods = {
+        {"Euler dt=0.016", 0.016, 0}, {"Euler dt=1", 1, 0},
+        {"adaptive tol=1e-3", 0, 1e-3}, {"adaptive tol=1e-6", 0, 1e-6}, {"adaptive tol=1e-9", 0, 1e-9}};
+    //Scale of the speed and SOC to the integrated angular speed (rad/s) and charge (Ah)
+    const double wheelRadius = EV().get_wheelRadius();
+    const double Q_max = Battery().get_Q_max();
+    bool passed = true;
+    for (const Method &method : methods){
+        IntegratorOptions options;
+        if (method.dt == 0){
+            options.relTol = method.tolerance;
+            options.absTol = method.tolerance;
+        }
+        vector<PhaseEnd> ends;
+        auto start = chrono::steady_clock::now();
+        long long steps = runCheckScenario(phases, method.dt, options, ends, events);
+        double ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+
+        float speedError = 0, socError = 0, tempError = 0;
+        const char* outside = nullptr; //First phase end past the error bound (adaptive only)
+        for (size_t p = 0; p < phases.size(); p++){
+            float errors[3] = {fabs(ends[p].speed - exact[p].speed), fabs(ends[p].SOC - exact[p].SOC),
+                               fabs(ends[p].temperature - exact[p].temperature)};
+            speedError = max(speedError, errors[0]);
+            socError = max(socError, errors[1]);
+            tempError = max(tempError, errors[2]);
+            if (method.dt == 0 && outside == nullptr
+                && (errors[0] > adaptiveErrorBound(options, ends[p].steps, exact[p].speed, wheelRadius)
+                    || errors[1] > adaptiveErrorBound(options, ends[p].steps, exact[p].SOC, 100 / Q_max)
+                    || errors[2] > adaptiveErrorBound(options, ends[p].steps, exact[p].temperature, 1))){
+                outside = phases[p].name;
+            }
+        }
+        cout << left << setw(22) << method.name << setw(10) << steps << setw(8) << (method.dt > 0 ? string("-") : to_string(events))
+             << setw(14) << speedError << setw(14) << socError << setw(14) << tempError << ms << "\n";
+        if (outside != nullptr){
+            cout << "  FAIL: past the error bound of its tolerance at the end of " << outside << "\n";
+            passed = false;
+        }
+    }
+    cout << "(Euler temperatures also differ because Battery::discharge accumulates the current of every step)\n";
+    cout << "Adaptive runs must stay within steps x (absTol + relTol x |state|) of the reference, plus the float resolution: "
+         << (passed ? "ok" : "FAILED") << "\n";
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,435 @@
+#include <iostream>
+#include <fstream>
+#include <charconv>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include "../headers/log_analytics.h"
+#include "../headers/telemetry.h"
+#include "../headers/thread_pool.h"
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+using namespace std;
+
+MappedFile::MappedFile(){
+    bytes = nullptr;
+    length = 0;
+    mapping = nullptr;
+}
+
+MappedFile::~MappedFile(){
+    close();
+}
+
+//@brief map (or read) a whole file
+//@return false if the file cannot be opened
+bool MappedFile::open(const string &path){
+    close();
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0){
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0){
+        ::close(fd);
+        return false;
+    }
+    length = static_cast<size_t>(info.st_size);
+    if (length > 0){
+        void* address = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (address == MAP_FAILED){
+            ::close(fd);
+            length = 0;
+            return false;
+        }
+        madvise(address, length, MADV_SEQUENTIAL);
+        mapping = address;
+        bytes = static_cast<const char*>(address);
+    }
+    ::close(fd); //The mapping stays valid after the descriptor is closed
+    return true;
+#else
+    ifstream file(path, ios::binary | ios::ate);
+    if (!file.is_open()){
+        return false;
+    }
+    length = static_cast<size_t>(file.tellg());
+    buffer.resize(length);
+    file.seekg(0);
+    file.read(buffer.data(), length);
+    bytes = buffer.data();
+    return true;
+#endif
+}
+
+void MappedFile::close(){
+#if !defined(_WIN32)
+    if (mapping != nullptr){
+        munmap(mapping, length);
+    }
+#endif
+    mapping = nullptr;
+    bytes = nullptr;
+    length = 0;
+    buffer.clear();
+}
+
+const char* MappedFile::data() const{
+    return bytes;
+}
+
+size_t MappedFile::size() const{
+    return length;
+}
+
+size_t LogColumns::rows() const{
+    return time.size();
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+//Positions of the columns we need in a CSV row
+struct CsvLayout{
+    int time, speed, soc, batteryTemp;
+    int fields; //Number of fields we have to look at (highest needed index + 1)
+};
+
+//@brief find the needed columns in the CSV header line
+//@return false if one of them is missing
+bool readCsvHeader(const char* begin, const char* end, CsvLayout &layout){
+    layout.time = layout.speed = layout.soc = layout.batteryTemp = -1;
+    int index = 0;
+    const char* field = begin;
+    while (field <= end){
+        const char* comma = static_cast<const char*>(memchr(field, ',', end - field));
+        const char* fieldEnd = comma ? comma : end;
+        string name(field, fieldEnd);
+        if (!name.empty() && name.back() == '\r'){
+            name.pop_back();
+        }
+        if (name == "Time") layout.time = index;
+        else if (name == "Speed") layout.speed = index;
+        else if (name == "SOC") layout.soc = index;
+        else if (name == "BatteryTemp") layout.batteryTemp = index;
+        index++;
+        if (!comma){
+            break;
+        }
+        field = comma + 1;
+    }
+    layout.fields = max(max(layout.time, layout.speed), max(layout.soc, layout.batteryTemp)) + 1;
+    return layout.time >= 0 && layout.speed >= 0 && layout.soc >= 0 && layout.batteryTemp >= 0;
+}
+
+//@brief parse the rows in [begin, end), which has to start at the beginning of a line
+void parseCsvRows(const char* begin, const char* end, const CsvLayout &layout, LogColumns &columns){
+    columns.badRows = 0;
+    //Rough guess of the row count (rows in output.csv are around 25 bytes) to avoid regrowing the vectors
+    size_t estimate = (end - begin) / 24 + 1;
+    columns.time.reserve(estimate);
+    columns.speed.reserve(estimate);
+    columns.soc.reserve(estimate);
+    columns.batteryTemp.reserve(estimate);
+
+    float values[4];
+    const char* line = begin;
+    while (line < end){
+        const char* newline = static_cast<const char*>(memchr(line, '\n', end - line));
+        const char* lineEnd = newline ? newline : end;
+        if (lineEnd > line){
+            const char* field = line;
+            int found = 0;
+            bool ok = true;
+            for (int index = 0; index < layout.fields && ok; index++){
+                if (field > lineEnd){
+                    ok = false;
+                    break;
+                }
+                const char* comma = static_cast<const char*>(memchr(field, ',', lineEnd - field));
+                const char* fieldEnd = comma ? comma : lineEnd;
+                int slot = index == layout.time ? 0 : index == layout.speed ? 1 : index == layout.soc ? 2 :
+                           index == layout.batteryTemp ? 3 : -1;
+                if (slot >= 0){
+                    from_chars_result result = from_chars(field, fieldEnd, values[slot]);
+                    if (result.ec != errc() || (result.ptr != fieldEnd && *result.ptr != '\r')){
+                        ok = false;
+                    }
+                    found++;
+                }
+                field = fieldEnd + 1;
+            }
+            if (ok && found == 4){
+                columns.time.push_back(values[0]);
+                columns.speed.push_back(values[1]);
+                columns.soc.push_back(values[2]);
+                columns.batteryTemp.push_back(values[3]);
+            } else{
+                columns.badRows++;
+            }
+        }
+        line = lineEnd + 1;
+    }
+}
+
+//@brief append the rows of part to columns
+void appendColumns(LogColumns &columns, const LogColumns &part){
+    columns.time.insert(columns.time.end(), part.time.begin(), part.time.end());
+    columns.speed.insert(columns.speed.end(), part.speed.begin(), part.speed.end());
+    columns.soc.insert(columns.soc.end(), part.soc.begin(), part.soc.end());
+    columns.batteryTemp.insert(columns.batteryTemp.end(), part.batteryTemp.begin(), part.batteryTemp.end());
+    columns.badRows += part.badRows;
+}
+
+//@brief load a binary log with TelemetryReader
+bool loadBinaryLog(const string &path, LogColumns &columns){
+    TelemetryReader reader;
+    if (!reader.open(path)){
+        return false;
+    }
+    const vector<TelemetryChannel> &channels = reader.get_channels();
+    int index[4] = {-1, -1, -1, -1};
+    const char* names[4] = {"Time", "Speed", "SOC", "BatteryTemp"};
+    for (size_t c = 0; c < channels.size(); c++){
+        for (int n = 0; n < 4; n++){
+            if (channels[c].name == names[n]) index[n] = static_cast<int>(c);
+        }
+    }
+    if (index[0] < 0 || index[1] < 0 || index[2] < 0 || index[3] < 0){
+        return false;
+    }
+    vector<vector<float>> block;
+    while (reader.readBlock(block)){
+        columns.time.insert(columns.time.end(), block[index[0]].begin(), block[index[0]].end());
+        columns.speed.insert(columns.speed.end(), block[index[1]].begin(), block[index[1]].end());
+        columns.soc.insert(columns.soc.end(), block[index[2]].begin(), block[index[2]].end());
+        columns.batteryTemp.insert(columns.batteryTemp.end(), block[index[3]].begin(), block[index[3]].end());
+    }
+    if (reader.is_damaged()){
+        cout << "Warning: telemetry file " << path << " is damaged or cut off; only the rows before the damage are used\n";
+    }
+    return true;
+}
+
+bool loadLog(const string &path, LogColumns &columns, ThreadPool* pool){
+    columns = LogColumns();
+    columns.badRows = 0;
+    if (!isCsvPath(path)){
+        return loadBinaryLog(path, columns);
+    }
+
+    MappedFile file;
+    if (!file.open(path)){
+        return false;
+    }
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    if (file.size() == 0){
+        return false;
+    }
+    const char* headerEnd = static_cast<const char*>(memchr(begin, '\n', file.size()));
+    CsvLayout layout;
+    if (headerEnd == nullptr || !readCsvHeader(begin, headerEnd, layout)){
+        return false;
+    }
+    const char* body = headerEnd + 1;
+
+    //Cut the body into parts of about 8 MB that start and end on line boundaries
+    const size_t partBytes = 8 << 20;
+    vector<const char*> cuts;
+    cuts.push_back(body);
+    const char* cut = body;
+    while (static_cast<size_t>(end - cut) > partBytes){
+        cut += partBytes;
+        const char* newline = static_cast<const char*>(memchr(cut, '\n', end - cut));
+        if (newline == nullptr){
+            break;
+        }
+        cut = newline + 1;
+        cuts.push_back(cut);
+    }
+    cuts.push_back(end);
+
+    int parts = static_cast<int>(cuts.size()) - 1;
+    vector<LogColumns> results(parts);
+    auto parsePart = [&](int part){
+        parseCsvRows(cuts[part], cuts[part + 1], layout, results[part]);
+    };
+    if (pool != nullptr){
+        pool->run(parts, parsePart);
+    } else{
+        for (int part = 0; part < parts; part++){
+            parsePart(part);
+        }
+    }
+
+    if (parts == 1){
+        columns = move(results[0]);
+    } else{
+        for (const LogColumns &part : results){
+            appendColumns(columns, part);
+        }
+    }
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+ChannelStats computeStats(const float* values, size_t count, vector<float> &scratch){
+    ChannelStats stats = {count, 0, 0, 0, 0, 0, 0};
+    if (count == 0){
+        return stats;
+    }
+    double sum = 0;
+    float lowest = values[0], highest = values[0];
+    for (size_t i = 0; i < count; i++){
+        sum += values[i];
+        lowest = min(lowest, values[i]);
+        highest = max(highest, values[i]);
+    }
+    stats.mean = static_cast<float>(sum / count);
+    stats.min = lowest;
+    stats.max = highest;
+
+    //Nearest-rank percentiles. Each nth_element only has to look at the part above the previous one.
+    scratch.assign(values, values + count);
+    size_t ranks[3];
+    float* results[3] = {&stats.p50, &stats.p95, &stats.p99};
+    const double percents[3] = {0.50, 0.95, 0.99};
+    size_t from = 0;
+    for (int p = 0; p < 3; p++){
+        ranks[p] = static_cast<size_t>(ceil(percents[p] * count));
+        ranks[p] = ranks[p] == 0 ? 0 : ranks[p] - 1;
+        nth_element(scratch.begin() + from, scratch.begin() + ranks[p], scratch.end());
+        *results[p] = scratch[ranks[p]];
+        from = ranks[p];
+    }
+    return stats;
+}
+
+void computeWindows(const LogColumns &columns, float windowSeconds, vector<WindowStats> &windows, ThreadPool* pool){
+    windows.clear();
+    size_t rows = columns.rows();
+    if (rows == 0){
+        return;
+    }
+
+    //Time only goes forward in a log, so every window is a contiguous range of rows
+    vector<size_t> starts;
+    float windowStart = columns.time[0];
+    starts.push_back(0);
+    for (size_t r = 1; r < rows; r++){
+        if (columns.time[r] >= windowStart + windowSeconds){
+            windowStart += windowSeconds * floor((columns.time[r] - windowStart) / windowSeconds);
+            starts.push_back(r);
+        }
+    }
+    starts.push_back(rows);
+
+    int count = static_cast<int>(starts.size()) - 1;
+    windows.resize(count);
+    auto computeWindow = [&](int w){
+        vector<float> scratch;
+        size_t begin = starts[w], length = starts[w + 1] - starts[w];
+        windows[w].start = columns.time[begin];
+        windows[w].speed = computeStats(&columns.speed[begin], length, scratch);
+        windows[w].soc = computeStats(&columns.soc[begin], length, scratch);
+        windows[w].batteryTemp = computeStats(&columns.batteryTemp[begin], length, scratch);
+    };
+    if (pool != nullptr){
+        pool->run(count, computeWindow);
+    } else{
+        for (int w = 0; w < count; w++){
+            computeWindow(w);
+        }
+    }
+}
+
+//@brief print one line of statistics
+void printStats(const string &name, const ChannelStats &stats){
+    cout << "  " << name << ": mean " << stats.mean << ", min " << stats.min << ", max " << stats.max
+         << ", p50 " << stats.p50 << ", p95 " << stats.p95 << ", p99 " << stats.p99 << "\n";
+}
+
+//@brief load each log, print whole-log statistics and optionally write per-window statistics to a CSV
+//@param paths - logs to analyse, windowSeconds - window length (0 for no windows), threads - threads to use,
+//windowsPath - CSV file for the window statistics (empty to skip)
+//@return 0 on success, 1 if a file could not be read
+int runLogAnalytics(const vector<string> &paths, float windowSeconds, int threads, const string &windowsPath){
+    ThreadPool pool(threads);
+    ofstream windowFile;
+    if (!windowsPath.empty()){
+        windowFile.open(windowsPath);
+        if (!windowFile.is_open()){
+            cout << "Cannot open file " << windowsPath << "\n";
+            return 1;
+        }
+        windowFile << "File,Start,Rows";
+        const char* channels[3] = {"Speed", "SOC", "BatteryTemp"};
+        const char* stats[6] = {"Mean", "Min", "Max", "P50", "P95", "P99"};
+        for (const char* channel : channels){
+            for (const char* stat : stats){
+                windowFile << "," << channel << stat;
+            }
+        }
+        windowFile << "\n";
+    }
+
+    int result = 0;
+    for (const string &path : paths){
+        auto start = chrono::steady_clock::now();
+        LogColumns columns;
+        if (!loadLog(path, columns, &pool)){
+            cout << "Cannot read log " << path << "\n";
+            result = 1;
+            continue;
+        }
+        auto loaded = chrono::steady_clock::now();
+
+        vector<float> scratch;
+        size_t rows = columns.rows();
+        ChannelStats speed = computeStats(columns.speed.data(), rows, scratch);
+        ChannelStats soc = computeStats(columns.soc.data(), rows, scratch);
+        ChannelStats temp = computeStats(columns.batteryTemp.data(), rows, scratch);
+
+        vector<WindowStats> windows;
+        if (windowSeconds > 0){
+            computeWindows(columns, windowSeconds, windows, &pool);
+        }
+        auto finished = chrono::steady_clock::now();
+
+        double loadSeconds = chrono::duration<double>(loaded - start).count();
+        double totalSeconds = chrono::duration<double>(finished - start).count();
+        MappedFile sizeCheck;
+        double megabytes = sizeCheck.open(path) ? sizeCheck.size() / 1e6 : 0;
+
+        cout << path << ": " << rows << " rows";
+        if (columns.badRows > 0){
+            cout << " (" << columns.badRows << " unreadable rows skipped)";
+        }
+        cout << ", " << windows.size() << " windows\n";
+        cout << "  loaded " << megabytes << " MB in " << loadSeconds << " s (" << megabytes / loadSeconds
+             << " MB/s), total " << totalSeconds << " s\n";
+        printStats("Speed", speed);
+        printStats("SOC", soc);
+        printStats("BatteryTemp", temp);
+
+        if (windowFile.is_open()){
+            for (const WindowStats &window : windows){
+                windowFile << path << "," << window.start << "," << window.speed.count;
+                const ChannelStats* channels[3] = {&window.speed, &window.soc, &window.batteryTemp};
+                for (const ChannelStats* s : channels){
+                    windowFile << "," << s->mean << "," << s->min << "," << s->max
+                               << "," << s->p50 << "," << s->p95 << "," << s->p99;
+                }
+                windowFile << "\n";
+            }
+        }
+    }
+    return result;
+}
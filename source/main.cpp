@@ -4,17 +4,29 @@
 #include <string>
 #include <thread>
 #include <chrono>
+#include <cmath>
+#include <future>
 #include "../headers/driver_input.h"
 #include "../headers/vehicle.h"
 #include "../headers/components.h"
+#include "../headers/simulation.h"
+#include "../headers/cli.h"
+#include "../headers/telemetry.h"
+#include "../headers/async_telemetry.h"
+#include "../headers/log_analytics.h"
+#include "../headers/profiler.h"
+#include "../headers/physics_thread.h"
+#include "../headers/frame_pacer.h"
+#include "../headers/range_oracle.h"
 #include <SFML/Graphics.hpp>
 #include <SFML/System.hpp>  //For sf::Clock
 #include <SFML/Window.hpp>
 #include <fstream>
+#include <sstream>
+#include <iomanip>
 
 // https://en.cppreference.com/w/cpp/thread/sleep_for
-// https://cplusplus.com/reference/string/string/find/
-// https://cplusplus.com/reference/string/string/substr/
+// https://en.cppreference.com/w/cpp/utility/from_chars
 // I learned all the SFML functionality from this code on this website: https://www.sfml-dev.org/tutorials/2.6/
 
 using namespace std;
@@ -51,46 +63,23 @@ float getValidatedInput(string prompt){
 //@brief gets the average speed over sampled time intervals
 //@param sampleCount - number of data points to use, sampleInterval - number of seconds between each sample
 void averageSpeed(int sampleCount, float sampleInterval){
-    //dynamically allocate memory for storing the speed samples
-    float* speeds = new float[sampleCount];
-
-    ifstream file("output.csv"); //get the speed samples from the output file
-    if (!file.is_open()){
+    //Load the Time and Speed columns of the output file (memory-mapped and parsed with from_chars)
+    LogColumns log;
+    if (!loadLog("output.csv", log, nullptr)){
         std::cout << "Cannot open file\n";
         return;
     }
 
-    string line;
-    //skip the header line
-    getline(file, line);
-
     float lastSampleTime = -sampleInterval;  //initialize and sample the first entry
     int i = 0;  //Counter for how many samples we've read
+    float sum = 0;
 
-    //Loop through each line of the CSV until we have enough samples
-    while (i < sampleCount && getline(file, line)){
-        //Find the first comma to extract the timestamp
-        int firstComma = line.find(','); //we need to know where the first comma ends to accurately parse the for the time stamp
-        if (firstComma == -1){
-            break; //line.find() returns - 1 when assigned to an int and if the comma isn't found
-        }
-
-        //extract the time and convert from string to float using stof()
-        float time = stof(line.substr(0, firstComma));
-
-        //find the second comma to get the speed
-        int secondComma = line.find(',', firstComma + 1);
-        if (secondComma == -1){
-            break;
-        }
-
-        //extract the speed and convert to float
-        float speed = stof(line.substr(firstComma + 1, secondComma - firstComma - 1));
-
+    //Go through the rows until we have enough samples
+    for (size_t row = 0; row < log.rows() && i < sampleCount; row++){
         //Only take this speed if enough time has passed since the last sample
-        if (time - lastSampleTime >= sampleInterval){
-            speeds[i] = speed; //Store the sampled speed
-            lastSampleTime = time; //update the last sampled time
+        if (log.time[row] - lastSampleTime >= sampleInterval){
+            sum += log.speed[row];
+            lastSampleTime = log.time[row]; //update the last sampled time
             i++; //Move to the next sample
         }
     }
@@ -100,20 +89,53 @@ void averageSpeed(int sampleCount, float sampleInterval){
        cout << "No samples collected.\n";
     } else{
         //Here is where we calculate the average of all collected speed samples
-        float sum = 0;
-        for (int j = 0; j < i; j++){
-            sum += speeds[j];
-        }
         float averageSpeed = sum / i;
 
         cout << "Average speed over " << i << " samples (every " << sampleInterval << "s): " << averageSpeed << " m/s\n";
     }
-
-    delete[] speeds; //free memory
 }
 
 
 
+//@brief draw the frame-time histogram of the profiler (bottom right corner of the window)
+//@param window - where to draw, font - for the labels
+void drawProfilerOverlay(sf::RenderWindow &window, sf::Font &font){
+    const int binCount = 40; //1 ms per bin, the last bin collects every frame of 39 ms or more
+    const float left = 880, top = 500, width = 380, height = 200;
+    vector<int> bins(binCount);
+    profiler.frameHistogram(bins, 1.0);
+    int tallest = 1;
+    for (int count : bins){
+        tallest = max(tallest, count);
+    }
+
+    sf::RectangleShape panel(sf::Vector2f(width, height));
+    panel.setPosition(left, top);
+    panel.setFillColor(sf::Color(0, 0, 0, 180));
+    window.draw(panel);
+
+    sf::RectangleShape bar;
+    bar.setFillColor(sf::Color(100, 220, 100));
+    float barWidth = (width - 20) / binCount;
+    for (int i = 0; i < binCount; i++){
+        float barHeight = 140.0f * bins[i] / tallest;
+        bar.setSize(sf::Vector2f(barWidth - 1, barHeight));
+        bar.setPosition(left + 10 + i * barWidth, top + height - 10 - barHeight);
+        window.draw(bar);
+    }
+
+    stringstream label;
+    label << fixed << setprecision(1) << "frame ms  p50 " << profiler.framePercentile(50) << "  p99 "
+          << profiler.framePercentile(99) << "  (" << profiler.recentFrames() << " frames, 0-40 ms)";
+    sf::Text text;
+    text.setFont(font);
+    text.setString(label.str());
+    text.setCharacterSize(16);
+    text.setFillColor(sf::Color::White);
+    text.setPosition(left + 10, top + 8);
+    window.draw(text);
+}
+
 //@brief helper function to create a button on the display
 void setupButton(sf::RectangleShape &button, sf::Vector2f size, sf::Vector2f position, sf::Color color){
     button.setSize(size);
@@ -141,9 +163,12 @@ bool loadAssets(sf::Font &font, sf::Texture &carTexture, sf::Texture &roadTextur
     return true;
 }
 
-int main(){
-    //Initialize clock (for tracking time)
-    sf::Clock deltaClock;
+int main(int argc, char* argv[]){
+    //Any arguments select one of the command line modes (headless runs etc.), which do not open a window
+    if (argc > 1){
+        return runCommandLine(argc, argv);
+    }
+
     //Initialize window in 1280x720 mode
     sf::RenderWindow window(sf::VideoMode(1280, 720), "Electric Vehicle Simulation");
 
@@ -187,41 +212,126 @@ int main(){
     //Track mouse button previous state (this is to make sure the EV ON/OFF button does not react to mouse holds)
     bool mouseWasPressed = false;
 
-    //Initialize classes + variables
-    DriverInput input;
-    Motor motor;
-    Battery battery;
-    EV myEV;
-    Charger charger;
-    float vehicleSpeed = 0, ambientTemp = 25, batteryTemp = 0;
-
+    //"P" starts/stops the profiler: while it runs the frame-time histogram is shown, and the trace is
+    //written to profile.json when it stops (or when the window closes)
+    bool profileKeyWasPressed = false;
+
+    //Frames start on fixed deadlines instead of sleeping 16 ms on top of the frame's work. "F" switches
+    //between 60, 120 and 144 Hz, "V" turns vsync on and off (the screen then sets the pace).
+    const float frameRates[] = {60, 120, 144};
+    int frameRateIndex = 0;
+    FramePacer pacer(frameRates[frameRateIndex]);
+    chrono::steady_clock::time_point frameStart = chrono::steady_clock::now(); //Each frame draws the physics state at its start
+    bool rateKeyWasPressed = false, vsyncKeyWasPressed = false;
+
+    //Initialize the simulation (driver input, motor, battery, EV and charger) + variables.
+    //It runs on its own thread at a fixed 120 Hz, so the physics does not depend on how fast the window draws;
+    //the loop below only passes the keys in and draws the latest snapshot.
+    PhysicsThread physics(25);
     float roadYPosition = 0.0; //Default Y position of the road
 
-    //Load csv file for info output
-    ofstream logFile("output.csv");
-    logFile << "Time,Speed,SOC,BatteryTemp,Throttle,Brake\n";
-
-    float totalTime = 0.0;  //To track time for the loop of updates
+    //Open the binary telemetry log for info output (converted to output.csv when the window closes).
+    //The physics thread logs every step, and the file is written by a background thread of the writer,
+    //which keeps the rows where a channel changed (with a row at least every second, see windowSamplingPolicies).
+    AsyncTelemetryWriter logFile;
+    if (!logFile.open("output.evtl", windowSamplingPolicies())){
+        cout << "Cannot open output.evtl" << endl;
+    }
+    physics.start(120, &logFile);
+
+    //Remaining range for the HUD, looked up in a table built for the battery and the simulation's ambient
+    //temperature instead of simulated every frame. Tables are built on a background thread (again when the
+    //components are replaced) so the window never waits for one; the last table is shown until the next is ready.
+    RangeOracle rangeOracle;
+    future<RangeOracle> rangeBuild; //Table being built, if any
+    Battery rangeBattery; //Battery of the next table
+    bool rangeStale = true; //The battery changed since the last build started
+
+    //HUD texts are built once; their strings are only reset when the shown value changes (building the
+    //glyph geometry of a text is the expensive part of drawing it)
+    sf::Text alertText; //Battery status alert
+    alertText.setFont(font);
+    alertText.setCharacterSize(50);
+    alertText.setFillColor(sf::Color::Red);
+    alertText.setStyle(sf::Text::Bold);
+    alertText.setPosition(80, 300);
+
+    sf::Text socText;
+    socText.setFont(font);
+    socText.setCharacterSize(30);
+    socText.setFillColor(sf::Color::Black);
+    socText.setPosition(80, 400);
+
+    sf::Text rangeText; //Next to the SOC
+    rangeText.setFont(font);
+    rangeText.setCharacterSize(30);
+    rangeText.setFillColor(sf::Color::Black);
+    rangeText.setPosition(420, 400);
+
+    sf::Text speedText;
+    speedText.setFont(font);
+    speedText.setCharacterSize(30);
+    speedText.setFillColor(sf::Color::Black);
+    speedText.setPosition(80, 450);
+
+    sf::Text tempText;
+    tempText.setFont(font);
+    tempText.setCharacterSize(30);
+    tempText.setFillColor(sf::Color::Black);
+    tempText.setPosition(80, 500);
+
+    //Frame pacing statistics (top right, refreshed every 30 frames)
+    sf::Text pacingText;
+    pacingText.setFont(font);
+    pacingText.setCharacterSize(16);
+    pacingText.setFillColor(sf::Color::White);
+    pacingText.setPosition(900, 10);
+
+    //Values currently shown (out of range at first, so every text gets its string on the first frame)
+    int shownSOC = -1, shownSpeed = -1, shownTemp = -1000, shownAlert = -1, shownRange = -2;
 
     //Run window loop (open screen)
     while (window.isOpen()){
         sf::Event event; //create event
-        float deltaTime = deltaClock.restart().asSeconds(); //use delta time as the interval between each frame
-
-        //For logging battery state to csv
-        totalTime += deltaTime;
-        logFile << totalTime << "," 
-        << vehicleSpeed << "," 
-        << battery.get_SOC() << "," 
-        << battery.get_temp() << "," 
-        << input.get_throttle() << "," 
-        << input.get_brake() << "\n";
+        profiler.beginFrame();
 
         //handle window events
-        while (window.pollEvent(event)){
-            if (event.type == sf::Event::Closed)
-                window.close();
+        {
+            PROFILE_SCOPE("pollEvent");
+            while (window.pollEvent(event)){
+                if (event.type == sf::Event::Closed)
+                    window.close();
+            }
+        }
+
+        //Toggle the profiler on a press of "P"
+        bool profileKeyPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::P);
+        if (profileKeyPressed && !profileKeyWasPressed){
+            if (profiler.is_recording()){
+                profiler.stop();
+                if (profiler.writeChromeTrace("profile.json")){
+                    cout << "Profile written to profile.json\n";
+                }
+            } else{
+                profiler.start();
+                profiler.beginFrame();
+            }
         }
+        profileKeyWasPressed = profileKeyPressed;
+
+        //Frame rate and vsync switches
+        bool rateKeyPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::F);
+        if (rateKeyPressed && !rateKeyWasPressed){
+            frameRateIndex = (frameRateIndex + 1) % 3;
+            pacer.set_rate(frameRates[frameRateIndex]);
+        }
+        rateKeyWasPressed = rateKeyPressed;
+        bool vsyncKeyPressed = sf::Keyboard::isKeyPressed(sf::Keyboard::V);
+        if (vsyncKeyPressed && !vsyncKeyWasPressed){
+            pacer.set_vsync(!pacer.get_vsync());
+            window.setVerticalSyncEnabled(pacer.get_vsync());
+        }
+        vsyncKeyWasPressed = vsyncKeyPressed;
 
         //Get current mouse left button state
         bool mousePressed = sf::Mouse::isButtonPressed(sf::Mouse::Left);
@@ -257,9 +367,9 @@ int main(){
                     Battery newBattery(newBatteryCapacity, newBatteryVMAX, newBatteryRinternal, newBatteryHeatCap);
                     EV newEV(newWheelRadius);
 
-                    motor = newMotor;
-                    battery = newBattery; //Replace old components with new ones
-                    myEV = newEV;
+                    physics.configure(newMotor, newBattery, newEV); //Replace old components with new ones (before the next step)
+                    rangeBattery = newBattery;
+                    rangeStale = true;
 
                     cout << "EV components updated!\n\n";
                 }
@@ -277,109 +387,137 @@ int main(){
             window.clear(sf::Color::Black);
         }
 
-        //Handle driver inputs 
-        //Check if W is pressed
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::W)){
-            input.set_throttle(1.0); //W represents full throttle
-        } else{
-            input.set_throttle(0.0); //If W is not pressed, throttle is 0
-        }
-        //Check if S is pressed - braking
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::S)){
-            input.set_brake(1.0); //S - full brake
-        } else {
-            input.set_brake(0.0);
-        }
-        //Check if "C" is pressed - this is to charge the battery. This can only be done when vehicle is stationary
-        if (sf::Keyboard::isKeyPressed(sf::Keyboard::C)){
-            charger.startCharging(battery, deltaTime);
+        //Handle driver inputs (the physics thread uses them from its next step on)
+        {
+            PROFILE_SCOPE("input");
+            float throttle = sf::Keyboard::isKeyPressed(sf::Keyboard::W) ? 1.0 : 0.0; //W represents full throttle
+            float brake = sf::Keyboard::isKeyPressed(sf::Keyboard::S) ? 1.0 : 0.0; //S - full brake
+            //Check if "C" is pressed - this is to charge the battery. This can only be done when vehicle is stationary
+            bool charging = sf::Keyboard::isKeyPressed(sf::Keyboard::C);
+            physics.setInput(throttle, brake, charging);
         }
 
-        //Update vehicle speed and battery temperature
-        vehicleSpeed = motor.updateSpeed(input, myEV ,battery, deltaTime);
-        batteryTemp = battery.updateTemperature(deltaTime, ambientTemp);
+        //Vehicle state from the physics thread, blended between its last two steps so motion stays smooth
+        //when the frame rate and the 120 Hz physics rate do not line up
+        VehicleSnapshot snapshot = physics.interpolated(frameStart);
+        float vehicleSpeed = snapshot.speed;
 
-        //Move the road upwards based on the speed(to simulate driving)
-        roadYPosition += vehicleSpeed * deltaTime * 5;
-        if (roadYPosition >= window.getSize().y){
-            roadYPosition = 0;
-        }
+        //Move the road with the distance driven (5 px per m, to simulate driving)
+        roadYPosition = static_cast<float>(fmod(snapshot.distance * 5, window.getSize().y));
 
         //Set positions of road textures based on changed Y position
         roadSprite1.setPosition(0, roadYPosition);
         roadSprite2.setPosition(0, roadYPosition - window.getSize().y);
         roadSprite3.setPosition(0, roadYPosition - 2 * window.getSize().y);
 
-        //Battery status alert 
-        sf::Text alertText;
-        alertText.setFont(font);
-        alertText.setCharacterSize(50);
-        alertText.setFillColor(sf::Color::Red);
-        alertText.setStyle(sf::Text::Bold);
-        alertText.setPosition(80, 300);
-
-        //SOC text
-        sf::Text socText;
-        socText.setFont(font);
-        socText.setString("Battery SOC: " + to_string(static_cast<int>(battery.get_SOC())) + "%");
-        socText.setCharacterSize(30);
-        socText.setFillColor(sf::Color::Black); 
-        socText.setPosition(80, 400); 
-
-        //Speed
-        sf::Text speedText;
-        speedText.setFont(font);
-        speedText.setString("Speed: " + to_string(static_cast<int>(vehicleSpeed)) + " m/s");
-        speedText.setCharacterSize(30);
-        speedText.setFillColor(sf::Color::Black);
-        speedText.setPosition(80, 450);
-
-        //Battery Temperature
-        sf::Text tempText;
-        tempText.setFont(font);
-        //State the battery temperature, and convert it to an int from float, using static cast
-        tempText.setString("Battery Temperature: " + to_string(static_cast<int>(battery.get_temp())) + " C");
-        tempText.setCharacterSize(30);
-        tempText.setFillColor(sf::Color::Black);
-        tempText.setPosition(80, 500);
-
-        //Clear window and redraw
-        window.clear(sf::Color(0, 0, 0)); //Black
-        float soc = battery.get_SOC(); //Check State of charge to display alert
-        if (soc >= 100){
-            alertText.setString("Battery Full!");
-            
-        } else if(soc <= 20){
-            alertText.setString("Battery Low!");
-            
-        } else{
-            alertText.setString("");
+        {
+            PROFILE_SCOPE("hud");
+            int soc = static_cast<int>(snapshot.SOC);
+            if (soc != shownSOC){
+                socText.setString("Battery SOC: " + to_string(soc) + "%");
+                shownSOC = soc;
+            }
+            //Take a finished range table, and start the next one if the battery changed since the last build
+            if (rangeBuild.valid() && rangeBuild.wait_for(chrono::seconds(0)) == future_status::ready){
+                rangeOracle = rangeBuild.get();
+            }
+            if (rangeStale && !rangeBuild.valid()){
+                rangeBuild = async(launch::async, [battery = rangeBattery, ambientTemp = physics.get_ambientTemp()](){
+                    RangeOracle oracle;
+                    oracle.build(battery, ambientTemp);
+                    return oracle;
+                });
+                rangeStale = false;
+            }
+            //Range cruising at the current speed from the current SOC and battery temperature (-1 until the first table is ready)
+            int range = rangeOracle.is_built() ? static_cast<int>(rangeOracle.range(snapshot.speed, snapshot.SOC, snapshot.batteryTemp) / 1000) : -1;
+            if (range != shownRange){
+                rangeText.setString("Range: " + (range < 0 ? string("--") : to_string(range)) + " km");
+                shownRange = range;
+            }
+            int speed = static_cast<int>(vehicleSpeed);
+            if (speed != shownSpeed){
+                speedText.setString("Speed: " + to_string(speed) + " m/s");
+                shownSpeed = speed;
+            }
+            //State the battery temperature, and convert it to an int from float, using static cast
+            int temp = static_cast<int>(snapshot.batteryTemp);
+            if (temp != shownTemp){
+                tempText.setString("Battery Temperature: " + to_string(temp) + " C");
+                shownTemp = temp;
+            }
+            //Check State of charge to display alert: 0 none, 1 full, 2 low
+            int alert = snapshot.SOC >= 100 ? 1 : (snapshot.SOC <= 20 ? 2 : 0);
+            if (alert != shownAlert){
+                alertText.setString(alert == 1 ? "Battery Full!" : (alert == 2 ? "Battery Low!" : ""));
+                shownAlert = alert;
+            }
+            if (pacer.get_frames() % 30 == 0){
+                stringstream pacing;
+                pacing << fixed << setprecision(1) << frameRates[frameRateIndex] << " Hz" << (pacer.get_vsync() ? " vsync" : "")
+                       << "  p50 " << pacer.framePercentile(50) << " ms  p99 " << pacer.framePercentile(99)
+                       << " ms  missed " << pacer.get_missed();
+                pacingText.setString(pacing.str());
+            }
         }
 
-        if (evOn){ //Only draw sprites when EV is on
-        window.draw(roadSprite1);
-        window.draw(roadSprite2);
-        window.draw(roadSprite3);
-        window.draw(carSprite);
-        window.draw(socText);
-        window.draw(speedText);
-        window.draw(tempText);
-        window.draw(uiBoxSprite);
-        window.draw(alertText);
-        }
+        //Clear window and redraw
+        {
+            PROFILE_SCOPE("draw");
+            window.clear(sf::Color(0, 0, 0)); //Black
+
+            if (evOn){ //Only draw sprites when EV is on
+            window.draw(roadSprite1);
+            window.draw(roadSprite2);
+            window.draw(roadSprite3);
+            window.draw(carSprite);
+            window.draw(socText);
+            window.draw(rangeText);
+            window.draw(speedText);
+            window.draw(tempText);
+            window.draw(uiBoxSprite);
+            window.draw(alertText);
+            }
         
-        window.draw(button);
-        window.draw(buttonText);
+            window.draw(button);
+            window.draw(buttonText);
+            window.draw(pacingText);
+            if (profiler.is_recording()){
+                drawProfilerOverlay(window, font);
+            }
+        }
         
         mouseWasPressed = mousePressed; //Use this to make sure that the button doesnt react to mouse being held, by updating the state at the end to indicate previous activity for the next run
-        window.display(); //Display everything on the window
+        {
+            PROFILE_SCOPE("display");
+            window.display(); //Display everything on the window
+        }
+
+        //Wait for the next frame's deadline
+        {
+            PROFILE_SCOPE("wait");
+            frameStart = pacer.wait();
+        }
+        profiler.endFrame();
 
-        //Delay for smoother movement
-        std::this_thread::sleep_for(std::chrono::milliseconds(16)); //~60 FPS
+    }
 
+    if (profiler.is_recording()){
+        profiler.stop();
+        if (profiler.writeChromeTrace("profile.json")){
+            cout << "Profile written to profile.json\n";
+        }
     }
 
+    physics.stop(); //No more records after this
+    cout << "Frames: " << pacer.get_frames() << ", p50 " << pacer.framePercentile(50) << " ms, p99 "
+         << pacer.framePercentile(99) << " ms, " << pacer.get_missed() << " missed deadlines, "
+         << physics.get_droppedSteps() << " physics steps dropped\n";
     logFile.close();
+    AsyncTelemetryStats logStats = logFile.get_stats();
+    cout << "Telemetry: " << logStats.written << " records logged (" << logStats.rowsKept << " rows kept), " << logStats.dropped << " dropped, buffer high-water mark "
+         << logStats.highWaterMark << ", max writer lag " << logStats.maxLagSeconds * 1000 << " ms\n";
+    convertTelemetryToCsv("output.evtl", "output.csv"); //graph.py and averageSpeed read the CSV
     averageSpeed(100, 1); //100 every samples for every two seconds. If there isn't enought data to satisfy this, the function will use the data that does exist, so less samples than asked for essentially
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,178 @@
+#include <iostream>
+#include <chrono>
+#include "../headers/physics_thread.h"
+#include "../headers/async_telemetry.h"
+#include "../headers/profiler.h"
+using namespace std;
+
+const int FRESH = 4; //Flag bit next to the slot index (0 to 2) in SnapshotBuffer::middle
+const int MAX_SUBSTEPS = 8; //Steps per wake-up at most; wall time beyond that is dropped
+
+SnapshotBuffer::SnapshotBuffer(){
+    for (Slot &slot : slots){
+        slot.snapshot = VehicleSnapshot{0, 0, 0, 0, 1, 0, 0, false, 0, 0, 0, 0, 0, 0, chrono::steady_clock::now()};
+    }
+    back = 0;
+    middle = 1;
+    front = 2;
+}
+
+//@brief make a snapshot the latest one (writer thread only)
+void SnapshotBuffer::publish(const VehicleSnapshot &snapshot){
+    slots[back].snapshot = snapshot;
+    //Release: the snapshot is written before the reader can take the slot
+    back = middle.exchange(back | FRESH, memory_order_acq_rel) & ~FRESH;
+}
+
+//@brief the latest published snapshot (reader thread only). The reference stays valid until the next call.
+const VehicleSnapshot& SnapshotBuffer::latest(){
+    if (middle.load(memory_order_relaxed) & FRESH){
+        //Acquire: the writer finished the snapshot before it marked the slot fresh
+        front = middle.exchange(front, memory_order_acq_rel) & ~FRESH;
+    }
+    return slots[front].snapshot;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+PhysicsThread::PhysicsThread(float ambientTemp) : sim(ambientTemp){
+    this->ambientTemp = ambientTemp;
+    delta_t = 1.0f / 120;
+    steps = 0;
+    distance = 0;
+    droppedSteps = 0;
+    log = nullptr;
+    running = false;
+    throttle = 0;
+    brake = 0;
+    charging = false;
+    configPending = false;
+}
+
+PhysicsThread::~PhysicsThread(){
+    stop();
+}
+
+void PhysicsThread::start(float rateHz, AsyncTelemetryWriter* log){
+    stop();
+    delta_t = 1 / rateHz;
+    this->log = log;
+    Battery &battery = sim.get_battery();
+    publish(sim.get_speed(), battery.get_SOC(), battery.get_temp(), distance, chrono::steady_clock::now());
+    running = true;
+    worker = thread(&PhysicsThread::run, this);
+}
+
+void PhysicsThread::stop(){
+    running = false;
+    if (worker.joinable()){
+        worker.join();
+    }
+}
+
+//@brief set the driver input used from the next physics step on (window thread)
+void PhysicsThread::setInput(float throttle, float brake, bool charging){
+    this->throttle.store(throttle, memory_order_relaxed);
+    this->brake.store(brake, memory_order_relaxed);
+    this->charging.store(charging, memory_order_relaxed);
+}
+
+//@brief replace the vehicle components before the next physics step (window thread)
+void PhysicsThread::configure(const Motor &motor, const Battery &battery, const EV &vehicle){
+    lock_guard<mutex> guard(configLock);
+    pendingMotor = motor;
+    pendingBattery = battery;
+    pendingVehicle = vehicle;
+    configPending = true;
+}
+
+const VehicleSnapshot& PhysicsThread::latest(){
+    return snapshots.latest();
+}
+
+VehicleSnapshot PhysicsThread::interpolated(chrono::steady_clock::time_point now){
+    VehicleSnapshot snapshot = snapshots.latest();
+    float alpha = chrono::duration<float>(now - snapshot.stepTime).count() / delta_t;
+    alpha = alpha < 0 ? 0 : (alpha > 1 ? 1 : alpha);
+    snapshot.speed = snapshot.prevSpeed + (snapshot.speed - snapshot.prevSpeed) * alpha;
+    snapshot.SOC = snapshot.prevSOC + (snapshot.SOC - snapshot.prevSOC) * alpha;
+    snapshot.batteryTemp = snapshot.prevBatteryTemp + (snapshot.batteryTemp - snapshot.prevBatteryTemp) * alpha;
+    snapshot.distance = snapshot.prevDistance + (snapshot.distance - snapshot.prevDistance) * alpha;
+    return snapshot;
+}
+
+float PhysicsThread::get_dt(){
+    return delta_t;
+}
+
+float PhysicsThread::get_ambientTemp(){
+    return ambientTemp;
+}
+
+long long PhysicsThread::get_droppedSteps(){
+    return droppedSteps.load(memory_order_relaxed);
+}
+
+//@brief copy the simulation state into a snapshot for the window
+void PhysicsThread::publish(float prevSpeed, float prevSOC, float prevBatteryTemp, double prevDistance, chrono::steady_clock::time_point stepTime){
+    PROFILE_SCOPE("PhysicsThread::publish");
+    Battery &battery = sim.get_battery();
+    VehicleSnapshot snapshot = {sim.get_time(), sim.get_speed(), battery.get_SOC(), battery.get_temp(), battery.get_SOH(),
+                                sim.get_input().get_throttle(), sim.get_input().get_brake(),
+                                sim.get_charger().get_charging_state(), steps, distance,
+                                prevSpeed, prevSOC, prevBatteryTemp, prevDistance, stepTime};
+    snapshots.publish(snapshot);
+}
+
+//@brief the physics loop. Each wake-up adds the wall time since the last one to the accumulator and runs
+//as many whole delta_t steps as fit, then sleeps until the next step is due. If the thread falls far behind
+//(e.g. the process was paused) it drops the lost time instead of running a long burst of catch-up steps.
+void PhysicsThread::run(){
+    profiler.registerThread("physics"); //The steps and component scopes get their own track in the trace
+    auto period = chrono::duration_cast<chrono::steady_clock::duration>(chrono::duration<double>(delta_t));
+    auto last = chrono::steady_clock::now();
+    chrono::steady_clock::duration accumulator(0);
+    while (running.load(memory_order_relaxed)){
+        auto now = chrono::steady_clock::now();
+        accumulator += now - last;
+        last = now;
+
+        if (configPending.load(memory_order_acquire)){
+            lock_guard<mutex> guard(configLock);
+            sim.configure(pendingMotor, pendingBattery, pendingVehicle);
+            configPending = false;
+        }
+        sim.get_input().set_throttle(throttle.load(memory_order_relaxed));
+        sim.get_input().set_brake(brake.load(memory_order_relaxed));
+        bool charging = this->charging.load(memory_order_relaxed);
+
+        Battery &battery = sim.get_battery();
+        float prevSpeed = 0, prevSOC = 0, prevBatteryTemp = 0;
+        double prevDistance = distance;
+        int substeps = 0;
+        while (accumulator >= period && substeps < MAX_SUBSTEPS){
+            prevSpeed = sim.get_speed();
+            prevSOC = battery.get_SOC();
+            prevBatteryTemp = battery.get_temp();
+            prevDistance = distance;
+            sim.step(delta_t, charging);
+            steps++;
+            distance += sim.get_speed() * delta_t;
+            if (log != nullptr && log->is_open()){
+                log->log(TelemetryRecord{static_cast<float>(sim.get_time()), sim.get_speed(), battery.get_SOC(), battery.get_temp(),
+                                         sim.get_input().get_throttle(), sim.get_input().get_brake()});
+            }
+            accumulator -= period;
+            substeps++;
+        }
+        if (accumulator >= period){
+            droppedSteps.fetch_add(accumulator / period, memory_order_relaxed);
+            accumulator %= period;
+        }
+        if (substeps > 0){
+            publish(prevSpeed, prevSOC, prevBatteryTemp, prevDistance, now - accumulator); //The last step stands for now minus what is left over
+        }
+
+        this_thread::sleep_until(now + (period - accumulator));
+    }
+}
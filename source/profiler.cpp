@@ -0,0 +1,163 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include "../headers/profiler.h"
+using namespace std;
+
+Profiler profiler;
+atomic<bool> profilingEnabled(false);
+thread_local ProfileThread* profilingThread = nullptr;
+thread_local int profilingDepth = 0;
+
+int64_t steadyNs(chrono::steady_clock::time_point time){
+    return chrono::duration_cast<chrono::nanoseconds>(time.time_since_epoch()).count();
+}
+
+Profiler::Profiler(){
+    capacity = 0;
+    frameStart = chrono::steady_clock::now();
+    originNs = steadyNs(frameStart);
+}
+
+void Profiler::registerThread(const string &name){
+    lock_guard<mutex> guard(threadsLock);
+    ProfileThread* found = nullptr;
+    for (const unique_ptr<ProfileThread> &thread : threads){
+        if (thread->name == name){
+            found = thread.get();
+        }
+    }
+    if (found == nullptr){
+        threads.push_back(make_unique<ProfileThread>());
+        found = threads.back().get();
+        found->name = name;
+        found->id = static_cast<int>(threads.size());
+        found->next = 0;
+        found->count = 0;
+        if (capacity > 0){ //Registered while recording
+            found->events.assign(capacity, ProfileEvent{nullptr, 0, 0, 0});
+        }
+    }
+    profilingThread = found;
+    profilingDepth = 0;
+}
+
+void Profiler::start(size_t capacity, size_t frames){
+    registerThread("main");
+    {
+        lock_guard<mutex> guard(threadsLock);
+        this->capacity = capacity > 0 ? capacity : 1;
+        for (const unique_ptr<ProfileThread> &thread : threads){
+            lock_guard<mutex> threadGuard(thread->lock);
+            thread->events.assign(this->capacity, ProfileEvent{nullptr, 0, 0, 0});
+            thread->next = 0;
+            thread->count = 0;
+        }
+    }
+    frameTimes.reset(frames);
+    frameStart = chrono::steady_clock::now();
+    originNs = steadyNs(frameStart);
+    profilingDepth = 0;
+    profilingEnabled = true;
+}
+
+void Profiler::stop(){
+    profilingEnabled = false;
+}
+
+bool Profiler::is_recording(){
+    return profilingEnabled.load();
+}
+
+int64_t Profiler::now(){
+    return steadyNs(chrono::steady_clock::now()) - originNs.load(memory_order_relaxed);
+}
+
+void Profiler::record(ProfileThread &thread, const char* name, int64_t startNs, int64_t durationNs, int depth){
+    lock_guard<mutex> guard(thread.lock);
+    if (thread.events.empty()){
+        return;
+    }
+    thread.events[thread.next] = ProfileEvent{name, startNs, durationNs, depth};
+    thread.next = thread.next + 1 == thread.events.size() ? 0 : thread.next + 1;
+    if (thread.count < thread.events.size()){
+        thread.count++;
+    }
+}
+
+void ProfileScope::begin(const char* name){
+    this->name = name;
+    thread = profilingThread;
+    startNs = profiler.now();
+    profilingDepth++;
+}
+
+void ProfileScope::finish(){
+    profilingDepth--;
+    if (profilingEnabled.load(memory_order_relaxed)){ //Not if the profiler was stopped inside the scope
+        profiler.record(*thread, name, startNs, profiler.now() - startNs, profilingDepth);
+    }
+    name = nullptr;
+}
+
+void Profiler::beginFrame(){
+    if (!profilingEnabled.load(memory_order_relaxed) || profilingThread == nullptr){
+        return;
+    }
+    frameStart = chrono::steady_clock::now();
+    profilingDepth = 1; //Scopes inside the frame nest under it
+}
+
+void Profiler::endFrame(){
+    if (!profilingEnabled.load(memory_order_relaxed) || profilingThread == nullptr){
+        return;
+    }
+    int64_t startNs = steadyNs(frameStart) - originNs.load(memory_order_relaxed);
+    int64_t durationNs = now() - startNs;
+    record(*profilingThread, "frame", startNs, durationNs, 0);
+    profilingDepth = 0;
+
+    frameTimes.add(durationNs / 1e6f);
+}
+
+size_t Profiler::recentFrames(){
+    return frameTimes.size();
+}
+
+void Profiler::frameHistogram(vector<int> &bins, float binMs){
+    frameTimes.histogram(bins, binMs);
+}
+
+float Profiler::framePercentile(float percentile){
+    return frameTimes.percentile(percentile);
+}
+
+bool Profiler::writeChromeTrace(const string &path){
+    ofstream file(path);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+    //A name for each thread's track, then complete ("X") events with microsecond timestamps, oldest first
+    file << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    file.setf(ios::fixed);
+    file.precision(3);
+    bool first = true;
+    lock_guard<mutex> guard(threadsLock);
+    for (const unique_ptr<ProfileThread> &thread : threads){
+        lock_guard<mutex> threadGuard(thread->lock);
+        file << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": " << thread->id
+             << ", \"args\": {\"name\": \"" << thread->name << "\"}}";
+        first = false;
+        size_t oldest = thread->count < thread->events.size() ? 0 : thread->next;
+        for (size_t i = 0; i < thread->count; i++){
+            const ProfileEvent &event = thread->events[(oldest + i) % thread->events.size()];
+            file << ",\n{\"name\": \"" << event.name << "\", \"cat\": \"" << (strcmp(event.name, "frame") == 0 ? "frame" : "scope")
+                 << "\", \"ph\": \"X\", \"ts\": " << event.startNs / 1000.0 << ", \"dur\": " << event.durationNs / 1000.0
+                 << ", \"pid\": 1, \"tid\": " << thread->id << "}";
+        }
+    }
+    file << "\n]}\n";
+    return true;
+}
@@ -0,0 +1,212 @@
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include "../headers/range_oracle.h"
+using namespace std;
+
+RangeOracle::RangeOracle(){
+    setAxis(speedAxes[0], 0, 1, 2);
+    setAxis(speedAxes[1], 0, 1, 2);
+    setAxis(socAxis, 0, 1, 2);
+    for (int segment = 0; segment < 5; segment++){
+        setAxis(tempAxes[segment], 0, 1, 2);
+        firstColumn[segment] = 0;
+    }
+}
+
+void RangeOracle::setAxis(Axis &axis, float first, float last, int count){
+    axis.first = first;
+    axis.step = (last - first) / (count - 1);
+    axis.inverseStep = 1 / axis.step;
+    axis.count = count;
+}
+
+float simulateRange(Battery &battery, float SOC, float batteryTemp, float speed, float ambientTemp, float dt){
+    double Q = SOC / 100.0 * battery.get_Q_max();
+    double temperature = batteryTemp;
+    double distance = 0;
+    if (speed <= 0){
+        return 0;
+    }
+    //Steps of at most dt, and never more than 1/400 of the charge the battery starts with, so slow cruises
+    //are not stepped second by second for hours
+    double step = Q / (battery.dischargeRate(speed, batteryTemp) * 400);
+    if (step > dt){
+        step = dt;
+    }
+    while (Q > 0){
+        float drain = battery.dischargeRate(speed, static_cast<float>(temperature));
+        if (drain <= 0){
+            break;
+        }
+        double h = step;
+        if (drain * h >= Q){
+            h = Q / drain; //Runs empty within this step
+        }
+        Q -= drain * h;
+        //The current is the instantaneous discharge current, as in the adaptive integrator
+        temperature += battery.heatBalance(static_cast<float>(temperature), -drain, ambientTemp) * h;
+        distance += speed * h;
+    }
+    return static_cast<float>(distance);
+}
+
+void RangeOracle::build(const Battery &battery, float ambientTemp){
+    Battery model(battery);
+    const float slowSpeed = 10; //m/s, end of the fine speed segment
+    setAxis(speedAxes[0], RANGE_MIN_SPEED, slowSpeed, SLOW_POINTS);
+    setAxis(speedAxes[1], slowSpeed, RANGE_MAX_SPEED, FAST_POINTS);
+    setAxis(socAxis, 0, 100, SOC_POINTS);
+    const float fineSpan = 2; //C next to a step covered by the fine segments
+    setAxis(tempAxes[0], -20, COLD_DISCHARGE_LIMIT - fineSpan, COARSE_POINTS);
+    setAxis(tempAxes[1], COLD_DISCHARGE_LIMIT - fineSpan, COLD_DISCHARGE_LIMIT, FINE_POINTS);
+    setAxis(tempAxes[2], COLD_DISCHARGE_LIMIT, HOT_DISCHARGE_LIMIT, MILD_POINTS);
+    setAxis(tempAxes[3], HOT_DISCHARGE_LIMIT, HOT_DISCHARGE_LIMIT + fineSpan, FINE_POINTS);
+    setAxis(tempAxes[4], HOT_DISCHARGE_LIMIT + fineSpan, 60, COARSE_POINTS);
+    for (int segment = 0, column = 0; segment < 5; segment++){
+        firstColumn[segment] = column;
+        column += tempAxes[segment].count;
+    }
+    const float inside = 0.01; //How far inside its tier an end point at a step is simulated (C)
+
+    table.assign(SPEED_POINTS * SOC_POINTS * TEMP_POINTS, 0);
+    size_t index = 0;
+    for (int v = 0; v < SPEED_POINTS; v++){
+        const Axis &speedAxis = speedAxes[v < SLOW_POINTS ? 0 : 1];
+        float speed = speedAxis.first + (v < SLOW_POINTS ? v : v - SLOW_POINTS) * speedAxis.step;
+        for (int s = 0; s < SOC_POINTS; s++){
+            for (int segment = 0; segment < 5; segment++){
+                const Axis &axis = tempAxes[segment];
+                for (int t = 0; t < axis.count; t++){
+                    float temperature = axis.first + t * axis.step;
+                    if (segment == 1 && t == axis.count - 1){
+                        temperature = COLD_DISCHARGE_LIMIT - inside;
+                    } else if (segment == 3 && t == 0){
+                        temperature = HOT_DISCHARGE_LIMIT + inside;
+                    }
+                    table[index++] = simulateRange(model, socAxis.first + s * socAxis.step, temperature, speed, ambientTemp, 60);
+                }
+            }
+        }
+    }
+}
+
+float RangeOracle::range(float speed, float SOC, float batteryTemp) const{
+    if (table.empty()){
+        return 0;
+    }
+    //Temperature segment, with the tier boundaries of the discharge rate (below 0 C, above 40 C)
+    int segment;
+    if (batteryTemp < COLD_DISCHARGE_LIMIT){
+        segment = batteryTemp < tempAxes[1].first ? 0 : 1;
+    } else if (batteryTemp > HOT_DISCHARGE_LIMIT){
+        segment = batteryTemp < tempAxes[4].first ? 3 : 4;
+    } else{
+        segment = 2;
+    }
+    int column = firstColumn[segment];
+    int slow = speed < speedAxes[1].first ? 1 : 0;
+    int firstSpeed = slow ? 0 : SLOW_POINTS; //Speed point where the segment starts
+
+    //Cell and position inside it on each axis
+    const Axis* axes[3] = {&speedAxes[1 - slow], &socAxis, &tempAxes[segment]};
+    const float values[3] = {speed, SOC, batteryTemp};
+    int cell[3];
+    float fraction[3];
+    for (int a = 0; a < 3; a++){
+        const Axis &axis = *axes[a];
+        float t = (values[a] - axis.first) * axis.inverseStep;
+        float last = static_cast<float>(axis.count - 1);
+        t = t > 0 ? t : 0;
+        t = t < last ? t : last;
+        int i = static_cast<int>(t);
+        i = i < axis.count - 2 ? i : axis.count - 2;
+        cell[a] = i;
+        fraction[a] = t - i;
+    }
+
+    //Interpolate along the temperature in the four rows of the cell, then along SOC, then along the speed
+    float atSpeed[2];
+    for (int v = 0; v < 2; v++){
+        const float* low = &table[((firstSpeed + cell[0] + v) * SOC_POINTS + cell[1]) * TEMP_POINTS + column + cell[2]];
+        const float* high = low + TEMP_POINTS;
+        float lowRange = low[0] + (low[1] - low[0]) * fraction[2];
+        float highRange = high[0] + (high[1] - high[0]) * fraction[2];
+        atSpeed[v] = lowRange + (highRange - lowRange) * fraction[1];
+    }
+    return atSpeed[0] + (atSpeed[1] - atSpeed[0]) * fraction[0];
+}
+
+bool RangeOracle::is_built() const{
+    return !table.empty();
+}
+
+size_t RangeOracle::bytes() const{
+    return table.size() * sizeof(float);
+}
+
+//@brief build the oracle for the default vehicle, time queries and compare them with simulateRange at
+//random points between the grid points
+//@return 0 if the error is within RANGE_MEAN_TOLERANCE and RANGE_MAX_TOLERANCE, 1 otherwise
+int runRangeOracleCheck(){
+    Battery battery;
+    const float ambientTemp = 25;
+    RangeOracle oracle;
+    auto start = chrono::steady_clock::now();
+    oracle.build(battery, ambientTemp);
+    double buildSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    //Query points from a fixed LCG so runs are comparable
+    const int queries = 1000000;
+    unsigned long long state = 1;
+    auto uniform = [&state](){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return static_cast<float>((state >> 40) * (1.0 / 16777216.0));
+    };
+    vector<float> points(3 * queries);
+    for (int q = 0; q < queries; q++){
+        points[3 * q] = RANGE_MIN_SPEED + (RANGE_MAX_SPEED - RANGE_MIN_SPEED) * uniform();
+        points[3 * q + 1] = 5 + 95 * uniform();
+        points[3 * q + 2] = -20 + 80 * uniform();
+    }
+    float sink = 0;
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < queries; q++){
+        sink += oracle.range(points[3 * q], points[3 * q + 1], points[3 * q + 2]);
+    }
+    double querySeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    //Error against simulating the same points with 10x finer steps than the build
+    const int checks = 2000;
+    double error = 0, maxError = 0;
+    const float* worst = &points[0];
+    start = chrono::steady_clock::now();
+    for (int q = 0; q < checks; q++){
+        const float* p = &points[3 * q];
+        float exact = simulateRange(battery, p[1], p[2], p[0], ambientTemp, 6);
+        double relative = fabs(oracle.range(p[0], p[1], p[2]) - exact) / exact;
+        error += relative;
+        if (relative > maxError){
+            maxError = relative;
+            worst = p;
+        }
+    }
+    double simulateSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    error /= checks;
+
+    cout << "Range oracle: " << RangeOracle::SPEED_POINTS << " speeds (finer below 10 m/s) x " << RangeOracle::SOC_POINTS << " SOC x "
+         << RangeOracle::TEMP_POINTS << " temperature points (in segments that end at the discharge steps at "
+         << COLD_DISCHARGE_LIMIT << " and " << HOT_DISCHARGE_LIMIT << " C), " << oracle.bytes() / 1024.0 << " KiB\n";
+    cout << "Build: " << buildSeconds * 1000 << " ms\n";
+    cout << "Query: " << querySeconds / queries * 1e9 << " ns (checksum " << sink << ")\n";
+    cout << "Simulating one query: " << simulateSeconds / checks * 1e6 << " us\n";
+    cout << "Error against simulation at " << checks << " random points (" << RANGE_MIN_SPEED << " to " << RANGE_MAX_SPEED
+         << " m/s): " << error * 100 << "% on average, " << maxError * 100 << "% at most (at " << worst[0] << " m/s, SOC "
+         << worst[1] << "%, " << worst[2] << " C)\n";
+    if (error > RANGE_MEAN_TOLERANCE || maxError > RANGE_MAX_TOLERANCE){
+        cout << "FAILED: above the tolerance of " << RANGE_MEAN_TOLERANCE * 100 << "% on average and "
+             << RANGE_MAX_TOLERANCE * 100 << "% at most\n";
+        return 1;
+    }
+    return 0;
+}
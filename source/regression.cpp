@@ -0,0 +1,497 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <map>
+#include <algorithm>
+#include "../headers/regression.h"
+#include "../headers/simulation.h"
+#include "../headers/fleet.h"
+#include "../headers/vehicle_model.h"
+#include "../headers/thread_pool.h"
+#include "../headers/route.h"
+using namespace std;
+
+//Tolerances well above the rounding differences between compilers and well below the effect of changing
+//any physics constant by a percent
+const ChannelTolerance traceTolerances[TRACE_CHANNELS] = {
+    {"Speed", 1e-3f, 1e-4f}, //m/s
+    {"SOC", 1e-3f, 1e-5f}, //%
+    {"BatteryTemp", 1e-3f, 1e-5f}, //C
+    {"SOH", 1e-5f, 1e-5f},
+    {"Current", 1e-3f, 1e-4f} //A
+};
+
+size_t ScenarioTrace::size() const{
+    return rows.size() / (TRACE_CHANNELS + 1);
+}
+
+RegressionOptions::RegressionOptions(){
+    goldenPath = "assets/golden_traces.csv";
+    filter = "";
+    threads = 1;
+    dt = 0.016;
+    update = false;
+}
+
+//@brief add a scenario to the library, named after its kind and parameters
+void addScenario(vector<Scenario> &library, ScenarioKind kind, const string &parameters, float ambientTemp, float startSOC,
+                 float startTemp, float intensity, float duration, float traceInterval){
+    static const char* kindNames[] = {"drive", "brake", "charge", "soak", "cycle"};
+    ostringstream name;
+    name << kindNames[kind] << "/ambient" << ambientTemp << "/" << parameters;
+    library.push_back({name.str(), kind, ambientTemp, startSOC, startTemp, intensity, duration, traceInterval});
+}
+
+vector<Scenario> regressionScenarios(){
+    vector<Scenario> library;
+    const float ambients[] = {-10, 0, 10, 25, 40};
+    const float SOCs[] = {100, 50, 15};
+    for (float ambient : ambients){
+        for (float SOC : SOCs){
+            for (float throttle : {0.25f, 0.5f, 0.75f, 1.0f}){
+                ostringstream parameters;
+                parameters << "soc" << SOC << "/throttle" << throttle;
+                addScenario(library, SCENARIO_DRIVE, parameters.str(), ambient, SOC, ambient, throttle, 120, 4);
+            }
+            for (float brake : {0.25f, 0.5f, 1.0f}){
+                ostringstream parameters;
+                parameters << "soc" << SOC << "/brake" << brake;
+                addScenario(library, SCENARIO_BRAKE, parameters.str(), ambient, SOC, ambient, brake, 60, 2);
+            }
+        }
+        for (float SOC : {5.0f, 25.0f, 50.0f, 75.0f, 95.0f}){
+            for (float startTemp : {ambient, 45.0f}){
+                ostringstream parameters;
+                parameters << "soc" << SOC << "/temp" << startTemp;
+                addScenario(library, SCENARIO_CHARGE, parameters.str(), ambient, SOC, startTemp, 1, 1200, 40);
+            }
+        }
+        for (float capacity : {50.0f, 150.0f}){
+            ostringstream parameters;
+            parameters << "capacity" << capacity;
+            addScenario(library, SCENARIO_CYCLE, parameters.str(), ambient, 100, ambient, capacity, 3600, 45);
+        }
+    }
+    for (float ambient : {-20.0f, -10.0f, 0.0f, 10.0f, 25.0f, 40.0f, 50.0f}){
+        for (float startTemp : {-10.0f, 25.0f, 45.0f}){
+            for (int charging = 0; charging < 2; charging++){
+                ostringstream parameters;
+                parameters << "temp" << startTemp << (charging ? "/charging" : "/parked");
+                addScenario(library, SCENARIO_SOAK, parameters.str(), ambient, 50, startTemp, static_cast<float>(charging), 3600, 120);
+            }
+        }
+        //Parked for 4 h: long enough for the temperature to settle where a frame's change rounds away
+        for (float startTemp : {-10.0f, 45.0f}){
+            ostringstream parameters;
+            parameters << "temp" << startTemp << "/4h";
+            addScenario(library, SCENARIO_SOAK, parameters.str(), ambient, 50, startTemp, 0, 4 * 3600, 600);
+        }
+    }
+    return library;
+}
+
+const char* const scenarioModelNames[SCENARIO_MODELS] = {"simulation", "fleet (SIMD lane)", "fleet (scalar tail)", "static model", "fast-forward"};
+
+//Fleet size for the fleet models: one full batch of the widest kernels (8 AVX2 lanes) and one vehicle in the tail
+const int SCENARIO_FLEET_SIZE = 9;
+
+//@brief set the driver input of a scenario at a time (charging carries the scripted driver's state between steps)
+void scenarioInput(const Scenario &scenario, float time, float SOC, DriverInput &input, bool &charging){
+    switch (scenario.kind){
+        case SCENARIO_DRIVE:
+            input.set_throttle(scenario.intensity);
+            input.set_brake(0.0);
+            break;
+        case SCENARIO_BRAKE: //Accelerate for the first third, then brake
+            input.set_throttle(time < scenario.duration / 3 ? 1.0 : 0.0);
+            input.set_brake(time < scenario.duration / 3 ? 0.0 : scenario.intensity);
+            break;
+        case SCENARIO_CHARGE:
+        case SCENARIO_SOAK:
+            input.set_throttle(0.0);
+            input.set_brake(1.0);
+            charging = scenario.kind == SCENARIO_CHARGE || scenario.intensity > 0;
+            break;
+        case SCENARIO_CYCLE:
+            scriptedDriver(time, SOC, input, charging);
+            break;
+    }
+}
+
+//@brief a Simulation in the starting state of a scenario
+Simulation scenarioStart(const Scenario &scenario){
+    Simulation sim(scenario.ambientTemp);
+    Battery &battery = sim.get_battery();
+    if (scenario.kind == SCENARIO_CYCLE){
+        battery.set_Q_max(scenario.intensity);
+    }
+    battery.set_Q_current(battery.get_Q_max() * scenario.startSOC / 100);
+    battery.set_temp(scenario.startTemp);
+    return sim;
+}
+
+ScenarioTrace runScenario(const Scenario &scenario, float dt, ScenarioModel model){
+    Simulation sim = scenarioStart(scenario);
+    Battery &battery = sim.get_battery();
+    ScenarioTrace trace;
+    if ((model == MODEL_STATIC && battery.get_Q_max() != DefaultVehicleSpec::Q_max)
+        || (model == MODEL_FAST_FORWARD && (scenario.kind != SCENARIO_SOAK || scenario.intensity > 0))){
+        return trace;
+    }
+
+    //The fleet models trace one vehicle of a fleet of copies of the scenario vehicle
+    Fleet fleet;
+    fleet.configure(sim.get_motor(), battery, sim.get_vehicle());
+    int traced = model == MODEL_FLEET_SCALAR ? SCENARIO_FLEET_SIZE - 1 : 0;
+    if (model == MODEL_FLEET_SIMD || model == MODEL_FLEET_SCALAR){
+        for (int v = 0; v < SCENARIO_FLEET_SIZE; v++){
+            fleet.addVehicle(battery, sim.get_motor(), sim.get_vehicle());
+        }
+    }
+    StaticSimulation<DefaultVehicleSpec> staticSim(scenario.ambientTemp);
+    StaticBattery<DefaultVehicleSpec> &staticBattery = staticSim.get_battery();
+    staticBattery.set_Q_current(battery.get_Q_current());
+    staticBattery.set_temp(battery.get_temp());
+
+    long long steps = llround(scenario.duration / dt);
+    long long every = llround(scenario.traceInterval / dt);
+    if (every < 1){
+        every = 1;
+    }
+    double fleetTime = 0;
+    auto record = [&](){
+        float row[TRACE_CHANNELS + 1];
+        switch (model){
+            case MODEL_SIMULATION:
+            case MODEL_FAST_FORWARD:
+                row[0] = static_cast<float>(sim.get_time()); row[1] = sim.get_speed(); row[2] = battery.get_SOC();
+                row[3] = battery.get_temp(); row[4] = battery.get_SOH(); row[5] = battery.get_current();
+                break;
+            case MODEL_FLEET_SIMD:
+            case MODEL_FLEET_SCALAR:
+                row[0] = static_cast<float>(fleetTime); row[1] = fleet.speed[traced]; row[2] = fleet.get_SOC(traced);
+                row[3] = fleet.temperature[traced]; row[4] = fleet.stateOfHealth[traced]; row[5] = fleet.current[traced];
+                break;
+            case MODEL_STATIC:
+                row[0] = static_cast<float>(staticSim.get_time()); row[1] = staticSim.get_speed(); row[2] = staticBattery.get_SOC();
+                row[3] = staticBattery.get_temp(); row[4] = 1; row[5] = staticBattery.get_current();
+                break;
+        }
+        trace.rows.insert(trace.rows.end(), row, row + TRACE_CHANNELS + 1);
+    };
+
+    DriverInput input;
+    bool charging = false;
+    record();
+    if (model == MODEL_FAST_FORWARD){
+        for (long long row = 1; row <= steps / every; row++){
+            sim.park(every * static_cast<double>(dt), dt);
+            record();
+        }
+        return trace;
+    }
+    for (long long i = 1; i <= steps; i++){
+        float time = (i - 1) * dt;
+        switch (model){
+            case MODEL_SIMULATION:
+                scenarioInput(scenario, time, battery.get_SOC(), sim.get_input(), charging);
+                sim.stepWithWear(dt, charging);
+                break;
+            case MODEL_FLEET_SIMD:
+            case MODEL_FLEET_SCALAR: //The fleet wears its batteries itself
+                scenarioInput(scenario, time, fleet.get_SOC(traced), input, charging);
+                for (int v = 0; v < SCENARIO_FLEET_SIZE; v++){
+                    fleet.setInput(v, input.get_throttle(), input.get_brake());
+                    fleet.charging[v] = charging;
+                }
+                fleet.step(dt, scenario.ambientTemp);
+                fleetTime += dt;
+                break;
+            case MODEL_STATIC:
+                scenarioInput(scenario, time, staticBattery.get_SOC(), staticSim.get_input(), charging);
+                staticSim.step(dt, charging);
+                break;
+            case MODEL_FAST_FORWARD:
+                break;
+        }
+        if (i % every == 0){
+            record();
+        }
+    }
+    return trace;
+}
+
+//@brief compare one step of discharge, charge and updateTemperature with the rate the same state gives
+//@return the largest difference relative to the rate
+double rateMismatch(float speed, float temperature, float current, float ambientTemp){
+    const float dt = 1; //Long step, small charge: the step's change is large against the rounding of the state
+    double worst = 0;
+    auto compare = [&](double applied, double rate){
+        double difference = fabs(applied - rate) / (fabs(rate) + 1e-12);
+        worst = difference > worst ? difference : worst;
+    };
+
+    Battery battery;
+    battery.set_temp(temperature);
+    battery.set_Q_current(1);
+    battery.setCurrent(0);
+    battery.discharge(speed, dt);
+    compare((1.0 - battery.get_Q_current()) / dt, battery.dischargeRate(speed, temperature));
+
+    battery.set_Q_current(1);
+    bool full = false;
+    float V = Charger().chargingVoltage(battery);
+    battery.charge(V, dt, full);
+    compare((battery.get_Q_current() - 1.0) / dt, battery.chargeRate(V));
+
+    battery.set_temp(temperature);
+    battery.setCurrent(current);
+    compare((battery.updateTemperature(dt, ambientTemp) - temperature) / dt, battery.heatBalance(temperature, current, ambientTemp));
+    return worst;
+}
+
+bool checkBatteryRates(){
+    //Each side of the discharge steps with cooling towards 25 C. The Joule heating is far smaller than the cooling,
+    //so it is checked alone with the battery at the ambient temperature, at 0 C where the state rounds finest.
+    double worst = 0;
+    for (float speed : {1.0f, 30.0f, 100.0f}){
+        for (float temperature : {-10.0f, -0.5f, 0.0f, 20.0f, 40.0f, 40.5f, 50.0f}){
+            double mismatch = rateMismatch(speed, temperature, 0, 25);
+            worst = mismatch > worst ? mismatch : worst;
+        }
+        for (float current : {-80.0f, 500.0f}){
+            double mismatch = rateMismatch(speed, 0, current, 0);
+            worst = mismatch > worst ? mismatch : worst;
+        }
+    }
+    bool passed = worst <= 1e-3;
+    cout << "Battery rates: largest difference to a step " << worst * 100 << "% " << (passed ? "(ok)" : "(FAIL, above 0.1%)") << "\n";
+    return passed;
+}
+
+//@brief read the golden traces (rows of Scenario,Time,Speed,SOC,BatteryTemp,SOH,Current)
+//@return false if the file cannot be opened
+bool loadGoldenTraces(const string &path, map<string, ScenarioTrace> &golden){
+    ifstream file(path);
+    if (!file.is_open()){
+        return false;
+    }
+    string line;
+    getline(file, line); //Header
+    while (getline(file, line)){
+        size_t comma = line.find(',');
+        if (comma == string::npos){
+            continue;
+        }
+        float row[TRACE_CHANNELS + 1];
+        const char* p = line.c_str() + comma + 1;
+        int c = 0;
+        for (; c < TRACE_CHANNELS + 1; c++){
+            char* end;
+            row[c] = strtof(p, &end);
+            if (end == p){
+                break;
+            }
+            p = *end == ',' ? end + 1 : end;
+        }
+        if (c == TRACE_CHANNELS + 1){
+            vector<float> &rows = golden[line.substr(0, comma)].rows;
+            rows.insert(rows.end(), row, row + TRACE_CHANNELS + 1);
+        }
+    }
+    return true;
+}
+
+//@brief write the golden traces of the scenarios in library order (enough digits to read back every float exactly)
+bool writeGoldenTraces(const string &path, const vector<Scenario> &library, const map<string, ScenarioTrace> &golden){
+    ofstream file(path);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+    file << "Scenario,Time";
+    for (const ChannelTolerance &channel : traceTolerances){
+        file << "," << channel.name;
+    }
+    file << "\n" << setprecision(9);
+    for (const Scenario &scenario : library){
+        auto found = golden.find(scenario.name);
+        if (found == golden.end()){
+            continue;
+        }
+        const vector<float> &rows = found->second.rows;
+        for (size_t r = 0; r + TRACE_CHANNELS + 1 <= rows.size(); r += TRACE_CHANNELS + 1){
+            file << scenario.name;
+            for (int c = 0; c < TRACE_CHANNELS + 1; c++){
+                file << "," << rows[r + c];
+            }
+            file << "\n";
+        }
+    }
+    return true;
+}
+
+//How a trace differs from its golden trace
+struct TraceComparison{
+    bool passed;
+    size_t rows, goldenRows;
+    long long firstRow[TRACE_CHANNELS]; //First row out of tolerance, -1 if none
+    float maxDifference[TRACE_CHANNELS];
+};
+
+TraceComparison compareTraces(const ScenarioTrace &trace, const ScenarioTrace &golden, const ChannelTolerance* tolerances = traceTolerances){
+    TraceComparison result;
+    result.rows = trace.size();
+    result.goldenRows = golden.size();
+    result.passed = result.rows == result.goldenRows;
+    size_t common = result.rows < result.goldenRows ? result.rows : result.goldenRows;
+    for (int c = 0; c < TRACE_CHANNELS; c++){
+        result.firstRow[c] = -1;
+        result.maxDifference[c] = 0;
+        const ChannelTolerance &tolerance = tolerances[c];
+        for (size_t r = 0; r < common; r++){
+            float expected = golden.rows[r * (TRACE_CHANNELS + 1) + c + 1];
+            float actual = trace.rows[r * (TRACE_CHANNELS + 1) + c + 1];
+            float difference = fabs(actual - expected);
+            if (difference > result.maxDifference[c]){
+                result.maxDifference[c] = difference;
+            }
+            if (result.firstRow[c] < 0 && !(difference <= tolerance.absolute + tolerance.relative * fabs(expected))){
+                result.firstRow[c] = static_cast<long long>(r);
+                result.passed = false;
+            }
+        }
+    }
+    return result;
+}
+
+//@brief print where a trace left its golden trace (or a model's trace the Simulation trace), channel by channel
+void reportDivergence(const string &heading, const ScenarioTrace &trace, const ScenarioTrace &golden, const TraceComparison &result,
+                      const ChannelTolerance* tolerances = traceTolerances){
+    cout << heading << "\n";
+    if (result.rows != result.goldenRows){
+        cout << "    trace has " << result.rows << " rows, reference " << result.goldenRows << "\n";
+    }
+    for (int c = 0; c < TRACE_CHANNELS; c++){
+        if (result.firstRow[c] < 0){
+            continue;
+        }
+        size_t index = result.firstRow[c] * (TRACE_CHANNELS + 1);
+        float expected = golden.rows[index + c + 1];
+        const ChannelTolerance &tolerance = tolerances[c];
+        cout << "    " << tolerance.name << ": first off at t=" << golden.rows[index] << " s (expected " << expected
+             << ", got " << trace.rows[index + c + 1] << ", tolerance " << tolerance.absolute + tolerance.relative * fabs(expected)
+             << "), max difference " << result.maxDifference[c] << "\n";
+    }
+}
+
+int runRegression(const RegressionOptions &options){
+    vector<Scenario> library = regressionScenarios();
+    vector<Scenario> selected;
+    for (const Scenario &scenario : library){
+        if (scenario.name.find(options.filter) != string::npos){
+            selected.push_back(scenario);
+        }
+    }
+    map<string, ScenarioTrace> golden;
+    bool haveGolden = loadGoldenTraces(options.goldenPath, golden);
+    if (!haveGolden && !options.update){
+        cout << "Cannot open golden traces " << options.goldenPath << " (run with --update to create them)\n";
+        return 1;
+    }
+
+    //Every scenario is independent, so the pool simply deals them out; a task runs its scenario on every model
+    vector<ScenarioTrace> traces(selected.size());
+    vector<ScenarioTrace> modelTraces(selected.size() * SCENARIO_MODELS);
+    ThreadPool pool(options.threads);
+    auto start = chrono::steady_clock::now();
+    pool.run(static_cast<int>(selected.size()), [&](int task){
+        traces[task] = runScenario(selected[task], options.dt);
+        if (!options.update){
+            for (int m = MODEL_SIMULATION + 1; m < SCENARIO_MODELS; m++){
+                modelTraces[task * SCENARIO_MODELS + m] = runScenario(selected[task], options.dt, static_cast<ScenarioModel>(m));
+            }
+        }
+    });
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Ran " << selected.size() << " scenarios on " << options.threads << " threads in " << seconds << " s\n";
+
+    if (options.update){
+        for (size_t i = 0; i < selected.size(); i++){
+            golden[selected[i].name] = traces[i];
+        }
+        if (!writeGoldenTraces(options.goldenPath, library, golden)){
+            return 1;
+        }
+        cout << "Golden traces of " << selected.size() << " scenarios written to " << options.goldenPath << "\n";
+        return 0;
+    }
+
+    int passed = 0, failed = 0, missing = 0;
+    int channelFailures[TRACE_CHANNELS] = {};
+    for (size_t i = 0; i < selected.size(); i++){
+        auto found = golden.find(selected[i].name);
+        if (found == golden.end()){
+            cout << "NEW  " << selected[i].name << " (no golden trace)\n";
+            missing++;
+            continue;
+        }
+        TraceComparison result = compareTraces(traces[i], found->second);
+        if (result.passed){
+            passed++;
+            continue;
+        }
+        failed++;
+        reportDivergence("FAIL " + selected[i].name, traces[i], found->second, result);
+        for (int c = 0; c < TRACE_CHANNELS; c++){
+            channelFailures[c] += result.firstRow[c] >= 0;
+        }
+    }
+
+    //The copies of the equations must follow Simulation within the same tolerances (the static model and
+    //fast-forward do not wear the battery). Fast-forward does not round the temperature every frame, so its
+    //temperature gets the fast-forward tolerance.
+    ChannelTolerance fastForwardTolerances[TRACE_CHANNELS];
+    copy(traceTolerances, traceTolerances + TRACE_CHANNELS, fastForwardTolerances);
+    fastForwardTolerances[2].absolute = FAST_FORWARD_TEMP_TOLERANCE;
+    int modelRuns = 0, modelFailures = 0;
+    for (size_t i = 0; i < selected.size(); i++){
+        for (int m = MODEL_SIMULATION + 1; m < SCENARIO_MODELS; m++){
+            const ScenarioTrace &trace = modelTraces[i * SCENARIO_MODELS + m];
+            if (trace.rows.empty()){
+                continue;
+            }
+            modelRuns++;
+            const ChannelTolerance* tolerances = m == MODEL_FAST_FORWARD ? fastForwardTolerances : traceTolerances;
+            TraceComparison result = compareTraces(trace, traces[i], tolerances);
+            if ((m == MODEL_STATIC || m == MODEL_FAST_FORWARD) && result.firstRow[3] >= 0){
+                result.firstRow[3] = -1;
+                result.passed = result.rows == result.goldenRows;
+                for (int c = 0; c < TRACE_CHANNELS; c++){
+                    result.passed = result.passed && result.firstRow[c] < 0;
+                }
+            }
+            if (!result.passed){
+                modelFailures++;
+                reportDivergence("MODEL " + string(scenarioModelNames[m]) + " left Simulation in " + selected[i].name, trace, traces[i], result, tolerances);
+            }
+        }
+    }
+
+    cout << "Regression: " << passed << " passed, " << failed << " failed, " << missing << " without a golden trace\n";
+    cout << "Models: " << modelRuns - modelFailures << " of " << modelRuns << " fleet, static model and fast-forward runs follow Simulation\n";
+    bool modelChecks = checkBatteryRates();
+    modelChecks = checkRouteEnergy() && modelChecks;
+    if (failed > 0){
+        cout << "Scenarios out of tolerance per channel:";
+        for (int c = 0; c < TRACE_CHANNELS; c++){
+            cout << " " << traceTolerances[c].name << " " << channelFailures[c];
+        }
+        cout << "\n";
+    }
+    return failed > 0 || missing > 0 || modelFailures > 0 || !modelChecks ? 1 : 0;
+}
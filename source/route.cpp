@@ -0,0 +1,383 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include "../headers/route.h"
+using namespace std;
+
+RouteEstimator::RouteEstimator(float dt){
+    this->dt = dt;
+    hits = 0;
+    misses = 0;
+}
+
+bool RouteEstimator::SegmentKey::operator==(const SegmentKey &other) const{
+    return vehicle == other.vehicle && speedBucket == other.speedBucket && SOCBucket == other.SOCBucket
+        && tempBucket == other.tempBucket && memcmp(segment, other.segment, sizeof(segment)) == 0;
+}
+
+size_t RouteEstimator::SegmentKeyHash::operator()(const SegmentKey &key) const{
+    unsigned long long hash = 1469598103934665603ULL; //FNV-1a over the fields
+    uint32_t fields[8] = {static_cast<uint32_t>(key.vehicle), static_cast<uint32_t>(key.speedBucket), static_cast<uint32_t>(key.SOCBucket),
+                          static_cast<uint32_t>(key.tempBucket), key.segment[0], key.segment[1], key.segment[2], key.segment[3]};
+    for (uint32_t field : fields){
+        hash = (hash ^ field) * 1099511628211ULL;
+    }
+    return static_cast<size_t>(hash);
+}
+
+int RouteEstimator::addVehicle(const Motor &motor, const Battery &battery, const EV &body){
+    EV copy = body;
+    if (copy.get_mass() <= 0){
+        cout << "Route estimates need the vehicle's mass (EV::setMass); without it no energy is drawn\n";
+    }
+    vehicles.push_back({motor, battery, body});
+    return static_cast<int>(vehicles.size()) - 1;
+}
+
+//@brief drive one segment from a given state with a fresh copy of the vehicle. The wheels follow the motor's
+//torque balance slowed by the road load, and the battery supplies the power at the wheels: (road load + m*a) * v
+//through the motor's efficiency while driving, and gets back part of it through regen while braking.
+RouteEstimator::SegmentResult RouteEstimator::driveSegment(int vehicle, const RouteSegment &segment, float speed, float SOC, float batteryTemp){
+    Vehicle v = vehicles[vehicle];
+    Battery &battery = v.battery;
+    Motor &motor = v.motor;
+    EV &body = v.body;
+    DriverInput input;
+    float radius = body.get_wheelRadius();
+    float mass = body.get_mass();
+    float Q_max = battery.get_Q_max();
+
+    battery.set_Q_current(SOC / 100 * Q_max);
+    battery.set_temp(batteryTemp);
+    battery.setCurrent(0);
+    motor.set_speed(speed);
+    motor.set_angularSpeed(speed / radius);
+    float startQ = battery.get_Q_current();
+
+    //Speed-holding driver, the same proportional control as DriveCycle::apply for speed traces
+    const float gain = 0.5;
+    const float deadband = 0.2;
+    double distance = 0;
+    double time = 0;
+    double timeLimit = segment.length / 0.5 + 600; //Gives up on a segment the vehicle cannot climb
+    while (distance < segment.length && time < timeLimit){
+        float error = segment.speedLimit - speed;
+        if (error > -deadband){
+            input.set_throttle(error > 0 ? min(1.0f, gain * error) : 0.01f);
+            input.set_brake(0.0);
+        } else{
+            input.set_throttle(0.0);
+            input.set_brake(min(1.0f, -gain * error));
+        }
+
+        //Motor::updateSpeed, with the road load as a deceleration of the vehicle's mass on top
+        float roadLoad = body.roadLoadForce(speed, segment.grade);
+        float w = motor.get_angularSpeed() + motor.angularAcceleration(input) * dt;
+        if (mass > 0){
+            w -= roadLoad / mass / radius * dt;
+        }
+        w = w > 0 ? w : 0;
+        motor.set_angularSpeed(w);
+        float newSpeed = min(radius * w, motor.get_maxSpeed());
+        motor.set_speed(newSpeed);
+
+        //Power at the wheels: positive is drawn from the battery, negative is taken by the brakes, of which
+        //regen recovers its efficiency's share up to the motor's regen limit
+        float wheelPower = (roadLoad + mass * (newSpeed - speed) / dt) * newSpeed;
+        float current;
+        if (wheelPower >= 0){
+            current = -wheelPower / (motor.get_efficiency() * battery.get_voltage());
+        } else{
+            current = min(-wheelPower * motor.get_regenEfficiency(), motor.getMaxRegenPower()) / battery.get_voltage();
+        }
+        float Q = battery.get_Q_current() + current * dt / 3600;
+        battery.set_Q_current(Q < 0 ? 0 : (Q > Q_max ? Q_max : Q));
+        battery.setCurrent(current);
+        battery.updateTemperature(dt, segment.ambientTemp);
+
+        speed = newSpeed;
+        distance += speed * dt;
+        time += dt;
+    }
+    return {startQ - battery.get_Q_current(), static_cast<float>(time), speed, battery.get_temp() - batteryTemp};
+}
+
+RouteEstimate RouteEstimator::estimate(int vehicle, const vector<RouteSegment> &route, float SOC, float batteryTemp, bool useCache){
+    float Q_max = vehicles[vehicle].battery.get_Q_max();
+    float V_max = vehicles[vehicle].battery.get_V_max();
+    RouteEstimate estimate = {SOC, 0, 0, 0, 0, batteryTemp, 0};
+    for (const RouteSegment &segment : route){
+        SegmentResult result;
+        if (useCache){
+            SegmentKey key;
+            key.vehicle = vehicle;
+            key.speedBucket = static_cast<int>(lround(estimate.speed / SPEED_BUCKET));
+            key.SOCBucket = static_cast<int>(lround(estimate.SOC / SOC_BUCKET));
+            key.tempBucket = static_cast<int>(lround(estimate.batteryTemp / TEMP_BUCKET));
+            memcpy(key.segment, &segment, sizeof(key.segment));
+            auto found = cache.find(key);
+            if (found != cache.end()){
+                result = found->second;
+                hits++;
+                estimate.cachedSegments++;
+            } else{
+                result = driveSegment(vehicle, segment, key.speedBucket * SPEED_BUCKET, key.SOCBucket * SOC_BUCKET, key.tempBucket * TEMP_BUCKET);
+                cache.emplace(key, result);
+                misses++;
+            }
+        } else{
+            result = driveSegment(vehicle, segment, estimate.speed, estimate.SOC, estimate.batteryTemp);
+        }
+
+        estimate.chargeUsed += result.chargeUsed;
+        estimate.SOC -= result.chargeUsed / Q_max * 100;
+        if (estimate.SOC < 0){
+            estimate.SOC = 0;
+        } else if (estimate.SOC > 100){
+            estimate.SOC = 100;
+        }
+        estimate.time += result.time;
+        estimate.speed = result.exitSpeed;
+        estimate.batteryTemp += result.tempChange;
+    }
+    estimate.energyUsed = estimate.chargeUsed * V_max / 1000;
+    return estimate;
+}
+
+void RouteEstimator::clearCache(){
+    cache.clear();
+}
+
+size_t RouteEstimator::cacheSize(){
+    return cache.size();
+}
+
+long long RouteEstimator::get_hits(){
+    return hits;
+}
+
+long long RouteEstimator::get_misses(){
+    return misses;
+}
+
+bool loadRoutes(const string &path, vector<vector<RouteSegment>> &routes){
+    ifstream file(path);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+    routes.clear();
+    string line;
+    getline(file, line); //Header
+    string lastRoute;
+    int lineNumber = 1;
+    while (getline(file, line)){
+        lineNumber++;
+        if (line.empty() || line == "\r"){
+            continue;
+        }
+        for (char &c : line){
+            if (c == ','){
+                c = ' ';
+            }
+        }
+        stringstream fields(line);
+        string name;
+        RouteSegment segment;
+        if (!(fields >> name >> segment.length >> segment.grade >> segment.speedLimit >> segment.ambientTemp)
+            || segment.length <= 0 || segment.speedLimit <= 0){
+            cout << "Invalid segment on line " << lineNumber << " of " << path << "\n";
+            return false;
+        }
+        if (routes.empty() || name != lastRoute){
+            routes.emplace_back();
+            lastRoute = name;
+        }
+        routes.back().push_back(segment);
+    }
+    if (routes.empty()){
+        cout << "No routes in " << path << "\n";
+        return false;
+    }
+    return true;
+}
+
+bool checkRouteEnergy(){
+    //The mid-size car of the route benchmark
+    EV body;
+    body.setMass(1500);
+    body.setDragCoefficient(0.3);
+    body.setFrontalArea(2.2);
+    RouteEstimator estimator(0.1);
+    int vehicle = estimator.addVehicle(Motor(), Battery(), body);
+
+    //Charge used on 2 km of road, entered at the speed limit (a 500 m flat run-up brings the vehicle to it)
+    auto chargeOn = [&](float grade, float speedLimit){
+        RouteSegment runUp = {500, 0, speedLimit, 20};
+        RouteSegment road = {2000, grade, speedLimit, 20};
+        RouteEstimate before = estimator.estimate(vehicle, {runUp}, 80, 25, false);
+        RouteEstimate after = estimator.estimate(vehicle, {runUp, road}, 80, 25, false);
+        return after.chargeUsed - before.chargeUsed;
+    };
+
+    float flat = chargeOn(0, 20), climb = chargeOn(0.05f, 20), descent = chargeOn(-0.05f, 20);
+    cout << "Route energy over 2 km at 20 m/s: flat " << flat << " Ah, 5% climb " << climb << " Ah, 5% descent " << descent << " Ah\n";
+    bool ordered = climb > flat && flat > descent;
+    if (!ordered){
+        cout << "  FAILED: the charge used does not grow with the grade\n";
+    }
+    bool growing = true;
+    float previous = 0;
+    cout << "Route energy over 2 km on the flat:";
+    for (float speedLimit : {10.0f, 20.0f, 30.0f}){
+        float charge = chargeOn(0, speedLimit);
+        cout << (previous > 0 ? ", " : " ") << charge << " Ah at " << speedLimit << " m/s";
+        if (charge <= previous){
+            growing = false;
+        }
+        previous = charge;
+    }
+    cout << "\n";
+    if (!growing){
+        cout << "  FAILED: the charge used does not grow with the speed\n";
+    }
+    return ordered && growing;
+}
+
+//default benchmark: 10000 queries over 500 generated routes on a network of 300 road segments
+RouteQueryOptions::RouteQueryOptions(){
+    queries = 10000;
+    routes = 500;
+    roadSegments = 300;
+    checkQueries = 200;
+    dt = 0.1;
+    seed = 1;
+}
+
+//Deterministic generator for the generated road network and the queries (64-bit LCG)
+struct RouteRandom{
+    unsigned long long state;
+
+    double uniform(){
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 11) * (1.0 / 9007199254740992.0);
+    }
+    int below(int n){
+        return static_cast<int>(uniform() * n);
+    }
+};
+
+//@brief routes through a road network: each route drives a run of 5 to 40 consecutive road segments, so
+//routes overlap wherever their runs do
+void generateRoutes(const RouteQueryOptions &options, RouteRandom &random, vector<vector<RouteSegment>> &routes){
+    const float limits[4] = {8.3, 13.9, 22.2, 27.8}; //30, 50, 80 and 100 km/h
+    const float ambients[3] = {5, 15, 25};
+    vector<RouteSegment> road(options.roadSegments);
+    for (RouteSegment &segment : road){
+        segment.length = 100 * (2 + random.below(19)); //200 m to 2 km
+        segment.grade = 0.01f * (random.below(13) - 6); //-6% to +6%
+        segment.speedLimit = limits[random.below(4)];
+        segment.ambientTemp = ambients[random.below(3)];
+    }
+    routes.assign(options.routes, vector<RouteSegment>());
+    for (vector<RouteSegment> &route : routes){
+        int start = random.below(options.roadSegments);
+        int count = 5 + random.below(36);
+        for (int s = 0; s < count; s++){
+            route.push_back(road[(start + s) % options.roadSegments]);
+        }
+    }
+}
+
+//@brief value at a fraction of sorted data (nearest rank)
+double routePercentile(const vector<double> &sorted, double fraction){
+    size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5);
+    return sorted[index];
+}
+
+int runRouteQueries(const RouteQueryOptions &options){
+    RouteRandom random;
+    random.state = options.seed;
+    vector<vector<RouteSegment>> routes;
+    if (!options.routesPath.empty()){
+        if (!loadRoutes(options.routesPath, routes)){
+            return 1;
+        }
+    } else{
+        generateRoutes(options, random, routes);
+    }
+
+    //The default vehicle with the body of a mid-size car
+    EV body;
+    body.setMass(1500);
+    body.setDragCoefficient(0.3);
+    body.setFrontalArea(2.2);
+    RouteEstimator estimator(options.dt);
+    int vehicle = estimator.addVehicle(Motor(), Battery(), body);
+
+    //Each query drives a random route starting at a random SOC and battery temperature
+    vector<int> queryRoute(options.queries);
+    vector<float> querySOC(options.queries), queryTemp(options.queries);
+    for (int q = 0; q < options.queries; q++){
+        queryRoute[q] = random.below(static_cast<int>(routes.size()));
+        querySOC[q] = 40 + 60 * static_cast<float>(random.uniform());
+        queryTemp[q] = 15 + 15 * static_cast<float>(random.uniform());
+    }
+
+    vector<double> latency(options.queries);
+    vector<RouteEstimate> estimates(options.queries);
+    double totalSeconds = 0;
+    long long segments = 0;
+    for (int q = 0; q < options.queries; q++){
+        auto start = chrono::steady_clock::now();
+        estimates[q] = estimator.estimate(vehicle, routes[queryRoute[q]], querySOC[q], queryTemp[q]);
+        double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        latency[q] = seconds;
+        totalSeconds += seconds;
+        segments += routes[queryRoute[q]].size();
+    }
+
+    //The same queries without buckets or cache, to see what the buckets cost in accuracy
+    int checks = min(options.checkQueries, options.queries);
+    double SOCError = 0, maxSOCError = 0, timeError = 0;
+    double uncachedSeconds = 0;
+    for (int q = 0; q < checks; q++){
+        auto start = chrono::steady_clock::now();
+        RouteEstimate exact = estimator.estimate(vehicle, routes[queryRoute[q]], querySOC[q], queryTemp[q], false);
+        uncachedSeconds += chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        double error = fabs(exact.SOC - estimates[q].SOC);
+        SOCError += error;
+        maxSOCError = max(maxSOCError, error);
+        timeError += fabs(exact.time - estimates[q].time) / exact.time;
+    }
+
+    vector<double> sorted = latency;
+    sort(sorted.begin(), sorted.end());
+    double averageSOC = 0, averageEnergy = 0;
+    for (const RouteEstimate &estimate : estimates){
+        averageSOC += estimate.SOC;
+        averageEnergy += estimate.energyUsed;
+    }
+
+    cout << "Route queries: " << options.queries << " over " << routes.size() << " routes (" << segments << " segments), dt " << options.dt << " s\n";
+    cout << "Cache: " << estimator.get_hits() << " hits, " << estimator.get_misses() << " segments driven ("
+         << 100.0 * estimator.get_hits() / segments << "% hit rate), " << estimator.cacheSize() << " entries\n";
+    cout << "Query latency: p50 " << routePercentile(sorted, 0.5) * 1e6 << " us, p99 " << routePercentile(sorted, 0.99) * 1e6
+         << " us, max " << sorted.back() * 1e6 << " us, " << options.queries / totalSeconds << " queries per second\n";
+    //The second half of the queries, when the cache has filled up
+    vector<double> warm(latency.begin() + options.queries / 2, latency.end());
+    if (!warm.empty()){
+        sort(warm.begin(), warm.end());
+        cout << "Second half of the queries: p50 " << routePercentile(warm, 0.5) * 1e6 << " us, p99 " << routePercentile(warm, 0.99) * 1e6 << " us\n";
+    }
+    cout << "Average arrival SOC " << averageSOC / options.queries << "%, energy " << averageEnergy / options.queries << " kWh\n";
+    if (checks > 0){
+        cout << "Against uncached estimates (" << checks << " queries, " << uncachedSeconds / checks * 1e6 << " us each): SOC error "
+             << SOCError / checks << " points on average, " << maxSOCError << " at most; time error " << timeError / checks * 100 << "%\n";
+    }
+    return 0;
+}
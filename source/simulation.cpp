@@ -0,0 +1,575 @@
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cmath>
+#include "../headers/simulation.h"
+#include <cstring>
+#include "../headers/telemetry.h"
+#include "../headers/drive_cycle.h"
+#include "../headers/profiler.h"
+#include "../headers/snapshot.h"
+#include "../headers/battery_tables.h"
+using namespace std;
+
+//default constructor
+Simulation::Simulation(){
+    ambientTemp = 25; //Room temperature in Celsius
+    totalTime = 0;
+    vehicleSpeed = 0;
+}
+
+//constructor that lets the user choose the ambient temperature
+Simulation::Simulation(float ambientTemp){
+    this->ambientTemp = ambientTemp;
+    totalTime = 0;
+    vehicleSpeed = 0;
+}
+
+//@brief replace the components of the vehicle with new ones (start of a new "session")
+void Simulation::configure(const Motor &newMotor, const Battery &newBattery, const EV &newVehicle){
+    motor = newMotor;
+    battery = newBattery;
+    vehicle = newVehicle;
+}
+
+//@brief advance the vehicle by one time step. The driver input has to be set before calling this.
+//@param delta_t - length of the step in seconds, charging - true if the charger is plugged in for this step
+void Simulation::step(float delta_t, bool charging){
+    PROFILE_SCOPE("Simulation::step");
+    totalTime += delta_t;
+
+    //Charging can only be done when the driver asks for it (the "C" key in the window)
+    if (charging){
+        charger.startCharging(battery, delta_t);
+    }
+
+    //Update vehicle speed and battery temperature
+    vehicleSpeed = motor.updateSpeed(input, vehicle, battery, delta_t);
+    battery.updateTemperature(delta_t, ambientTemp);
+}
+
+float Simulation::stepWithWear(float delta_t, bool charging){
+    float before = battery.get_Q_current();
+    step(delta_t, charging);
+    float drawn = before - battery.get_Q_current();
+    battery.wear(drawn, delta_t);
+    return drawn;
+}
+
+//@brief true if the vehicle stands still and will keep standing still: the wheels are stopped and the
+//throttle is released (so the brake or the passive drag holds them). While idle, a step only charges
+//the battery and moves its temperature, and both have closed forms.
+bool Simulation::isIdle(){
+    return input.get_throttle() <= 0 && motor.get_angularSpeed() <= 0 && vehicleSpeed <= 0;
+}
+
+//@brief step normally until the vehicle is idle (the coast-down or braking before a stop)
+//@return number of steps taken
+long long Simulation::stepUntilIdle(long long maxSteps, float delta_t, bool charging){
+    long long steps = 0;
+    while (steps < maxSteps && !isIdle()){
+        step(delta_t, charging);
+        steps++;
+    }
+    return steps;
+}
+
+//@brief the result of steps calls to step(delta_t, charging) on an idle vehicle, in O(1).
+//The battery current does not change while idle (nothing discharges it) until the charger finds the
+//battery full and sets it to 0, so the temperature relaxes with one current before that and another after.
+void Simulation::skipIdleSteps(long long steps, float delta_t, bool charging){
+    if (steps <= 0){
+        return;
+    }
+    if (battery.get_tables() != nullptr){
+        //The closed forms assume the fixed model (constant resistance and charging rate), so curves are stepped
+        for (long long i = 0; i < steps; i++){
+            step(delta_t, charging);
+        }
+        return;
+    }
+    long long remaining = steps;
+    if (charging){
+        //Steps that add charge: every step until Q_now reaches Q_max
+        float voltage = charger.chargingVoltage(battery);
+        double perStep = battery.chargeRate(voltage) * static_cast<double>(delta_t);
+        double missing = battery.get_Q_max() - battery.get_Q_current();
+        long long chargingSteps = missing > 0 ? static_cast<long long>(ceil(missing / perStep)) : 0;
+        if (chargingSteps > remaining){
+            chargingSteps = remaining;
+        }
+        if (chargingSteps > 0){
+            bool full = false;
+            battery.charge(voltage, chargingSteps * delta_t, full);
+            charger.startCharging(battery, 0); //Charging state as after any step that added charge
+            battery.relaxTemperature(chargingSteps, delta_t, ambientTemp);
+            remaining -= chargingSteps;
+        }
+        if (remaining > 0){
+            //The next step finds the battery full: the current drops to 0 and the charger stops
+            battery.set_Q_current(battery.get_Q_max());
+            charger.startCharging(battery, delta_t);
+        }
+    }
+    battery.relaxTemperature(remaining, delta_t, ambientTemp);
+    totalTime += steps * static_cast<double>(delta_t);
+}
+
+//@brief charge with the throttle released until the charger stops (battery full) or maxSeconds pass,
+//as stepping with the "C" key held would. The vehicle first rolls to a stop step by step.
+//@param maxSeconds - time limit, delta_t - frame time of the equivalent step-by-step run
+//@return simulated seconds advanced
+double Simulation::chargeUntilFull(double maxSeconds, float delta_t){
+    input.set_throttle(0.0);
+    long long maxSteps = static_cast<long long>(maxSeconds / delta_t + 0.5);
+    long long steps = stepUntilIdle(maxSteps, delta_t, true);
+    if (!charger.get_charging_state() && steps > 0 && battery.get_Q_current() >= battery.get_Q_max()){
+        return steps * static_cast<double>(delta_t); //Filled up while rolling to a stop
+    }
+
+    //Idle steps until the step that finds the battery full
+    double perStep = battery.chargeRate(charger.chargingVoltage(battery)) * static_cast<double>(delta_t);
+    double missing = battery.get_Q_max() - battery.get_Q_current();
+    long long needed = (missing > 0 ? static_cast<long long>(ceil(missing / perStep)) : 0) + 1;
+    long long idleSteps = min(needed, maxSteps - steps);
+    skipIdleSteps(idleSteps, delta_t, true);
+    return (steps + idleSteps) * static_cast<double>(delta_t);
+}
+
+//@brief park for a number of seconds: throttle released and brake held, no charger. The vehicle
+//first brakes to a stop step by step, then the rest of the time is skipped in one jump.
+//@param seconds - how long to park, delta_t - frame time of the equivalent step-by-step run
+void Simulation::park(double seconds, float delta_t){
+    input.set_throttle(0.0);
+    input.set_brake(1.0);
+    long long total = static_cast<long long>(seconds / delta_t + 0.5);
+    long long steps = stepUntilIdle(total, delta_t, false);
+    skipIdleSteps(total - steps, delta_t, false);
+}
+
+//@brief advance the vehicle by duration seconds with adaptive steps (see integrator.h). The driver input
+//and ambient temperature are held constant, so call this once per control interval.
+//@param duration - seconds to advance, charging - true if the charger is plugged in, options - tolerances, stats - step counts (added to)
+void Simulation::advance(float duration, bool charging, const IntegratorOptions &options, IntegratorStats &stats){
+    totalTime += duration;
+    vehicleSpeed = integrateVehicle(motor, battery, vehicle, charger, input, charging, ambientTemp, duration, options, stats);
+}
+
+//getters
+//@brief write the whole state (every component plus the clock) to a snapshot
+void Simulation::saveSnapshot(vector<uint8_t> &bytes){
+    const char magic[] = "EVSS";
+    bytes.assign(magic, magic + 4);
+    putU32(bytes, SNAPSHOT_VERSION);
+    StateWriter out(bytes);
+    input.saveState(out);
+    motor.saveState(out);
+    battery.saveState(out);
+    vehicle.saveState(out);
+    charger.saveState(out);
+    out.beginSection("SIMU");
+    out.putFloat(ambientTemp);
+    out.putDouble(totalTime);
+    out.putFloat(vehicleSpeed);
+    out.endSection();
+}
+
+//@brief restore the state saved by saveSnapshot
+//@return false (and nothing changed) if the snapshot is damaged or from a newer version
+bool Simulation::restoreSnapshot(const vector<uint8_t> &bytes){
+    if (snapshotVersion(bytes) == 0){
+        cout << "Not a simulation snapshot this build can read\n";
+        return false;
+    }
+    Simulation loaded(*this);
+    StateReader clock = findSection(bytes, "SIMU");
+    loaded.ambientTemp = clock.getFloat();
+    loaded.totalTime = clock.getDouble();
+    loaded.vehicleSpeed = clock.getFloat();
+    if (!loaded.input.loadState(findSection(bytes, "DRVR")) || !loaded.motor.loadState(findSection(bytes, "MOTR")) ||
+        !loaded.battery.loadState(findSection(bytes, "BATT")) || !loaded.vehicle.loadState(findSection(bytes, "EVBD")) ||
+        !loaded.charger.loadState(findSection(bytes, "CHRG")) || !clock.is_ok()){
+        cout << "Snapshot is damaged or incomplete\n";
+        return false;
+    }
+    *this = loaded;
+    return true;
+}
+
+//@brief copy the simulation. Every component copies its full state, so the copy is a fork: both continue
+//the same way given the same input, and neither affects the other.
+Simulation Simulation::fork() const{
+    return *this;
+}
+
+DriverInput& Simulation::get_input(){
+    return input;
+}
+
+Motor& Simulation::get_motor(){
+    return motor;
+}
+
+Battery& Simulation::get_battery(){
+    return battery;
+}
+
+EV& Simulation::get_vehicle(){
+    return vehicle;
+}
+
+Charger& Simulation::get_charger(){
+    return charger;
+}
+
+double Simulation::get_time(){
+    return totalTime;
+}
+
+float Simulation::get_speed(){
+    return vehicleSpeed;
+}
+
+float Simulation::get_ambientTemp(){
+    return ambientTemp;
+}
+
+//setter
+void Simulation::set_ambientTemp(float T){
+    ambientTemp = T;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+//default headless settings: one hour of driving at ~60 steps per second
+HeadlessConfig::HeadlessConfig(){
+    dt = 0.016;
+    duration = 3600;
+    ambientTemp = 25;
+    logPath = "";
+    cycle = "";
+    adaptive = false;
+    loadStatePath = "";
+    saveStatePath = "";
+    tablesPath = "";
+    fidelity = Fidelity::Standard;
+}
+
+//@brief a simple repeating drive pattern so headless runs do not need a keyboard.
+//Every 30 seconds the driver accelerates for 10 s, coasts for 10 s, brakes for 5 s and waits for 5 s.
+//When the battery drops to 20% the driver stops and charges until the battery is full.
+//@param time - simulated time, battery - the battery (to check SOC), input - driver input to set, charging - charging state (kept between calls)
+void scriptedDriver(double time, Battery &battery, DriverInput &input, bool &charging){
+    scriptedDriver(time, battery.get_SOC(), input, charging);
+}
+
+//@brief the scripted driver for any battery model (SOC in percent)
+void scriptedDriver(double time, float SOC, DriverInput &input, bool &charging){
+    if (charging){
+        if (SOC >= 100){
+            charging = false;
+        }
+    } else if (SOC <= 20){
+        charging = true;
+    }
+
+    if (charging){ //Stay parked with the brake on while charging
+        input.set_throttle(0.0);
+        input.set_brake(1.0);
+        return;
+    }
+
+    double phase = time - 30 * floor(time / 30);
+    if (phase < 10){
+        input.set_throttle(1.0);
+        input.set_brake(0.0);
+    } else if (phase < 20){
+        input.set_throttle(0.0);
+        input.set_brake(0.0);
+    } else if (phase < 25){
+        input.set_throttle(0.0);
+        input.set_brake(1.0);
+    } else{
+        input.set_throttle(0.0);
+        input.set_brake(0.0);
+    }
+}
+
+//@brief run the simulation without a window at a fixed time step, as fast as the CPU allows
+//@param config - time step, duration, ambient temperature and optional log file (CSV if the name ends
+//in .csv, the binary columnar format otherwise) and optional drive cycle to replay
+//@return 0 on success, 1 if the log file or drive cycle could not be opened or the options do not go together
+int runHeadless(const HeadlessConfig &config){
+    //Reduced and detailed runs step a Fleet, which has no adaptive integrator, battery tables or snapshots
+    bool useFleet = config.fidelity != Fidelity::Standard;
+    if (useFleet && (config.adaptive || !config.tablesPath.empty() || !config.loadStatePath.empty() || !config.saveStatePath.empty())){
+        cout << "--fidelity " << fidelityName(config.fidelity) << " cannot be combined with --adaptive, --battery-tables, --load-state or --save-state\n";
+        return 1;
+    }
+
+    Simulation sim(config.ambientTemp);
+    if (!config.loadStatePath.empty()){
+        vector<uint8_t> snapshot;
+        if (!readSnapshotFile(config.loadStatePath, snapshot) || !sim.restoreSnapshot(snapshot)){
+            return 1;
+        }
+        sim.set_ambientTemp(config.ambientTemp);
+    }
+    double startTime = sim.get_time(); //Drive cycles continue from the restored time
+
+    Fleet fleet;
+    if (useFleet){
+        fleet.configure(sim.get_motor(), sim.get_battery(), sim.get_vehicle());
+        fleet.fidelity = config.fidelity;
+        fleet.addVehicle(sim.get_battery(), sim.get_motor(), sim.get_vehicle());
+    }
+
+    BatteryTables tables;
+    if (!config.tablesPath.empty()){
+        if (!tables.load(config.tablesPath)){
+            return 1;
+        }
+        sim.get_battery().set_tables(&tables);
+    }
+
+    DriveCycle cycle;
+    if (!config.cycle.empty() && !cycle.load(config.cycle)){
+        return 1;
+    }
+
+    ofstream logFile;
+    TelemetryWriter telemetry;
+    //Without a sampling policy every step is written as it is; otherwise the steps go through a sampler
+    TelemetrySampler sampler;
+    bool sampling = config.logSampling.mode != SAMPLE_EVERY_ROW;
+    vector<float> sampled;
+    if (!config.logPath.empty()){
+        vector<SamplingPolicy> policies(TELEMETRY_STANDARD_CHANNELS, config.logSampling);
+        sampler.configure(standardTelemetryChannels(true), sampling ? policies : vector<SamplingPolicy>());
+        const vector<TelemetryChannel> &channels = sampler.get_outputChannels();
+        bool opened;
+        if (isCsvPath(config.logPath)){
+            logFile.open(config.logPath);
+            opened = logFile.is_open();
+            if (opened){
+                for (size_t c = 0; c < channels.size(); c++){
+                    logFile << (c > 0 ? "," : "") << channels[c].name;
+                }
+                logFile << "\n";
+            }
+        } else{
+            opened = telemetry.open(config.logPath, channels);
+        }
+        if (!opened){
+            cout << "Cannot open file " << config.logPath << "\n";
+            return 1;
+        }
+    }
+
+    //Use a step count instead of comparing floats so every run takes exactly the same steps
+    long long steps = static_cast<long long>(config.duration / config.dt + 0.5);
+    bool charging = sim.get_charger().get_charging_state();
+    IntegratorStats integratorStats = {0, 0, 0};
+    unsigned long long checksum = 1469598103934665603ULL; //FNV-1a hash of the speed and SOC of every step
+
+    auto writeSampled = [&](){
+        size_t width = sampler.get_outputChannels().size();
+        for (size_t r = 0; r + width <= sampled.size(); r += width){
+            if (logFile.is_open()){
+                for (size_t c = 0; c < width; c++){
+                    logFile << (c > 0 ? "," : "") << sampled[r + c];
+                }
+                logFile << "\n";
+            } else{
+                telemetry.write(&sampled[r]);
+            }
+        }
+        sampled.clear();
+    };
+
+    auto wallStart = chrono::steady_clock::now();
+    //State of the vehicle after the last step, from the Simulation or the one-vehicle fleet
+    double time = startTime;
+    float speed = useFleet ? fleet.speed[0] : sim.get_speed();
+    float SOC = useFleet ? fleet.get_SOC(0) : sim.get_battery().get_SOC();
+    float temperature = useFleet ? fleet.temperature[0] : sim.get_battery().get_temp();
+    for (long long i = 0; i < steps; i++){
+        if (config.cycle.empty()){
+            if (useFleet){
+                scriptedDriver(time, SOC, sim.get_input(), charging);
+            } else{
+                scriptedDriver(sim.get_time(), sim.get_battery(), sim.get_input(), charging);
+            }
+        } else{
+            cycle.apply(startTime + i * static_cast<double>(config.dt), speed, sim.get_input());
+        }
+        if (useFleet){
+            fleet.setInput(0, sim.get_input().get_throttle(), sim.get_input().get_brake());
+            fleet.charging[0] = charging;
+            fleet.step(config.dt, config.ambientTemp);
+            time += config.dt;
+            speed = fleet.speed[0];
+            SOC = fleet.get_SOC(0);
+            temperature = fleet.temperature[0];
+        } else{
+            if (config.adaptive){
+                sim.advance(config.dt, charging, config.integrator, integratorStats);
+            } else{
+                sim.step(config.dt, charging);
+            }
+            time = sim.get_time();
+            speed = sim.get_speed();
+            SOC = sim.get_battery().get_SOC();
+            temperature = sim.get_battery().get_temp();
+        }
+
+        float traced[2] = {speed, SOC};
+        for (float value : traced){
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+            checksum = (checksum ^ bits) * 1099511628211ULL;
+        }
+
+        if (sampling && (logFile.is_open() || telemetry.is_open())){
+            const float row[TELEMETRY_STANDARD_CHANNELS] = {static_cast<float>(time), speed, SOC, temperature,
+                                                            sim.get_input().get_throttle(), sim.get_input().get_brake()};
+            if (sampler.push(row, sampled) > 0){
+                writeSampled();
+            }
+        } else if (logFile.is_open()){
+            logFile << time << ","
+            << speed << ","
+            << SOC << ","
+            << temperature << ","
+            << sim.get_input().get_throttle() << ","
+            << sim.get_input().get_brake() << "\n";
+        } else if (telemetry.is_open()){
+            telemetry.write(TelemetryRecord{static_cast<float>(time), speed, SOC, temperature,
+                                            sim.get_input().get_throttle(), sim.get_input().get_brake()});
+        }
+    }
+    if (sampling && sampler.flush(sampled) > 0){
+        writeSampled();
+    }
+    telemetry.close();
+    auto wallEnd = chrono::steady_clock::now();
+    double wallSeconds = chrono::duration<double>(wallEnd - wallStart).count();
+    double simSeconds = steps * static_cast<double>(config.dt);
+
+    cout << "Headless run: " << steps << " steps of " << config.dt << " s, " << fidelityName(config.fidelity) << " fidelity";
+    if (!config.cycle.empty()){
+        cout << ", replaying " << cycle.get_name() << " (" << cycle.samples() << " samples, " << cycle.duration() << " s per pass)";
+    }
+    cout << "\n";
+    if (config.adaptive){
+        cout << "Adaptive integrator: " << integratorStats.accepted << " steps, " << integratorStats.rejected
+             << " rejected, " << integratorStats.events << " events\n";
+    }
+    cout << "Simulated " << simSeconds << " s in " << wallSeconds << " s wall time";
+    if (wallSeconds > 0){
+        cout << " (" << simSeconds / wallSeconds << " simulated seconds per wall second)";
+    }
+    cout << "\n";
+    if (useFleet){
+        cout << "Final speed: " << speed << " m/s, SOC: " << SOC << "%, battery temperature: " << temperature << " C\n";
+    } else{
+        cout << "Final speed: " << speed << " m/s, SOC: " << SOC << "%, battery temperature: " << temperature
+             << " C, SOH: " << sim.get_battery().get_SOH() << ", voltage: " << sim.get_battery().get_voltage() << " V\n";
+    }
+    cout << "Trace checksum: " << hex << checksum << dec << "\n";
+    if (sampling && !config.logPath.empty()){
+        cout << "Log: " << sampler.get_rowsOut() << " of " << sampler.get_rowsIn() << " rows kept\n";
+    }
+
+    if (!config.saveStatePath.empty()){
+        vector<uint8_t> snapshot;
+        sim.saveSnapshot(snapshot);
+        if (!writeSnapshotFile(config.saveStatePath, snapshot)){
+            return 1;
+        }
+        cout << "State saved to " << config.saveStatePath << "\n";
+    }
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+//@brief print the state compared by the fast-forward check
+void printCheckState(const char* label, Simulation &sim){
+    cout << "  " << label << ": time " << sim.get_time() << " s, SOC " << sim.get_battery().get_SOC()
+         << "%, temperature " << sim.get_battery().get_temp() << " C, current " << sim.get_battery().get_current()
+         << ", charging " << (sim.get_charger().get_charging_state() ? "yes" : "no") << "\n";
+}
+
+//@brief print the states after one phase of the fast-forward check and their differences
+//@return true if fast-forward is within the tolerances of frame by frame
+bool compareFastForward(const char* phase, Simulation &stepped, Simulation &jumped){
+    Battery &a = stepped.get_battery();
+    Battery &b = jumped.get_battery();
+    double dTime = fabs(stepped.get_time() - jumped.get_time());
+    float dSOC = fabs(a.get_SOC() - b.get_SOC());
+    float dTemp = fabs(a.get_temp() - b.get_temp());
+    float dCurrent = fabs(a.get_current() - b.get_current());
+    bool sameCharging = stepped.get_charger().get_charging_state() == jumped.get_charger().get_charging_state();
+    bool passed = dTime <= FAST_FORWARD_TIME_TOLERANCE && dSOC <= FAST_FORWARD_SOC_TOLERANCE && dTemp <= FAST_FORWARD_TEMP_TOLERANCE
+                  && dCurrent <= FAST_FORWARD_CURRENT_TOLERANCE && sameCharging;
+    cout << " after " << phase << ":\n";
+    printCheckState("frame by frame", stepped);
+    printCheckState("fast-forward  ", jumped);
+    cout << "  difference: time " << dTime << " s, SOC " << dSOC << "%, temperature " << dTemp << " C, current " << dCurrent
+         << " A" << (sameCharging ? "" : ", charging state differs") << (passed ? " (ok)" : " (FAIL, above the tolerance)") << "\n";
+    return passed;
+}
+
+//@brief drive for a number of steps at full throttle
+void driveSteps(Simulation &sim, long long steps, float delta_t){
+    sim.get_input().set_throttle(1.0);
+    sim.get_input().set_brake(0.0);
+    for (long long i = 0; i < steps; i++){
+        sim.step(delta_t, false);
+    }
+}
+
+//@brief drive, charge until full and park overnight, once frame by frame and once with the fast-forward
+//functions, and print both end states and the time taken
+//@return 0 if both end states are within the tolerances, 1 otherwise
+int runFastForwardCheck(){
+    const float dt = 0.016;
+    const long long drivingSteps = static_cast<long long>(300 / dt);
+    const double parkSeconds = 8 * 3600;
+
+    //Frame by frame
+    auto start = chrono::steady_clock::now();
+    Simulation stepped(35);
+    driveSteps(stepped, drivingSteps, dt);
+    stepped.get_input().set_throttle(0.0);
+    long long chargeSteps = 0;
+    do{
+        stepped.step(dt, true);
+        chargeSteps++;
+    } while (stepped.get_charger().get_charging_state());
+    Simulation steppedCharged = stepped;
+    stepped.get_input().set_brake(1.0);
+    long long parkSteps = static_cast<long long>(parkSeconds / dt + 0.5);
+    for (long long i = 0; i < parkSteps; i++){
+        stepped.step(dt, false);
+    }
+    double steppedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    //Fast-forward
+    start = chrono::steady_clock::now();
+    Simulation jumped(35);
+    driveSteps(jumped, drivingSteps, dt);
+    jumped.chargeUntilFull(24 * 3600, dt);
+    Simulation jumpedCharged = jumped;
+    jumped.park(parkSeconds, dt);
+    double jumpedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Fast-forward check: 300 s full throttle, charge until full (" << chargeSteps * dt
+         << " s), park 8 h at 35 C, dt " << dt << "\n";
+    bool passed = compareFastForward("charging", steppedCharged, jumpedCharged);
+    passed = compareFastForward("parking", stepped, jumped) && passed;
+    cout << " frame by frame: " << drivingSteps + chargeSteps + parkSteps << " steps in " << steppedSeconds * 1000
+         << " ms, fast-forward: " << jumpedSeconds * 1000 << " ms\n";
+    return passed ? 0 : 1;
+}
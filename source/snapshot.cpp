@@ -0,0 +1,240 @@
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <chrono>
+#include <cmath>
+#include "../headers/snapshot.h"
+#include "../headers/telemetry.h"
+#include "../headers/simulation.h"
+using namespace std;
+
+StateWriter::StateWriter(vector<uint8_t> &bytes) : bytes(bytes){
+    sectionStart = 0;
+}
+
+void StateWriter::beginSection(const char* tag){
+    bytes.insert(bytes.end(), tag, tag + 4);
+    sectionStart = bytes.size();
+    putU32(bytes, 0); //Filled in by endSection
+}
+
+void StateWriter::endSection(){
+    uint32_t length = static_cast<uint32_t>(bytes.size() - sectionStart - 4);
+    for (int i = 0; i < 4; i++){
+        bytes[sectionStart + i] = static_cast<uint8_t>(length >> (8 * i));
+    }
+}
+
+void StateWriter::putFloat(float value){
+    putU32(bytes, floatBits(value));
+}
+
+void StateWriter::putDouble(double value){
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU32(bytes, static_cast<uint32_t>(bits));
+    putU32(bytes, static_cast<uint32_t>(bits >> 32));
+}
+
+void StateWriter::putBool(bool value){
+    bytes.push_back(value ? 1 : 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+StateReader::StateReader(const uint8_t* data, size_t size, uint32_t version){
+    this->data = data;
+    this->size = size;
+    this->version = version;
+    position = 0;
+    ok = data != nullptr;
+}
+
+float StateReader::getFloat(){
+    if (!ok || position + 4 > size){
+        ok = false;
+        return 0;
+    }
+    float value = bitsFloat(getU32(data + position));
+    position += 4;
+    return value;
+}
+
+double StateReader::getDouble(){
+    if (!ok || position + 8 > size){
+        ok = false;
+        return 0;
+    }
+    uint64_t bits = getU32(data + position) | (static_cast<uint64_t>(getU32(data + position + 4)) << 32);
+    position += 8;
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+bool StateReader::getBool(){
+    if (!ok || position + 1 > size){
+        ok = false;
+        return false;
+    }
+    return data[position++] != 0;
+}
+
+bool StateReader::is_ok(){
+    return ok;
+}
+
+uint32_t StateReader::get_version(){
+    return version;
+}
+
+uint32_t snapshotVersion(const vector<uint8_t> &bytes){
+    if (bytes.size() < 8 || memcmp(bytes.data(), "EVSS", 4) != 0){
+        return 0;
+    }
+    uint32_t version = getU32(bytes.data() + 4);
+    return version >= 1 && version <= SNAPSHOT_VERSION ? version : 0;
+}
+
+StateReader findSection(const vector<uint8_t> &bytes, const char* tag){
+    uint32_t version = snapshotVersion(bytes);
+    if (version == 0){
+        return StateReader(nullptr, 0, 0);
+    }
+    size_t position = 8;
+    while (position + 8 <= bytes.size()){
+        uint32_t length = getU32(bytes.data() + position + 4);
+        if (length > bytes.size() - position - 8){
+            break; //Truncated
+        }
+        if (memcmp(bytes.data() + position, tag, 4) == 0){
+            return StateReader(bytes.data() + position + 8, length, version);
+        }
+        position += 8 + length;
+    }
+    return StateReader(nullptr, 0, version);
+}
+
+bool writeSnapshotFile(const string &path, const vector<uint8_t> &bytes){
+    ofstream file(path, ios::binary);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+    return file.good();
+}
+
+bool readSnapshotFile(const string &path, vector<uint8_t> &bytes){
+    ifstream file(path, ios::binary);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+    bytes.assign(istreambuf_iterator<char>(file), istreambuf_iterator<char>());
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+//@brief drive pattern of the check: full throttle, then the branch's own throttle from 60 s on
+void snapshotCheckInput(Simulation &sim, float throttle){
+    sim.get_input().set_throttle(sim.get_time() < 60 ? 1.0f : throttle);
+    sim.get_input().set_brake(0);
+}
+
+int runSnapshotCheck(){
+    const float dt = 0.01;
+    const long long prefixSteps = 6000; //60 s warm-up shared by every branch
+    const long long branchSteps = 3000; //30 s per what-if continuation
+    const int branches = 1000;
+
+    //Warm up and save
+    Simulation original(30);
+    for (long long i = 0; i < prefixSteps; i++){
+        snapshotCheckInput(original, 1);
+        original.step(dt, false);
+    }
+    vector<uint8_t> bytes;
+    original.saveSnapshot(bytes);
+    cout << "Snapshot after " << original.get_time() << " s: " << bytes.size() << " bytes (version " << SNAPSHOT_VERSION << ")\n";
+
+    //Restore into a differently configured simulation and continue both: the traces must match bit for bit
+    Simulation restored(10);
+    restored.configure(Motor(100, 300), Battery(20, 200, 0.5, 500), EV(0.3));
+    if (!restored.restoreSnapshot(bytes)){
+        cout << "Restore failed\n";
+        return 1;
+    }
+    int mismatches = 0;
+    for (long long i = 0; i < branchSteps; i++){
+        snapshotCheckInput(original, 0.5);
+        snapshotCheckInput(restored, 0.5);
+        original.step(dt, false);
+        restored.step(dt, false);
+        if (original.get_speed() != restored.get_speed() || original.get_battery().get_SOC() != restored.get_battery().get_SOC() ||
+            original.get_battery().get_temp() != restored.get_battery().get_temp()){
+            mismatches++;
+        }
+    }
+    cout << "Restored run: " << mismatches << " of " << branchSteps << " steps differ from the original\n";
+
+    //A damaged snapshot must be refused without touching the simulation
+    vector<uint8_t> damaged(bytes.begin(), bytes.begin() + bytes.size() / 2);
+    float socBefore = restored.get_battery().get_SOC();
+    bool refused = !restored.restoreSnapshot(damaged) && restored.get_battery().get_SOC() == socBefore;
+    cout << "Truncated snapshot " << (refused ? "refused" : "ACCEPTED") << "\n";
+
+    //Branch many what-if continuations: forking the warmed-up state versus re-simulating the prefix each time
+    Simulation base(30);
+    base.restoreSnapshot(bytes);
+    auto start = chrono::steady_clock::now();
+    double forkedSOC = 0;
+    for (int b = 0; b < branches; b++){
+        Simulation branch = base.fork();
+        float throttle = static_cast<float>(b) / branches;
+        for (long long i = 0; i < branchSteps; i++){
+            snapshotCheckInput(branch, throttle);
+            branch.step(dt, false);
+        }
+        forkedSOC += branch.get_battery().get_SOC();
+    }
+    double forkedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    //Re-simulating is timed on a sample of the branches (it is the slow way round)
+    const int sample = 50;
+    start = chrono::steady_clock::now();
+    for (int b = 0; b < branches; b += branches / sample){
+        Simulation branch(30);
+        float throttle = static_cast<float>(b) / branches;
+        for (long long i = 0; i < prefixSteps + branchSteps; i++){
+            snapshotCheckInput(branch, throttle);
+            branch.step(dt, false);
+        }
+    }
+    double replayedSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count() * branches / sample;
+
+    //The forked branches that were also replayed must end the same
+    int branchMismatches = 0;
+    for (int b = 0; b < branches; b += branches / sample){
+        Simulation forked = base.fork();
+        float throttle = static_cast<float>(b) / branches;
+        for (long long i = 0; i < branchSteps; i++){
+            snapshotCheckInput(forked, throttle);
+            forked.step(dt, false);
+        }
+        Simulation replayed(30);
+        for (long long i = 0; i < prefixSteps + branchSteps; i++){
+            snapshotCheckInput(replayed, throttle);
+            replayed.step(dt, false);
+        }
+        if (forked.get_battery().get_SOC() != replayed.get_battery().get_SOC() || forked.get_speed() != replayed.get_speed()){
+            branchMismatches++;
+        }
+    }
+    cout << branches << " forked branches: " << forkedSeconds << " s (mean final SOC " << forkedSOC / branches << "%), re-simulating the "
+         << prefixSteps * dt << " s prefix for each: ~" << replayedSeconds << " s, " << branchMismatches << " of " << sample
+         << " sampled branches differ\n";
+
+    return mismatches == 0 && branchMismatches == 0 && refused ? 0 : 1;
+}
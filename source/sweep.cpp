@@ -0,0 +1,271 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include "../headers/sweep.h"
+#include "../headers/simulation.h"
+#include "../headers/drive_cycle.h"
+#include "../headers/thread_pool.h"
+#include "../headers/battery_tables.h"
+using namespace std;
+
+//default grid: a single configuration with the default value of every parameter
+ParameterSweep::ParameterSweep(){
+    names = {"capacity", "vmax", "rinternal", "heatcap", "torque", "maxspeed", "wheel"};
+    values = {{150}, {420}, {0.02}, {1000}, {200}, {100}, {0.5}};
+}
+
+bool ParameterSweep::setValues(const string &name, const string &spec){
+    int index = -1;
+    for (size_t i = 0; i < names.size(); i++){
+        if (names[i] == name){
+            index = static_cast<int>(i);
+        }
+    }
+    if (index < 0){
+        cout << "Unknown sweep parameter: " << name << "\n";
+        return false;
+    }
+
+    vector<float> list;
+    try{
+        size_t colon = spec.find(':');
+        if (colon != string::npos){
+            //"from:to:count"
+            size_t second = spec.find(':', colon + 1);
+            if (second == string::npos){
+                cout << "Range for " << name << " must be from:to:count\n";
+                return false;
+            }
+            float from = stof(spec.substr(0, colon));
+            float to = stof(spec.substr(colon + 1, second - colon - 1));
+            int count = stoi(spec.substr(second + 1));
+            if (count < 1){
+                cout << "Range for " << name << " needs at least one value\n";
+                return false;
+            }
+            for (int i = 0; i < count; i++){
+                list.push_back(count == 1 ? from : from + (to - from) * i / (count - 1));
+            }
+        } else{
+            //"v1,v2,..." or a single value
+            stringstream stream(spec);
+            string item;
+            while (getline(stream, item, ',')){
+                list.push_back(stof(item));
+            }
+        }
+    } catch (...){
+        cout << "Invalid values for " << name << ": " << spec << "\n";
+        return false;
+    }
+    for (float value : list){
+        if (value <= 0){
+            cout << "Values for " << name << " must be positive\n";
+            return false;
+        }
+    }
+    if (list.empty()){
+        cout << "No values for " << name << "\n";
+        return false;
+    }
+    values[index] = list;
+    return true;
+}
+
+const vector<string>& ParameterSweep::get_names(){
+    return names;
+}
+
+//@return number of configurations in the grid
+long long ParameterSweep::size(){
+    long long count = 1;
+    for (const vector<float> &list : values){
+        count *= list.size();
+    }
+    return count;
+}
+
+//@brief configuration number index (the last parameter changes fastest)
+SweepConfig ParameterSweep::config(long long index){
+    float chosen[7];
+    for (int p = 6; p >= 0; p--){
+        long long count = values[p].size();
+        chosen[p] = values[p][index % count];
+        index /= count;
+    }
+    return SweepConfig{chosen[0], chosen[1], chosen[2], chosen[3], chosen[4], chosen[5], chosen[6]};
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+SweepResult runConfiguration(const SweepConfig &config, DriveCycle &cycle, float delta_t, float duration, float ambientTemp,
+                             const BatteryTables* tables){
+    Simulation sim(ambientTemp);
+    sim.configure(Motor(config.maxTorque, config.maxSpeed),
+                  Battery(config.capacity, config.V_max, config.R_internal, config.heatCapacity),
+                  EV(config.wheelRadius));
+    sim.get_battery().set_tables(tables);
+
+    SweepResult result;
+    result.peakTemp = sim.get_battery().get_temp();
+    double distance = 0;
+    long long steps = static_cast<long long>(duration / delta_t + 0.5);
+    for (long long i = 0; i < steps; i++){
+        cycle.apply(i * static_cast<double>(delta_t), sim.get_speed(), sim.get_input());
+        sim.stepWithWear(delta_t, false);
+        distance += sim.get_speed() * delta_t;
+        if (sim.get_battery().get_temp() > result.peakTemp){
+            result.peakTemp = sim.get_battery().get_temp();
+        }
+    }
+    result.finalSOC = sim.get_battery().get_SOC();
+    result.SOH = sim.get_battery().get_SOH();
+    result.distanceKm = static_cast<float>(distance / 1000);
+    return result;
+}
+
+SweepOptions::SweepOptions(){
+    cycle = "ece15";
+    dt = 0.05;
+    duration = 1800;
+    ambientTemp = 25;
+    threads = 1;
+    outputPath = "sweep.csv";
+    resume = false;
+    tablesPath = "";
+}
+
+//@brief read the rows of an earlier (possibly interrupted) run and mark their configurations as done.
+//Rows whose parameters do not match the current grid, and a half-written last line, are dropped.
+//@return the valid rows, to be written back before new rows are appended
+vector<string> readFinishedRows(const string &path, ParameterSweep &sweep, vector<char> &done, string &header){
+    vector<string> rows;
+    ifstream file(path);
+    if (!file.is_open()){
+        return rows;
+    }
+    string line;
+    getline(file, line);
+    if (line != header){
+        cout << "Existing " << path << " has different columns, starting over\n";
+        return rows;
+    }
+    while (getline(file, line)){
+        if (file.eof()){
+            break; //No newline at the end: the row was cut off by the interruption
+        }
+        stringstream stream(line);
+        string field;
+        vector<float> fields;
+        long long index = -1;
+        try{
+            getline(stream, field, ',');
+            index = stoll(field);
+            while (getline(stream, field, ',')){
+                fields.push_back(stof(field));
+            }
+        } catch (...){
+            continue;
+        }
+        if (index < 0 || index >= sweep.size() || fields.size() != 11 || done[index]){
+            continue;
+        }
+        SweepConfig config = sweep.config(index);
+        const float expected[7] = {config.capacity, config.V_max, config.R_internal, config.heatCapacity,
+                                   config.maxTorque, config.maxSpeed, config.wheelRadius};
+        bool matches = true;
+        for (int p = 0; p < 7; p++){
+            if (fields[p] != expected[p]){
+                matches = false;
+            }
+        }
+        if (matches){
+            done[index] = 1;
+            rows.push_back(line);
+        }
+    }
+    return rows;
+}
+
+//@brief format one row of the results table. Parameters are written with 9 significant digits so
+//they read back as exactly the same floats when resuming.
+string formatRow(long long index, const SweepConfig &config, const SweepResult &result){
+    stringstream row;
+    row << index << setprecision(9);
+    row << "," << config.capacity << "," << config.V_max << "," << config.R_internal << "," << config.heatCapacity
+        << "," << config.maxTorque << "," << config.maxSpeed << "," << config.wheelRadius;
+    row << setprecision(6);
+    row << "," << result.finalSOC << "," << result.peakTemp << "," << result.SOH << "," << result.distanceKm << "\n";
+    return row.str();
+}
+
+//@brief run every configuration that is not finished yet on a thread pool, appending each result
+//to the table as soon as it is done (so an interrupted sweep loses at most the rows in progress)
+//@return 0 on success, 1 if the cycle or output file cannot be opened
+int runSweep(ParameterSweep &sweep, const SweepOptions &options){
+    DriveCycle cycle;
+    if (!cycle.load(options.cycle)){
+        return 1;
+    }
+    //One copy of the battery curves, read by every worker
+    BatteryTables tables;
+    if (!options.tablesPath.empty() && !tables.load(options.tablesPath)){
+        return 1;
+    }
+    const BatteryTables* sharedTables = options.tablesPath.empty() ? nullptr : &tables;
+    long long total = sweep.size();
+    string header = "Index,Capacity,VMax,RInternal,HeatCapacity,MaxTorque,MaxSpeed,WheelRadius,FinalSOC,PeakTemp,SOH,DistanceKm";
+
+    vector<char> done(total, 0);
+    vector<string> finished;
+    if (options.resume){
+        finished = readFinishedRows(options.outputPath, sweep, done, header);
+    }
+
+    //Rewrite the file with the valid rows only, then append the new ones
+    ofstream output(options.outputPath, ios::trunc);
+    if (!output.is_open()){
+        cout << "Cannot open file " << options.outputPath << "\n";
+        return 1;
+    }
+    output << header << "\n";
+    for (const string &row : finished){
+        output << row << "\n";
+    }
+    output.flush();
+
+    vector<long long> pending;
+    for (long long i = 0; i < total; i++){
+        if (!done[i]){
+            pending.push_back(i);
+        }
+    }
+    cout << "Sweep: " << total << " configurations, " << finished.size() << " already done, "
+         << pending.size() << " to run on " << options.threads << " threads\n";
+
+    mutex outputLock;
+    ThreadPool pool(options.threads);
+    auto start = chrono::steady_clock::now();
+    pool.run(static_cast<int>(pending.size()), [&](int task){
+        long long index = pending[task];
+        DriveCycle myCycle = cycle; //Each task gets its own copy (the cycle remembers its position)
+        SweepConfig config = sweep.config(index);
+        SweepResult result = runConfiguration(config, myCycle, options.dt, options.duration, options.ambientTemp, sharedTables);
+        string row = formatRow(index, config, result);
+        lock_guard<mutex> guard(outputLock);
+        output << row;
+        output.flush();
+    });
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "Ran " << pending.size() << " configurations in " << seconds << " s";
+    if (seconds > 0){
+        cout << " (" << pending.size() / seconds << " configurations per second)";
+    }
+    cout << "\nResults written to " << options.outputPath << "\n";
+    return 0;
+}
@@ -0,0 +1,324 @@
+#include <iostream>
+#include <cstring>
+#include "../headers/telemetry.h"
+using namespace std;
+
+//Helpers to write and read fixed-width little-endian values, whatever the machine's byte order is
+void putU32(vector<uint8_t> &out, uint32_t value){
+    for (int i = 0; i < 4; i++){
+        out.push_back(static_cast<uint8_t>(value >> (8 * i)));
+    }
+}
+
+uint32_t getU32(const uint8_t* in){
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+uint32_t floatBits(float value){
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+float bitsFloat(uint32_t bits){
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+//@brief encode a column as the zigzag + varint coded differences between consecutive bit patterns
+void encodeDelta(const float* values, int count, vector<uint8_t> &out){
+    uint32_t previous = 0;
+    for (int i = 0; i < count; i++){
+        uint32_t bits = floatBits(values[i]);
+        int32_t delta = static_cast<int32_t>(bits - previous);
+        uint32_t zigzag = (static_cast<uint32_t>(delta) << 1) ^ static_cast<uint32_t>(delta >> 31);
+        while (zigzag >= 0x80){
+            out.push_back(static_cast<uint8_t>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(zigzag));
+        previous = bits;
+    }
+}
+
+//@brief decode a delta column
+//@return false if the data ends early
+bool decodeDelta(const uint8_t* in, size_t length, int count, vector<float> &values){
+    uint32_t previous = 0;
+    size_t pos = 0;
+    values.resize(count);
+    for (int i = 0; i < count; i++){
+        uint32_t zigzag = 0;
+        int shift = 0;
+        while (true){
+            if (pos >= length || shift > 28){
+                return false;
+            }
+            uint8_t byte = in[pos++];
+            zigzag |= static_cast<uint32_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)){
+                break;
+            }
+            shift += 7;
+        }
+        int32_t delta = static_cast<int32_t>(zigzag >> 1) ^ -static_cast<int32_t>(zigzag & 1);
+        previous += static_cast<uint32_t>(delta);
+        values[i] = bitsFloat(previous);
+    }
+    return true;
+}
+
+//@brief the standard log channels. With delta encoding on, the channels that rarely change between
+//frames (SOC, temperature and the pedals) are delta encoded; Time and Speed stay raw.
+vector<TelemetryChannel> standardTelemetryChannels(bool deltaEncoding){
+    uint8_t slow = deltaEncoding ? TELEMETRY_DELTA : TELEMETRY_RAW;
+    vector<TelemetryChannel> channels = {
+        {"Time", TELEMETRY_RAW},
+        {"Speed", TELEMETRY_RAW},
+        {"SOC", slow},
+        {"BatteryTemp", slow},
+        {"Throttle", slow},
+        {"Brake", slow}
+    };
+    return channels;
+}
+
+bool isCsvPath(const string &path){
+    return path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+TelemetryWriter::TelemetryWriter(){
+    blockSize = 0;
+    rows = 0;
+}
+
+TelemetryWriter::~TelemetryWriter(){
+    close();
+}
+
+//@brief create the file and write the header
+//@param path - file to create, channels - column names and encodings, blockSize - rows per block
+//@return false if the file could not be created
+bool TelemetryWriter::open(const string &path, const vector<TelemetryChannel> &channels, int blockSize){
+    close();
+    file.open(path, ios::binary);
+    if (!file.is_open()){
+        return false;
+    }
+    this->channels = channels;
+    this->blockSize = blockSize;
+    rows = 0;
+    block.assign(static_cast<size_t>(blockSize) * channels.size(), 0);
+
+    vector<uint8_t> header = {'E', 'V', 'T', 'L'};
+    putU32(header, 1); //version
+    putU32(header, blockSize);
+    putU32(header, static_cast<uint32_t>(channels.size()));
+    for (const TelemetryChannel &channel : channels){
+        header.push_back(TELEMETRY_TYPE_FLOAT32);
+        header.push_back(channel.encoding);
+        header.push_back(static_cast<uint8_t>(channel.name.size()));
+        header.insert(header.end(), channel.name.begin(), channel.name.end());
+    }
+    file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    return true;
+}
+
+bool TelemetryWriter::is_open(){
+    return file.is_open();
+}
+
+//@brief append one row (one value per channel). Rows are buffered and written a block at a time.
+void TelemetryWriter::write(const float* row){
+    for (size_t c = 0; c < channels.size(); c++){
+        block[c * blockSize + rows] = row[c];
+    }
+    rows++;
+    if (rows == blockSize){
+        flushBlock();
+    }
+}
+
+void TelemetryWriter::write(const TelemetryRecord &record){
+    float row[TELEMETRY_STANDARD_CHANNELS] = {record.time, record.speed, record.soc,
+                                              record.batteryTemp, record.throttle, record.brake};
+    write(row);
+}
+
+//@brief encode the buffered rows column by column and write them out
+void TelemetryWriter::flushBlock(){
+    if (rows == 0){
+        return;
+    }
+    encoded.clear();
+    putU32(encoded, rows);
+    for (size_t c = 0; c < channels.size(); c++){
+        const float* column = &block[c * blockSize];
+        size_t lengthPos = encoded.size();
+        putU32(encoded, 0); //byte length, filled in below
+        if (channels[c].encoding == TELEMETRY_DELTA){
+            encodeDelta(column, rows, encoded);
+        } else{
+            for (int r = 0; r < rows; r++){
+                putU32(encoded, floatBits(column[r]));
+            }
+        }
+        uint32_t length = static_cast<uint32_t>(encoded.size() - lengthPos - 4);
+        for (int i = 0; i < 4; i++){
+            encoded[lengthPos + i] = static_cast<uint8_t>(length >> (8 * i));
+        }
+    }
+    file.write(reinterpret_cast<const char*>(encoded.data()), encoded.size());
+    rows = 0;
+}
+
+//@brief write the last (partial) block and close the file
+void TelemetryWriter::close(){
+    if (file.is_open()){
+        flushBlock();
+        file.close();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+TelemetryReader::TelemetryReader(){
+    blockSize = 0;
+    fileSize = 0;
+    damaged = false;
+}
+
+//@brief open a log and read its header
+//@return false if the file cannot be opened or is not a telemetry log
+bool TelemetryReader::open(const string &path){
+    damaged = false;
+    file.open(path, ios::binary);
+    if (!file.is_open()){
+        return false;
+    }
+    file.seekg(0, ios::end);
+    fileSize = static_cast<uint64_t>(file.tellg());
+    file.seekg(0, ios::beg);
+    uint8_t fixed[16];
+    if (!file.read(reinterpret_cast<char*>(fixed), 16) || memcmp(fixed, "EVTL", 4) != 0 || getU32(fixed + 4) != 1){
+        return false;
+    }
+    blockSize = getU32(fixed + 8);
+    if (blockSize == 0 || blockSize > TELEMETRY_MAX_BLOCK_ROWS){
+        return false;
+    }
+    uint32_t channelCount = getU32(fixed + 12);
+    channels.clear();
+    for (uint32_t c = 0; c < channelCount; c++){
+        uint8_t info[3];
+        if (!file.read(reinterpret_cast<char*>(info), 3) || info[0] != TELEMETRY_TYPE_FLOAT32){
+            return false;
+        }
+        string name(info[2], ' ');
+        if (!file.read(&name[0], info[2])){
+            return false;
+        }
+        channels.push_back({name, info[1]});
+    }
+    return true;
+}
+
+const vector<TelemetryChannel>& TelemetryReader::get_channels(){
+    return channels;
+}
+
+bool TelemetryReader::readBlock(vector<vector<float>> &columns){
+    uint8_t word[4];
+    if (!file.read(reinterpret_cast<char*>(word), 4)){
+        return file.gcount() == 0 ? false : fail(); //Nothing left is the end of the file, part of a word is not
+    }
+    uint32_t rowCount = getU32(word);
+    if (rowCount > blockSize){
+        return fail();
+    }
+    columns.resize(channels.size());
+    for (size_t c = 0; c < channels.size(); c++){
+        if (!file.read(reinterpret_cast<char*>(word), 4)){
+            return fail();
+        }
+        uint32_t length = getU32(word);
+        uint64_t position = static_cast<uint64_t>(file.tellg());
+        if (length > fileSize - position){ //Truncated or damaged: more bytes than the file has left
+            return fail();
+        }
+        encoded.resize(length);
+        if (!file.read(reinterpret_cast<char*>(encoded.data()), length)){
+            return fail();
+        }
+        if (channels[c].encoding == TELEMETRY_DELTA){
+            if (!decodeDelta(encoded.data(), length, rowCount, columns[c])){
+                return fail();
+            }
+        } else{
+            if (length != static_cast<uint64_t>(rowCount) * 4){
+                return fail();
+            }
+            columns[c].resize(rowCount);
+            for (uint32_t r = 0; r < rowCount; r++){
+                columns[c][r] = bitsFloat(getU32(&encoded[r * 4]));
+            }
+        }
+    }
+    return true;
+}
+
+bool TelemetryReader::fail(){
+    damaged = true;
+    return false;
+}
+
+bool TelemetryReader::is_damaged() const{
+    return damaged;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////
+
+//@brief convert a binary log to CSV, formatting the numbers exactly like the old per-frame logging
+//@return false if either file cannot be opened or the log is damaged
+bool convertTelemetryToCsv(const string &binaryPath, const string &csvPath){
+    TelemetryReader reader;
+    if (!reader.open(binaryPath)){
+        cout << "Cannot read telemetry file " << binaryPath << "\n";
+        return false;
+    }
+    ofstream csv(csvPath);
+    if (!csv.is_open()){
+        cout << "Cannot open file " << csvPath << "\n";
+        return false;
+    }
+
+    const vector<TelemetryChannel> &channels = reader.get_channels();
+    for (size_t c = 0; c < channels.size(); c++){
+        csv << (c > 0 ? "," : "") << channels[c].name;
+    }
+    csv << "\n";
+
+    vector<vector<float>> columns;
+    while (reader.readBlock(columns)){
+        size_t rowCount = columns.empty() ? 0 : columns[0].size();
+        for (size_t r = 0; r < rowCount; r++){
+            for (size_t c = 0; c < columns.size(); c++){
+                if (c > 0){
+                    csv << ",";
+                }
+                csv << columns[c][r];
+            }
+            csv << "\n";
+        }
+    }
+    if (reader.is_damaged()){
+        cout << "Warning: telemetry file " << binaryPath << " is damaged or cut off; " << csvPath
+             << " only has the rows before the damage\n";
+        return false;
+    }
+    return true;
+}
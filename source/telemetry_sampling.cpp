@@ -0,0 +1,362 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cmath>
+#include <cstdlib>
+#include "../headers/telemetry_sampling.h"
+using namespace std;
+
+SamplingPolicy::SamplingPolicy(){
+    mode = SAMPLE_EVERY_ROW;
+    interval = 0;
+    deadband = 0;
+}
+
+SamplingPolicy::SamplingPolicy(SamplingMode mode, float interval, float deadband){
+    this->mode = mode;
+    this->interval = interval;
+    this->deadband = deadband;
+}
+
+bool parseSamplingPolicy(const string &text, SamplingPolicy &policy){
+    //Split at the colons
+    vector<string> parts;
+    stringstream fields(text);
+    string part;
+    while (getline(fields, part, ':')){
+        parts.push_back(part);
+    }
+    vector<float> values;
+    for (size_t i = 1; i < parts.size(); i++){
+        char* end;
+        float value = strtof(parts[i].c_str(), &end);
+        if (parts[i].empty() || *end != '\0' || value < 0){
+            cout << "Invalid number in sampling policy " << text << "\n";
+            return false;
+        }
+        values.push_back(value);
+    }
+
+    string name = parts.empty() ? "" : parts[0];
+    if (name == "all" && values.empty()){
+        policy = SamplingPolicy();
+    } else if (name == "change" && values.size() <= 2){
+        policy = SamplingPolicy(SAMPLE_ON_CHANGE, values.size() > 1 ? values[1] : 0, values.empty() ? 0 : values[0]);
+    } else if ((name == "rate" || name == "bucket") && values.size() == 1 && values[0] > 0){
+        policy = SamplingPolicy(name == "rate" ? SAMPLE_FIXED_RATE : SAMPLE_BUCKET, values[0], 0);
+    } else{
+        cout << "Unknown sampling policy " << text << " (use all, change[:deadband[:heartbeat]], rate:<s> or bucket:<s>)\n";
+        return false;
+    }
+    return true;
+}
+
+vector<SamplingPolicy> windowSamplingPolicies(){
+    return {
+        SamplingPolicy(), //Time
+        SamplingPolicy(SAMPLE_ON_CHANGE, 1, 0.01), //Speed (m/s)
+        SamplingPolicy(SAMPLE_ON_CHANGE, 1, 0.01), //SOC (%)
+        SamplingPolicy(SAMPLE_ON_CHANGE, 1, 0.01), //BatteryTemp (C)
+        SamplingPolicy(SAMPLE_ON_CHANGE, 1, 0), //Throttle
+        SamplingPolicy(SAMPLE_ON_CHANGE, 1, 0) //Brake
+    };
+}
+
+TelemetrySampler::TelemetrySampler(){
+    previousWritten = false;
+    started = false;
+    lastWrittenTime = 0;
+    accumulated = 0;
+    rowsIn = 0;
+    rowsOut = 0;
+}
+
+bool TelemetrySampler::configure(const vector<TelemetryChannel> &channels, const vector<SamplingPolicy> &policies){
+    if (!policies.empty() && policies.size() != channels.size()){
+        cout << "Sampling needs one policy per channel (" << channels.size() << "), got " << policies.size() << "\n";
+        return false;
+    }
+    inputChannels = channels;
+    this->policies = policies.empty() ? vector<SamplingPolicy>(channels.size()) : policies;
+    outputChannels.clear();
+    for (size_t c = 0; c < channels.size(); c++){
+        outputChannels.push_back(channels[c]);
+        if (c > 0 && this->policies[c].mode == SAMPLE_BUCKET){
+            outputChannels.push_back({channels[c].name + "_min", channels[c].encoding});
+            outputChannels.push_back({channels[c].name + "_max", channels[c].encoding});
+        }
+    }
+    size_t count = channels.size();
+    previous.assign(count, 0);
+    lastWritten.assign(count, 0);
+    nextDue.assign(count, 0);
+    minimum.assign(count, 0);
+    maximum.assign(count, 0);
+    sum.assign(count, 0);
+    previousWritten = false;
+    started = false;
+    lastWrittenTime = 0;
+    accumulated = 0;
+    rowsIn = 0;
+    rowsOut = 0;
+    return true;
+}
+
+const vector<TelemetryChannel>& TelemetrySampler::get_outputChannels() const{
+    return outputChannels;
+}
+
+//@brief add a row to the bucket statistics
+void TelemetrySampler::accumulate(const float* row){
+    for (size_t c = 1; c < inputChannels.size(); c++){
+        if (accumulated == 0 || row[c] < minimum[c]) minimum[c] = row[c];
+        if (accumulated == 0 || row[c] > maximum[c]) maximum[c] = row[c];
+        sum[c] += row[c];
+    }
+    accumulated++;
+}
+
+//@brief append a row to the output and start new bucket statistics
+void TelemetrySampler::emit(const float* row, vector<float> &out){
+    for (size_t c = 0; c < inputChannels.size(); c++){
+        if (c > 0 && policies[c].mode == SAMPLE_BUCKET){
+            out.push_back(static_cast<float>(sum[c] / accumulated));
+            out.push_back(minimum[c]);
+            out.push_back(maximum[c]);
+        } else{
+            out.push_back(row[c]);
+        }
+        lastWritten[c] = row[c];
+        sum[c] = 0;
+    }
+    accumulated = 0;
+    lastWrittenTime = row[0];
+    rowsOut++;
+}
+
+int TelemetrySampler::push(const float* row, vector<float> &out){
+    rowsIn++;
+    size_t count = inputChannels.size();
+    float time = row[0];
+    if (!started){
+        started = true;
+        for (size_t c = 1; c < count; c++){
+            nextDue[c] = time + policies[c].interval;
+        }
+        accumulate(row);
+        emit(row, out);
+        previous.assign(row, row + count);
+        previousWritten = true;
+        return 1;
+    }
+
+    bool write = false, changed = false;
+    for (size_t c = 1; c < count; c++){
+        const SamplingPolicy &policy = policies[c];
+        switch (policy.mode){
+            case SAMPLE_EVERY_ROW:
+                write = true;
+                break;
+            case SAMPLE_FIXED_RATE:
+            case SAMPLE_BUCKET:
+                if (time >= nextDue[c]){
+                    write = true;
+                    while (nextDue[c] <= time){
+                        nextDue[c] += policy.interval;
+                    }
+                }
+                break;
+            case SAMPLE_ON_CHANGE:
+                if (fabs(row[c] - lastWritten[c]) > policy.deadband){
+                    write = true;
+                    changed = true;
+                } else if (policy.interval > 0 && time - lastWrittenTime >= policy.interval){
+                    write = true;
+                }
+                break;
+        }
+    }
+
+    int written = 0;
+    if (write && changed && !previousWritten){
+        emit(previous.data(), out); //End of the stretch the change interrupts
+        written++;
+    }
+    accumulate(row);
+    if (write){
+        emit(row, out);
+        written++;
+    }
+    previous.assign(row, row + count);
+    previousWritten = write;
+    return written;
+}
+
+int TelemetrySampler::flush(vector<float> &out){
+    if (!started || previousWritten){
+        return 0;
+    }
+    emit(previous.data(), out);
+    previousWritten = true;
+    return 1;
+}
+
+long long TelemetrySampler::get_rowsIn() const{
+    return rowsIn;
+}
+
+long long TelemetrySampler::get_rowsOut() const{
+    return rowsOut;
+}
+
+vector<size_t> largestTriangleThreeBuckets(const vector<float> &x, const vector<float> &y, size_t points){
+    size_t count = x.size() < y.size() ? x.size() : y.size();
+    vector<size_t> picked;
+    if (points >= count || points < 3){
+        for (size_t i = 0; i < count; i++){
+            picked.push_back(i);
+        }
+        return picked;
+    }
+
+    //The points between the first and the last go into points - 2 buckets of (nearly) equal size
+    double bucketSize = static_cast<double>(count - 2) / (points - 2);
+    size_t a = 0; //Point picked in the previous bucket
+    picked.push_back(0);
+    for (size_t b = 0; b < points - 2; b++){
+        size_t start = static_cast<size_t>(b * bucketSize) + 1;
+        size_t end = static_cast<size_t>((b + 1) * bucketSize) + 1;
+
+        //Mean of the next bucket (the last point for the last bucket)
+        size_t nextStart = end;
+        size_t nextEnd = b + 2 < points - 1 ? static_cast<size_t>((b + 2) * bucketSize) + 1 : count;
+        if (nextEnd > count) nextEnd = count;
+        double meanX = 0, meanY = 0;
+        for (size_t i = nextStart; i < nextEnd; i++){
+            meanX += x[i];
+            meanY += y[i];
+        }
+        size_t nextCount = nextEnd - nextStart;
+        meanX /= nextCount;
+        meanY /= nextCount;
+
+        //Point of this bucket spanning the largest triangle with a and the next bucket's mean
+        double largest = -1;
+        size_t best = start;
+        for (size_t i = start; i < end; i++){
+            double area = fabs((x[a] - meanX) * (y[i] - y[a]) - (x[a] - x[i]) * (meanY - y[a]));
+            if (area > largest){
+                largest = area;
+                best = i;
+            }
+        }
+        picked.push_back(best);
+        a = best;
+    }
+    picked.push_back(count - 1);
+    return picked;
+}
+
+//@brief read every column of a CSV log or a binary .evtl log
+bool loadLogColumns(const string &path, vector<string> &names, vector<vector<float>> &columns){
+    names.clear();
+    columns.clear();
+    if (!isCsvPath(path)){
+        TelemetryReader reader;
+        if (!reader.open(path)){
+            cout << "Cannot read telemetry file " << path << "\n";
+            return false;
+        }
+        for (const TelemetryChannel &channel : reader.get_channels()){
+            names.push_back(channel.name);
+        }
+        columns.assign(names.size(), vector<float>());
+        vector<vector<float>> block;
+        while (reader.readBlock(block)){
+            for (size_t c = 0; c < block.size() && c < columns.size(); c++){
+                columns[c].insert(columns[c].end(), block[c].begin(), block[c].end());
+            }
+        }
+        if (reader.is_damaged()){
+            cout << "Warning: telemetry file " << path << " is damaged or cut off; only the rows before the damage are used\n";
+        }
+        return true;
+    }
+
+    ifstream file(path);
+    if (!file.is_open()){
+        cout << "Cannot open file " << path << "\n";
+        return false;
+    }
+    string line;
+    if (!getline(file, line)){
+        cout << "Empty log " << path << "\n";
+        return false;
+    }
+    stringstream header(line);
+    string name;
+    while (getline(header, name, ',')){
+        if (!name.empty() && name.back() == '\r'){
+            name.pop_back();
+        }
+        names.push_back(name);
+    }
+    columns.assign(names.size(), vector<float>());
+    vector<float> row(names.size());
+    while (getline(file, line)){
+        const char* p = line.c_str();
+        size_t c = 0;
+        for (; c < names.size(); c++){
+            char* end;
+            row[c] = strtof(p, &end);
+            if (end == p){
+                break;
+            }
+            p = *end == ',' ? end + 1 : end;
+        }
+        if (c == names.size()){ //Rows that do not parse are skipped
+            for (size_t i = 0; i < c; i++){
+                columns[i].push_back(row[i]);
+            }
+        }
+    }
+    return true;
+}
+
+bool decimateLog(const string &path, const string &csvPath, size_t points){
+    vector<string> names;
+    vector<vector<float>> columns;
+    if (!loadLogColumns(path, names, columns)){
+        return false;
+    }
+    size_t rows = columns.empty() ? 0 : columns[0].size();
+    vector<bool> keep(rows, false);
+    for (size_t c = 1; c < columns.size(); c++){
+        for (size_t i : largestTriangleThreeBuckets(columns[0], columns[c], points)){
+            keep[i] = true;
+        }
+    }
+
+    ofstream csv(csvPath);
+    if (!csv.is_open()){
+        cout << "Cannot open file " << csvPath << "\n";
+        return false;
+    }
+    for (size_t c = 0; c < names.size(); c++){
+        csv << (c > 0 ? "," : "") << names[c];
+    }
+    csv << "\n";
+    size_t kept = 0;
+    for (size_t r = 0; r < rows; r++){
+        if (!keep[r]){
+            continue;
+        }
+        for (size_t c = 0; c < columns.size(); c++){
+            csv << (c > 0 ? "," : "") << columns[c][r];
+        }
+        csv << "\n";
+        kept++;
+    }
+    cout << "Decimated " << rows << " rows to " << kept << " (" << points << " points per channel)\n";
+    return true;
+}
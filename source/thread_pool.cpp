@@ -0,0 +1,125 @@
+#include "../headers/thread_pool.h"
+using namespace std;
+
+//@brief start the pool
+//@param threads - total number of threads including the caller of run() (at least 1)
+ThreadPool::ThreadPool(int threads){
+    if (threads < 1){
+        threads = 1;
+    }
+    generation = 0;
+    stopping = false;
+    remaining = 0;
+    steals = 0;
+    for (int i = 0; i < threads; i++){
+        queues.push_back(unique_ptr<TaskQueue>(new TaskQueue()));
+    }
+    for (int i = 1; i < threads; i++){
+        workers.push_back(thread(&ThreadPool::workerMain, this, i));
+    }
+}
+
+//@brief stop and join all worker threads
+ThreadPool::~ThreadPool(){
+    {
+        lock_guard<mutex> guard(stateLock);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (thread &worker : workers){
+        worker.join();
+    }
+}
+
+int ThreadPool::size() const{
+    return static_cast<int>(queues.size());
+}
+
+long long ThreadPool::get_steals() const{
+    return steals;
+}
+
+//@brief take the next task: first from the front of our own queue, otherwise from the back of another one
+//@return false if every queue is empty
+bool ThreadPool::popTask(int thread, int &task){
+    {
+        TaskQueue &own = *queues[thread];
+        lock_guard<mutex> guard(own.lock);
+        if (!own.tasks.empty()){
+            task = own.tasks.front();
+            own.tasks.pop_front();
+            return true;
+        }
+    }
+    int count = size();
+    for (int offset = 1; offset < count; offset++){
+        TaskQueue &victim = *queues[(thread + offset) % count];
+        lock_guard<mutex> guard(victim.lock);
+        if (!victim.tasks.empty()){
+            task = victim.tasks.back();
+            victim.tasks.pop_back();
+            steals++;
+            return true;
+        }
+    }
+    return false;
+}
+
+//@brief run tasks until none are left
+void ThreadPool::workLoop(int thread){
+    int task;
+    while (popTask(thread, task)){
+        job(task);
+        if (remaining.fetch_sub(1) == 1){ //Last task of the run
+            lock_guard<mutex> guard(stateLock);
+            done.notify_all();
+        }
+    }
+}
+
+//@brief body of the worker threads: wait for a run, help with it, repeat
+void ThreadPool::workerMain(int thread){
+    int seen = 0;
+    while (true){
+        {
+            unique_lock<mutex> guard(stateLock);
+            wake.wait(guard, [&]{ return stopping || generation != seen; });
+            if (stopping){
+                return;
+            }
+            seen = generation;
+        }
+        workLoop(thread);
+    }
+}
+
+//@brief run task(0) ... task(taskCount - 1) on the pool and wait until all of them have finished
+void ThreadPool::run(int taskCount, const function<void(int)> &task){
+    if (taskCount <= 0){
+        return;
+    }
+    //No task of the previous run is left at this point, so nobody is reading job
+    job = task;
+    remaining = taskCount;
+
+    //Deal out contiguous blocks of tasks so neighbouring tasks usually run on the same thread
+    int count = size();
+    for (int t = 0; t < count; t++){
+        int begin = static_cast<long long>(taskCount) * t / count;
+        int end = static_cast<long long>(taskCount) * (t + 1) / count;
+        lock_guard<mutex> guard(queues[t]->lock);
+        for (int i = begin; i < end; i++){
+            queues[t]->tasks.push_back(i);
+        }
+    }
+    {
+        lock_guard<mutex> guard(stateLock);
+        generation++;
+    }
+    wake.notify_all();
+
+    workLoop(0);
+
+    unique_lock<mutex> guard(stateLock);
+    done.wait(guard, [&]{ return remaining.load() == 0; });
+}
@@ -1,9 +1,22 @@
 #include "../headers/vehicle.h"
 #include "../headers/components.h"
+#include "../headers/snapshot.h"
+#include <cmath>
+
+const float GRAVITY = 9.81; //m/s^2
+const float AIR_DENSITY = 1.2; //kg/m^3
+const float ROLLING_RESISTANCE = 0.01; //Rolling resistance coefficient of the tyres
 
 EV::EV(){
     wheelRadius = 0.5;
     this->on = true;
+    //Only used for road loads (route estimates), 0 leaves the window model without them
+    mass = 0;
+    dragCoefficient = 0;
+    frontalArea = 0;
+    battery = nullptr;
+    motor = nullptr;
+    obstacle = false;
 }
 
 //constructor that checks if user chose their own parameters or if they chose default value
@@ -14,14 +27,20 @@ EV::EV(float wheelRadius){
         this->wheelRadius = wheelRadius;
     }
     this->on = true;
+    mass = 0;
+    dragCoefficient = 0;
+    frontalArea = 0;
+    battery = nullptr;
+    motor = nullptr;
+    obstacle = false;
 }
 
 float EV::get_wheelRadius(){
     return wheelRadius;
 }
 
-EV::EV(const EV& other) : wheelRadius(other.wheelRadius) {
-    on = true;
+EV::EV(const EV& other){
+    *this = other;
 }
 
 void EV::update(float speed, float delta_t) {
@@ -30,14 +49,20 @@ void EV::update(float speed, float delta_t) {
 
 EV& EV::operator=(const EV& other){
     if (this != &other){
-    wheelRadius = other.wheelRadius;
-    this->on = other.on;
+        wheelRadius = other.wheelRadius;
+        this->on = other.on;
+        mass = other.mass;
+        dragCoefficient = other.dragCoefficient;
+        frontalArea = other.frontalArea;
+        battery = other.battery;
+        motor = other.motor;
+        obstacle = other.obstacle;
     }
     return *this;
 }
 
 //setters
-//these could be more useful in the future, but right now we decided not to use them
+//mass, drag coefficient and frontal area are used by roadLoadForce (route estimates); the window model ignores them
 void EV::powerOn() { on = true; }
 void EV::powerOff() { on = false; }
 void EV::setMass(float m) { mass = m; }
@@ -46,4 +71,43 @@ void EV::setDragCoefficient(float c) { dragCoefficient = c; }
 void EV::setFrontalArea(float a) { frontalArea = a; }
 
 
-bool EV::getOn() { return on; }
\ No newline at end of file
+bool EV::getOn() { return on; }
+float EV::get_mass() { return mass; }
+
+//@param speed - vehicle speed (m/s), grade - rise over run of the road (positive uphill)
+float EV::roadLoadForce(float speed, float grade){
+    float angle = atan(grade);
+    float climbing = mass * GRAVITY * sin(angle);
+    float rolling = speed > 0 ? ROLLING_RESISTANCE * mass * GRAVITY * cos(angle) : 0;
+    float drag = 0.5f * AIR_DENSITY * dragCoefficient * frontalArea * speed * speed;
+    return climbing + rolling + drag;
+}
+
+//@brief write every field to a snapshot section
+void EV::saveState(StateWriter &out){
+    out.beginSection("EVBD");
+    out.putBool(on);
+    out.putFloat(mass);
+    out.putFloat(dragCoefficient);
+    out.putFloat(frontalArea);
+    out.putBool(obstacle);
+    out.putFloat(wheelRadius);
+    out.endSection();
+}
+
+//@brief read the fields back from a snapshot section
+//@return false if the section is too short (the object is then left unchanged)
+bool EV::loadState(StateReader in){
+    EV loaded(*this);
+    loaded.on = in.getBool();
+    loaded.mass = in.getFloat();
+    loaded.dragCoefficient = in.getFloat();
+    loaded.frontalArea = in.getFloat();
+    loaded.obstacle = in.getBool();
+    loaded.wheelRadius = in.getFloat();
+    if (!in.is_ok()){
+        return false;
+    }
+    *this = loaded;
+    return true;
+}
@@ -0,0 +1,66 @@
+#include <iostream>
+#include <chrono>
+#include "../headers/vehicle_model.h"
+#include "../headers/simulation.h"
+using namespace std;
+
+//@brief run Simulation and StaticSimulation<Spec> side by side with the scripted driver and compare every step
+//@param name - printed label, sim - runtime simulation built with the same parameters as Spec
+//@return number of steps where speed, SOC or temperature differ
+template <class Spec>
+long long compareWithRuntime(const char* name, Simulation &sim, long long steps, float dt){
+    StaticSimulation<Spec> model(sim.get_ambientTemp());
+    bool charging = false, modelCharging = false;
+    long long mismatches = 0;
+    for (long long i = 0; i < steps; i++){
+        scriptedDriver(sim.get_time(), sim.get_battery(), sim.get_input(), charging);
+        scriptedDriver(model.get_time(), model.get_battery().get_SOC(), model.get_input(), modelCharging);
+        sim.step(dt, charging);
+        model.step(dt, modelCharging);
+        if (sim.get_speed() != model.get_speed() || sim.get_battery().get_SOC() != model.get_battery().get_SOC() ||
+            sim.get_battery().get_temp() != model.get_battery().get_temp()){
+            mismatches++;
+        }
+    }
+
+    //Time both on the same drive
+    auto start = chrono::steady_clock::now();
+    Simulation timedSim(sim);
+    for (long long i = 0; i < steps; i++){
+        scriptedDriver(timedSim.get_time(), timedSim.get_battery(), timedSim.get_input(), charging);
+        timedSim.step(dt, charging);
+    }
+    double runtimeSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    start = chrono::steady_clock::now();
+    StaticSimulation<Spec> timedModel(model);
+    for (long long i = 0; i < steps; i++){
+        scriptedDriver(timedModel.get_time(), timedModel.get_battery().get_SOC(), timedModel.get_input(), modelCharging);
+        timedModel.step(dt, modelCharging);
+    }
+    double staticSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    if (timedSim.get_battery().get_SOC() != timedModel.get_battery().get_SOC() || timedSim.get_speed() != timedModel.get_speed()){
+        mismatches++;
+    }
+
+    cout << "  " << name << ": " << mismatches << " of " << steps << " steps differ, final SOC " << model.get_battery().get_SOC()
+         << "%, " << runtimeSeconds * 1e9 / steps << " ns/step runtime, " << staticSeconds * 1e9 / steps
+         << " ns/step static\n";
+    return mismatches;
+}
+
+int runStaticModelCheck(){
+    const float dt = 0.016;
+    const long long steps = 225000; //One hour
+
+    cout << "Static vehicle models against the runtime classes (one hour of the scripted driver, dt " << dt << " s):\n";
+    Simulation defaultSim(25);
+    long long mismatches = compareWithRuntime<DefaultVehicleSpec>("DefaultVehicleSpec", defaultSim, steps, dt);
+
+    Simulation citySim(25);
+    citySim.configure(Motor(CityVehicleSpec::maxTorque, CityVehicleSpec::maxSpeed),
+                      Battery(CityVehicleSpec::Q_max, CityVehicleSpec::V_max, CityVehicleSpec::R_internal, CityVehicleSpec::batteryHeatCapacity),
+                      EV(CityVehicleSpec::wheelRadius));
+    mismatches += compareWithRuntime<CityVehicleSpec>("CityVehicleSpec", citySim, steps, dt);
+
+    return mismatches == 0 ? 0 : 1;
+}